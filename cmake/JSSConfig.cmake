@@ -240,4 +240,7 @@ macro(jss_config_java)
     set(JSS_BASE_PORT 2876)
     math(EXPR JSS_TEST_PORT_CLIENTAUTH ${JSS_BASE_PORT}+0)
     math(EXPR JSS_TEST_PORT_CLIENTAUTH_FIPS ${JSS_BASE_PORT}+1)
+    math(EXPR JSS_TEST_PORT_ASYNC_HANDSHAKE ${JSS_BASE_PORT}+2)
+    math(EXPR JSS_TEST_PORT_BENCHMARK ${JSS_BASE_PORT}+3)
+    math(EXPR JSS_TEST_PORT_READ_BUFFER ${JSS_BASE_PORT}+4)
 endmacro()
@@ -22,6 +22,10 @@ macro(jss_tests)
         NAME "JSS_Test_Empty_DER_Value"
         COMMAND "org.mozilla.jss.tests.EmptyDerValue"
     )
+    jss_test_java(
+        NAME "JSS_Test_ASN1_Encoding"
+        COMMAND "org.mozilla.jss.tests.ASN1EncodingTest"
+    )
     if ((${Java_VERSION_MAJOR} EQUAL 1) AND (${Java_VERSION_MINOR} LESS 9))
         jss_test_java(
             NAME "Test_PKCS11Constants.java_for_Sun_compatibility"
@@ -101,6 +105,26 @@ macro(jss_tests)
         COMMAND "org.mozilla.jss.tests.SSLClientAuth" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}" "${JSS_TEST_PORT_CLIENTAUTH}" "50"
         DEPENDS "List_CA_certs"
     )
+    jss_test_java(
+        NAME "SSLAsyncHandshake"
+        COMMAND "org.mozilla.jss.tests.SSLAsyncHandshake" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}" "${JSS_TEST_PORT_ASYNC_HANDSHAKE}" "Server_RSA" "Client_RSA"
+        DEPENDS "List_CA_certs"
+    )
+    jss_test_java(
+        NAME "SSLReadBuffer"
+        COMMAND "org.mozilla.jss.tests.SSLReadBuffer" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}" "${JSS_TEST_PORT_READ_BUFFER}" "Server_RSA"
+        DEPENDS "List_CA_certs"
+    )
+    jss_test_java(
+        NAME "JSSEngine"
+        COMMAND "org.mozilla.jss.tests.JSSEngineTest" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}" "Server_RSA"
+        DEPENDS "List_CA_certs"
+    )
+    jss_test_java(
+        NAME "JSS_Test_X509_CRL"
+        COMMAND "org.mozilla.jss.tests.X509CRLTest" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}"
+        DEPENDS "Setup_DBs"
+    )
     jss_test_java(
         NAME "Key_Generation"
         COMMAND "org.mozilla.jss.tests.TestKeyGen" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}"
@@ -223,6 +247,14 @@ macro(jss_tests)
       check
       DEPENDS test
     )
+
+    # Benchmarks for comparing builds. They are kept out of the test suite,
+    # but use its NSS database, so run the tests first.
+    add_custom_target(
+      benchmark
+      COMMAND "${CMAKE_COMMAND}" -E env "LD_LIBRARY_PATH=${CMAKE_BINARY_DIR}" "${Java_JAVA_EXECUTABLE}" -classpath "${TEST_CLASSPATH}" "org.mozilla.jss.tests.JSSBenchmark" "${RESULTS_OUTPUT_DIR}" "${PASSWORD_FILE}" "${JSS_TEST_PORT_BENCHMARK}" "2000"
+      DEPENDS generate_jar generate_so
+    )
 endmacro()
 
 function(jss_test_java)
@@ -22,6 +22,7 @@
 #include <jssver.h>
 
 #include "pk11util.h"
+#include <jss_ids.h>
 
 #if defined(AIX) || defined(HPUX)
 #include <signal.h>
@@ -230,6 +231,28 @@ static jobject globalPasswordCallback = NULL;
  */
 JavaVM * JSS_javaVM;
 
+/**********************************************************************
+ * Called by the VM when the JSS library is loaded. Saves the VM pointer
+ * and fills in the JSS_ids table, so that native methods and NSPR and
+ * NSS callbacks don't have to look up JNI IDs on every call.
+ */
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void *reserved)
+{
+    JNIEnv *env;
+
+    if( (*vm)->GetEnv(vm, (void**)&env, JNI_VERSION_1_2) != JNI_OK ) {
+        return JNI_ERR;
+    }
+    JSS_javaVM = vm;
+
+    if( JSS_initIDs(env) != PR_SUCCESS ) {
+        return JNI_ERR;
+    }
+
+    return JNI_VERSION_1_2;
+}
+
 JNIEXPORT void JNICALL
 Java_org_mozilla_jss_CryptoManager_initializeAllNative
     (JNIEnv *env, jclass clazz,
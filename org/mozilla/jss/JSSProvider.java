@@ -121,6 +121,10 @@ public final class JSSProvider extends java.security.Provider {
         /////////////////////////////////////////////////////////////
         put("SecureRandom.pkcs11prng",
             "org.mozilla.jss.provider.java.security.JSSSecureRandomSpi");
+        put("SecureRandom.pkcs11prng ThreadSafe", "true");
+        put("SecureRandom.pkcs11prng-pooled",
+            "org.mozilla.jss.provider.java.security.JSSSecureRandomSpi$Pooled");
+        put("SecureRandom.pkcs11prng-pooled ThreadSafe", "true");
 
         /////////////////////////////////////////////////////////////
         // KeyPairGenerator
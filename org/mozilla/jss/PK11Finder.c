@@ -18,6 +18,7 @@
 #include <jss_exceptions.h>
 #include "pk11util.h"
 #include <java_ids.h>
+#include <jss_ids.h>
 
 /*
  * This is a semi-private NSS function, exposed only for JSS.
@@ -116,10 +117,7 @@ Java_org_mozilla_jss_CryptoManager_findCertsByNicknameNative
     PR_ASSERT(count >= 0);
 
     /* create the cert array */
-    certClass = (*env)->FindClass(env, X509_CERT_CLASS);
-    if( certClass == NULL ) {
-        goto finish;
-    }
+    certClass = JSS_CLASS(X509Certificate);
     certArray = (*env)->NewObjectArray(env, count, certClass, NULL);
     if( certArray == NULL ) {
         /* exception was thrown */
@@ -359,11 +357,7 @@ cert_chain_from_cert(JNIEnv *env, CERTCertDBHandle *handle,
     /*
      * Turn the cert chain into a Java array of certificates
      */
-    certClass = (*env)->FindClass(env, CERT_CLASS_NAME);
-    if(certClass==NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
+    certClass = JSS_CLASS(PK11Cert);
     certArray = (*env)->NewObjectArray(env, len, certClass, (jobject)NULL);
     if(certArray==NULL) {
         ASSERT_OUTOFMEM(env);
@@ -1207,11 +1201,7 @@ Java_org_mozilla_jss_CryptoManager_exportCertsToPKCS7
     /*
      * JNI ID lookup
      */
-    certClass = (*env)->FindClass(env, CERT_CLASS_NAME);
-    if(certClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
+    certClass = JSS_CLASS(PK11Cert);
 
     /***************************************************
      * Add each cert to the PKCS #7 context.  Create the context
@@ -1382,11 +1372,7 @@ getCerts(JNIEnv *env, PK11CertListType type)
     /**************************************************
      * Create array of Java certificates
      **************************************************/
-    certClass = (*env)->FindClass(env, X509_CERT_CLASS);
-    if(certClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
+    certClass = JSS_CLASS(X509Certificate);
 
     certArray = (*env)->NewObjectArray( env,
                                         numCerts,
@@ -8,6 +8,8 @@ import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 
 import org.mozilla.jss.util.Assert;
 
@@ -24,7 +26,14 @@ import org.mozilla.jss.util.Assert;
  */
 public class ANY implements ASN1Value {
 
-    // The complete encoding of header + contents
+    // The complete encoding of header + contents is
+    // buf[offset..offset+length). Unless this value is a view into a
+    // decoding buffer, buf is the whole array and encoded is the same
+    // array; for a view, encoded is copied out when first asked for.
+    private final byte[] buf;
+    private final int offset;
+    private final int length;
+    private final boolean view;
     private byte[] encoded;
     private Tag tag;
 
@@ -38,10 +47,22 @@ public class ANY implements ASN1Value {
      *      tag, form, length, and contents.
      */
     public ANY(Tag tag, byte[] encoded) {
+        this.buf = encoded;
+        this.offset = 0;
+        this.length = encoded.length;
+        this.view = false;
         this.encoded = encoded;
         this.tag = tag;
     }
 
+    ANY(Tag tag, byte[] buf, int offset, int length) {
+        this.buf = buf;
+        this.offset = offset;
+        this.length = length;
+        this.view = true;
+        this.tag = tag;
+    }
+
     /**
      * Creates an ANY value, which is just a generic ASN.1 value.
      * @param encoded The complete BER encoding of this value, including
@@ -50,6 +71,10 @@ public class ANY implements ASN1Value {
      */
     public ANY(byte[] encoded) throws InvalidBERException {
       try {
+        this.buf = encoded;
+        this.offset = 0;
+        this.length = encoded.length;
+        this.view = false;
         this.encoded = encoded;
 
         ByteArrayInputStream bis = new ByteArrayInputStream(encoded);
@@ -61,6 +86,15 @@ public class ANY implements ASN1Value {
       }
     }
 
+    // Returns a stream over the encoding. For a view this is a
+    // SliceInputStream, so values decoded from it are views as well.
+    private ByteArrayInputStream openEncoding() {
+        if( view ) {
+            return new SliceInputStream(buf, offset, length);
+        }
+        return new ByteArrayInputStream(buf, offset, length);
+    }
+
     /**
      * Returns the tag of this value.
      */
@@ -75,9 +109,22 @@ public class ANY implements ASN1Value {
      * @return Encoded header and contents.
      */
     public byte[] getEncoded() {
+        if( encoded == null ) {
+            encoded = Arrays.copyOfRange(buf, offset, offset + length);
+        }
         return encoded;
     }
 
+    /**
+     * Returns the complete encoding of header and contents as a read-only
+     * buffer, without copying it.
+     *
+     * @return Encoded header and contents.
+     */
+    public ByteBuffer getEncodedBuffer() {
+        return ByteBuffer.wrap(buf, offset, length).slice().asReadOnlyBuffer();
+    }
+
     /**
      * Returns the ASN.1 header from the encoding.
      *
@@ -87,7 +134,7 @@ public class ANY implements ASN1Value {
      */
     public ASN1Header getHeader() throws InvalidBERException, IOException {
         if( header == null ) {
-            ByteArrayInputStream bis = new ByteArrayInputStream(encoded);
+            ByteArrayInputStream bis = openEncoding();
             header = new ASN1Header(bis);
         }
         return header;
@@ -102,7 +149,7 @@ public class ANY implements ASN1Value {
     public byte[] getContents() throws InvalidBERException {
       try {
         if( contents==null ) {
-            ByteArrayInputStream bis = new ByteArrayInputStream(encoded);
+            ByteArrayInputStream bis = openEncoding();
             header = new ASN1Header(bis);
             contents = new byte[ bis.available() ];
             if( (contents.length != header.getContentLength()) &&
@@ -121,7 +168,7 @@ public class ANY implements ASN1Value {
     }
 
     public void encode(OutputStream ostream) throws IOException {
-        ostream.write(encoded);
+        ostream.write(buf, offset, length);
     }
 
     /**
@@ -138,7 +185,7 @@ public class ANY implements ASN1Value {
         throws InvalidBERException
     {
       try {
-        ByteArrayInputStream bis = new ByteArrayInputStream(encoded);
+        ByteArrayInputStream bis = openEncoding();
         return template.decode(bis);
       } catch( IOException e ) {
           throw new RuntimeException("Unable to read byte array: " + e.getMessage(), e);
@@ -160,7 +207,7 @@ public class ANY implements ASN1Value {
     public ASN1Value decodeWith(Tag implicitTag, ASN1Template template)
         throws IOException, InvalidBERException
     {
-        ByteArrayInputStream bis = new ByteArrayInputStream(encoded);
+        ByteArrayInputStream bis = openEncoding();
         return template.decode(implicitTag, bis);
     }
 
@@ -175,7 +222,18 @@ public class ANY implements ASN1Value {
         if( ! implicitTag.equals(tag) ) {
             throw new RuntimeException("No implicit tags allowed for ANY");
         }
-        ostream.write(encoded);
+        ostream.write(buf, offset, length);
+    }
+
+    /**
+     * @param implicitTag <b>This parameter is ignored</b>, because
+     * ANY values cannot have implicit tags.
+     */
+    public long getEncodedLength(Tag implicitTag) {
+        if( ! implicitTag.equals(tag) ) {
+            throw new RuntimeException("No implicit tags allowed for ANY");
+        }
+        return length;
     }
 
     /**
@@ -251,7 +309,15 @@ public static class Template implements ASN1Template {
 
         } else {
             // definite length encoding
-            byte[] data = new byte[ (int) head.getTotalLength() ];
+            int length = (int) head.getTotalLength();
+            SliceInputStream source = SliceInputStream.getSource(istream);
+            if( source != null ) {
+                int offset = source.take(istream, length);
+                return new ANY(head.getTag(), source.getBuffer(), offset,
+                    length);
+            }
+
+            byte[] data = new byte[length];
 
             ASN1Util.readFully(data, istream);
             return new ANY(head.getTag(), data);
@@ -251,6 +251,33 @@ public class ASN1Header {
         this.contentLength = contentLength;
     }
 
+    /**
+     * Returns the number of bytes in the DER encoding of a header with
+     * the given tag and content length, without encoding it.
+     *
+     * @param tag Tag.
+     * @param contentLength Must be &ge;0.
+     * @return Header length.
+     */
+    public static int getEncodedLength(Tag tag, long contentLength) {
+        Assert._assert(contentLength >= 0);
+
+        // identifier octet, plus 7 bits per octet for a long-form tag
+        int length = 1;
+        long tagNum = tag.getNum();
+        if( tagNum > 30 ) {
+            length += (64 - Long.numberOfLeadingZeros(tagNum) + 6) / 7;
+        }
+
+        // length octet, plus the minimal big-endian length for long form
+        length++;
+        if( contentLength > 127 ) {
+            length += (64 - Long.numberOfLeadingZeros(contentLength) + 7) / 8;
+        }
+
+        return length;
+    }
+
     public void encode( OutputStream ostream )
         throws IOException
     {
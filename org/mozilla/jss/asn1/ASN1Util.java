@@ -8,6 +8,7 @@ import java.io.ByteArrayOutputStream;
 import java.io.EOFException;
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
 import java.util.Arrays;
 
 public class ASN1Util {
@@ -42,6 +43,46 @@ public class ASN1Util {
       }
     }
 
+    /**
+     * Decodes a value from the remaining bytes of a buffer and advances
+     * the buffer's position past it. <code>OCTET_STRING</code>,
+     * <code>BIT_STRING</code> and <code>ANY</code> values in the result
+     * refer to the buffer's backing array instead of copying from it, as
+     * described for <code>SliceInputStream</code>. A buffer without an
+     * accessible array is copied once first.
+     *
+     * @param template Template to decode with.
+     * @param buffer Buffer holding the encoding.
+     * @return Decoded value.
+     * @throws InvalidBERException If there is an invalid BER encoding.
+     */
+    public static ASN1Value decode(ASN1Template template, ByteBuffer buffer)
+        throws InvalidBERException
+    {
+      try {
+
+        byte[] array;
+        int offset;
+        int length = buffer.remaining();
+        if( buffer.hasArray() ) {
+            array = buffer.array();
+            offset = buffer.arrayOffset() + buffer.position();
+        } else {
+            array = new byte[length];
+            buffer.duplicate().get(array);
+            offset = 0;
+        }
+
+        SliceInputStream sis = new SliceInputStream(array, offset, length);
+        ASN1Value value = template.decode(sis);
+        buffer.position(buffer.position() + sis.getPosition() - offset);
+        return value;
+
+      } catch( IOException e ) {
+        throw (InvalidBERException) new InvalidBERException("Unable to decode byte buffer: " + e.getMessage()).initCause(e);
+      }
+    }
+
     public static ASN1Value decode(Tag implicitTag, ASN1Template template,
                             byte[] encoded)
         throws InvalidBERException
@@ -40,4 +40,35 @@ public interface ASN1Value {
      */
     public void encode(Tag implicitTag, OutputStream ostream)
         throws IOException;
+
+    /**
+     * Returns the length of this value's DER encoding using its own
+     * base tag, without keeping the encoding.
+     *
+     * @return Encoded length in bytes.
+     * @throws IOException If an error occurred.
+     */
+    public default long getEncodedLength() throws IOException {
+        return getEncodedLength(getTag());
+    }
+
+    /**
+     * Returns the length of this value's DER encoding using an implicit
+     * tag, without keeping the encoding. Constructed types use this to
+     * write their header before their contents, so the contents can be
+     * written straight to the output stream instead of being buffered.
+     *
+     * <p>The default implementation encodes the value to a stream that
+     * only counts bytes, and remembers the result until the enclosing
+     * encoding is finished, so the value is not measured again by each
+     * level above it. Types whose length is known without encoding
+     * override it.
+     *
+     * @param implicitTag Implicit tag.
+     * @return Encoded length in bytes.
+     * @throws IOException If an error occurred.
+     */
+    public default long getEncodedLength(Tag implicitTag) throws IOException {
+        return EncodedLengthCache.measure(this, implicitTag);
+    }
 }
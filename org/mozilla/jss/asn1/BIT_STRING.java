@@ -7,6 +7,8 @@ import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 import java.util.BitSet;
 
 import org.mozilla.jss.util.Assert;
@@ -20,6 +22,13 @@ public class BIT_STRING implements ASN1Value {
 
     private byte[] bits;
     private int padCount;
+
+    // For a view into a decoding buffer, the bits are
+    // source[offset..offset+length) and are copied into bits when first
+    // needed.
+    private byte[] source;
+    private int offset;
+    private int length;
     private boolean removeTrailingZeroes = false;
 
     /**
@@ -46,6 +55,13 @@ public class BIT_STRING implements ASN1Value {
         this.padCount = padCount;
     }
 
+    BIT_STRING(byte[] source, int offset, int length, int padCount) {
+        this.source = source;
+        this.offset = offset;
+        this.length = length;
+        this.padCount = padCount;
+    }
+
     /**
      * Constructs a BIT_STRING from a BitSet.
      * @param bs A BitSet.
@@ -107,9 +123,26 @@ public class BIT_STRING implements ASN1Value {
      * @return BIT STRING as byte array.
      */
     public byte[] getBits() {
+        if( bits == null ) {
+            bits = Arrays.copyOfRange(source, offset, offset + length);
+        }
         return bits;
     }
 
+    /**
+     * Returns the bits packed into a read-only buffer, with padding at
+     * the end, without copying them.
+     *
+     * @return BIT STRING as a byte buffer.
+     */
+    public ByteBuffer toByteBuffer() {
+        if( bits == null ) {
+            return ByteBuffer.wrap(source, offset, length).slice()
+                .asReadOnlyBuffer();
+        }
+        return ByteBuffer.wrap(bits).asReadOnlyBuffer();
+    }
+
     /**
      * Copies this BIT STRING into a Java BitSet.  Note that BitSet.size()
      * will not accurately reflect the number of bits in the BIT STRING,
@@ -118,6 +151,7 @@ public class BIT_STRING implements ASN1Value {
      * @return BIT STRING as BitSet.
      */
     public BitSet toBitSet() {
+        byte[] bits = getBits();
         BitSet bs = new BitSet();
         int numBits = (bits.length * 8) - padCount;
         for( int i=0; i < numBits; i++) {
@@ -137,6 +171,7 @@ public class BIT_STRING implements ASN1Value {
      * @return BIT STRING as boolean array.
      */
     public boolean[] toBooleanArray() {
+        byte[] bits = getBits();
         boolean[] array = new boolean[(bits.length*8) - padCount];
         // all elements are set to false by default
 
@@ -171,6 +206,8 @@ public class BIT_STRING implements ASN1Value {
     public void encode(Tag implicitTag, OutputStream ostream)
         throws IOException
     {
+        byte[] bits = getBits();
+
         // force all unused bits to be zero, in support of DER standard.
         if( bits.length > 0 ) {
             bits[bits.length-1] &= (0xff << padCount);
@@ -277,7 +314,20 @@ public static class Template implements ASN1Template {
         }
 
         // get the rest of the octets
-        byte[] bits = new byte[ (int) head.getContentLength() - 1];
+        int length = (int) head.getContentLength() - 1;
+        SliceInputStream source = SliceInputStream.getSource(istream);
+        if( source != null ) {
+            // a view skips the constructor's check, so make it here
+            if( length == 0 && padCount != 0 ) {
+                throw new InvalidBERException(
+                    "Unused bits in an empty BIT STRING");
+            }
+            int offset = source.take(istream, length);
+            return new BIT_STRING(source.getBuffer(), offset, length,
+                padCount);
+        }
+
+        byte[] bits = new byte[length];
         ASN1Util.readFully(bits, istream);
 
         return new BIT_STRING(bits, padCount);
@@ -38,6 +38,10 @@ public class BOOLEAN implements ASN1Value {
         }
     }
 
+    public long getEncodedLength(Tag implicitTag) {
+        return ASN1Header.getEncodedLength(implicitTag, 1) + 1;
+    }
+
     private boolean val;
     /**
      * Creates a <code>BOOLEAN</code> with the given value.
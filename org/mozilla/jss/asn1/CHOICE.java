@@ -84,6 +84,11 @@ public class CHOICE implements ASN1Value {
         val.encode( tag, ostream );
     }
 
+    public long getEncodedLength(Tag implicitTag) throws IOException {
+        Assert._assert(implicitTag.equals(tag));
+        return val.getEncodedLength( tag );
+    }
+
 /**
  * A Template for decoding ASN.1 <code>CHOICE</code>s
  */
@@ -76,6 +76,12 @@ public abstract class CharacterString implements ASN1Value {
         ostream.write( contents );
     }
 
+    public long getEncodedLength(Tag implicitTag) {
+        int contentLength = getEncodedContents().length;
+        return ASN1Header.getEncodedLength(implicitTag, contentLength) +
+            contentLength;
+    }
+
 public abstract static class Template implements ASN1Template {
 
     /**
@@ -0,0 +1,33 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.asn1;
+
+import java.io.OutputStream;
+
+/**
+ * An output stream that discards what is written to it and only counts
+ * the bytes. It is used to find the length of an encoding without
+ * holding on to the encoding itself.
+ */
+class CountingOutputStream extends OutputStream {
+
+    private long count = 0;
+
+    public void write(int b) {
+        count++;
+    }
+
+    public void write(byte[] buffer) {
+        count += buffer.length;
+    }
+
+    public void write(byte[] buffer, int offset, int length) {
+        count += length;
+    }
+
+    public long getCount() {
+        return count;
+    }
+}
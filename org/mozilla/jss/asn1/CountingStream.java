@@ -90,6 +90,10 @@ class CountingStream extends InputStream {
         return source.skip(count);
     }
 
+    InputStream getSource() {
+        return source;
+    }
+
     public int getNumRead() {
         return count;
     }
@@ -3,7 +3,6 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 package org.mozilla.jss.asn1;
 
-import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -61,13 +60,21 @@ public class EXPLICIT implements ASN1Value {
     public void encode(Tag implicitTag, OutputStream ostream)
         throws IOException
     {
-        ByteArrayOutputStream bos = new ByteArrayOutputStream();
-        content.encode(bos);
-        byte[] contentBytes = bos.toByteArray();
-        ASN1Header head = new ASN1Header(implicitTag, FORM,
-            contentBytes.length );
-        head.encode(ostream);
-        ostream.write(contentBytes);
+        EncodedLengthCache pass = EncodedLengthCache.open();
+        try {
+            ASN1Header head = new ASN1Header(implicitTag, FORM,
+                content.getEncodedLength() );
+            head.encode(ostream);
+            content.encode(ostream);
+        } finally {
+            pass.close();
+        }
+    }
+
+    public long getEncodedLength(Tag implicitTag) throws IOException {
+        long contentLength = content.getEncodedLength();
+        return ASN1Header.getEncodedLength(implicitTag, contentLength) +
+            contentLength;
     }
 
     public static Template getTemplate( Tag tag, ASN1Template content) {
@@ -0,0 +1,90 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.asn1;
+
+import java.io.IOException;
+import java.util.IdentityHashMap;
+
+/**
+ * Remembers the lengths of values measured by encoding them, for as long
+ * as an encoding is in progress on the current thread.
+ *
+ * <p>SEQUENCE, SET and EXPLICIT write their header before their contents,
+ * so they ask each element for its length and then encode it. A value
+ * that only knows its length by encoding itself, such as a pkix type
+ * that builds a SEQUENCE in <code>encode</code>, would otherwise be
+ * measured again by every enclosing level, and the work would double
+ * with each level of nesting. Within one pass each such value is
+ * measured once.
+ *
+ * <p>Only values measured through the default
+ * <code>ASN1Value.getEncodedLength</code> are kept, so the cache does not
+ * grow with the number of primitive values being encoded.
+ */
+class EncodedLengthCache {
+
+    private static final ThreadLocal<EncodedLengthCache> current =
+        new ThreadLocal<EncodedLengthCache>();
+
+    private final IdentityHashMap<ASN1Value, Entry> lengths =
+        new IdentityHashMap<ASN1Value, Entry>();
+    private int depth = 0;
+
+    private static class Entry {
+        final Tag tag;
+        final long length;
+
+        Entry(Tag tag, long length) {
+            this.tag = tag;
+            this.length = length;
+        }
+    }
+
+    private EncodedLengthCache() { }
+
+    /**
+     * Starts a pass on this thread, or joins the one in progress. Each
+     * call must be matched by a call to <code>close</code>; the lengths
+     * are forgotten when the outermost pass is closed.
+     */
+    static EncodedLengthCache open() {
+        EncodedLengthCache cache = current.get();
+        if( cache == null ) {
+            cache = new EncodedLengthCache();
+            current.set(cache);
+        }
+        cache.depth++;
+        return cache;
+    }
+
+    void close() {
+        if( --depth == 0 ) {
+            current.remove();
+        }
+    }
+
+    /**
+     * Returns the length of the value's encoding with the given tag,
+     * encoding it to a counting stream unless it has already been
+     * measured in this pass.
+     */
+    static long measure(ASN1Value value, Tag implicitTag)
+        throws IOException
+    {
+        EncodedLengthCache cache = open();
+        try {
+            Entry entry = cache.lengths.get(value);
+            if( entry != null && entry.tag.equals(implicitTag) ) {
+                return entry.length;
+            }
+            CountingOutputStream counter = new CountingOutputStream();
+            value.encode(implicitTag, counter);
+            cache.lengths.put(value, new Entry(implicitTag, counter.getCount()));
+            return counter.getCount();
+        } finally {
+            cache.close();
+        }
+    }
+}
@@ -85,6 +85,12 @@ public class INTEGER extends BigInteger implements ASN1Value {
         return getEncodedContents().length;
     }
 
+    public long getEncodedLength(Tag implicitTag) {
+        long contentLength = getContentLength();
+        return ASN1Header.getEncodedLength(implicitTag, contentLength) +
+            contentLength;
+    }
+
     public byte[] encode() throws IOException {
         ByteArrayOutputStream b = new ByteArrayOutputStream();
         encode(b);
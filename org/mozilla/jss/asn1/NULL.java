@@ -26,6 +26,10 @@ public class NULL implements ASN1Value {
         head.encode(ostream);
     }
 
+    public long getEncodedLength(Tag implicitTag) {
+        return ASN1Header.getEncodedLength(implicitTag, 0);
+    }
+
     private static final NULL instance = new NULL();
     public static NULL getInstance() {
         return instance;
@@ -432,6 +432,12 @@ public class OBJECT_IDENTIFIER implements ASN1Value {
         ostream.write( getEncoding(implicitTag) );
     }
 
+    public long getEncodedLength(Tag implicitTag) {
+        int contentLength = getEncodedContents().length;
+        return ASN1Header.getEncodedLength(implicitTag, contentLength) +
+            contentLength;
+    }
+
     private static final Template templateInstance = new Template();
     public static Template getTemplate() {
         return templateInstance;
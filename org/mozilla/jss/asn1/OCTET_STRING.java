@@ -7,6 +7,8 @@ import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 
 public class OCTET_STRING implements ASN1Value {
 
@@ -16,16 +18,43 @@ public class OCTET_STRING implements ASN1Value {
     }
     public static final Form FORM = Form.PRIMITIVE;
 
-    byte[] data;
+    // The contents are buf[offset..offset+length). Unless this value is
+    // a view into a decoding buffer, buf is the whole array and data is
+    // the same array; for a view, data is copied out when first asked for.
+    private final byte[] buf;
+    private final int offset;
+    private final int length;
+    private byte[] data;
 
     public OCTET_STRING( byte[] data ) {
+        this.buf = data;
+        this.offset = 0;
+        this.length = (data == null) ? 0 : data.length;
         this.data = data;
     }
 
+    OCTET_STRING( byte[] buf, int offset, int length ) {
+        this.buf = buf;
+        this.offset = offset;
+        this.length = length;
+    }
+
     public byte[] toByteArray() {
+        if( data == null && buf != null ) {
+            data = Arrays.copyOfRange(buf, offset, offset + length);
+        }
         return data;
     }
 
+    /**
+     * Returns the contents as a read-only buffer, without copying them.
+     *
+     * @return Contents.
+     */
+    public ByteBuffer toByteBuffer() {
+        return ByteBuffer.wrap(buf, offset, length).slice().asReadOnlyBuffer();
+    }
+
     public void encode(OutputStream ostream) throws IOException {
         // use getTag() so we can be subclassed
         encode(getTag(), ostream);
@@ -34,11 +63,15 @@ public class OCTET_STRING implements ASN1Value {
     public void encode(Tag implicitTag, OutputStream ostream)
         throws IOException
     {
-        ASN1Header head = new ASN1Header(implicitTag, FORM, data.length);
+        ASN1Header head = new ASN1Header(implicitTag, FORM, length);
 
         head.encode(ostream);
 
-        ostream.write(data);
+        ostream.write(buf, offset, length);
+    }
+
+    public long getEncodedLength(Tag implicitTag) {
+        return ASN1Header.getEncodedLength(implicitTag, length) + length;
     }
 
     private static final Template templateInstance = new Template();
@@ -67,6 +100,17 @@ public static class Template implements ASN1Template {
         return new OCTET_STRING( bytes );
     }
 
+    /**
+     * Creates a value whose contents are
+     * <code>buf[offset..offset+length)</code>, without copying them. This
+     * is used when decoding from a <code>SliceInputStream</code>.
+     * Subclasses that override <code>generateInstance(byte[])</code>
+     * should override this too.
+     */
+    protected ASN1Value generateInstance(byte[] buf, int offset, int length) {
+        return new OCTET_STRING( buf, offset, length );
+    }
+
     // this can be overridden by subclasses
     protected String getName() {
         return "OCTET_STRING";
@@ -100,7 +144,14 @@ public static class Template implements ASN1Template {
 
             data = bos.toByteArray();
         } else {
-            data = new byte[ (int) head.getContentLength() ];
+            int length = (int) head.getContentLength();
+            SliceInputStream source = SliceInputStream.getSource(istream);
+            if( source != null ) {
+                int offset = source.take(istream, length);
+                return generateInstance(source.getBuffer(), offset, length);
+            }
+
+            data = new byte[length];
             ASN1Util.readFully(data, istream);
         }
 
@@ -9,6 +9,8 @@ import java.io.FileInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.util.Arrays;
+import java.util.Comparator;
 import java.util.Vector;
 
 import org.mozilla.jss.util.Assert;
@@ -171,48 +173,46 @@ public class SET implements ASN1Value {
     public void encode(Tag implicitTag, OutputStream ostream)
         throws IOException
     {
-        // what ordering method?
-        boolean lexOrdering;
-        if( elements.size() < 2 ) {
-            // doesn't matter, only one element
-            lexOrdering = true;
-        } else if( tagAt(0).equals(tagAt(1)) ) {
-            // tags are the same, lexicographic ordering
-            lexOrdering = true;
-        } else {
-            // tags are different, order by tag
-            lexOrdering = false;
-        }
-
-        // compute and order contents
         int numElements = elements.size();
-        int totalBytes = 0;
-        Vector<byte[]> encodings = new Vector<>(numElements);
-        Vector<Integer> tags = new Vector<>(numElements);
-        int i;
-        for(i = 0; i < numElements; i++ ) {
-
-            // if an entry is null, just skip it
-            if( elementAt(i) != null ) {
-                byte[] enc = ASN1Util.encode(tagAt(i), elementAt(i));
-
-                totalBytes += enc.length;
 
-                if( lexOrdering ) {
-                    insertInOrder(encodings, enc);
-                } else {
-                   insertInOrder(encodings, enc, tags, (int) tagAt(i).getNum());
-                }
+        // Encode every element into one buffer, once, remembering where
+        // each one starts and ends. Null entries are skipped. The header
+        // is written afterwards, from the size of the buffer.
+        EncodingBuffer buffer = new EncodingBuffer();
+        int[] offsets = new int[numElements + 1];
+        Integer[] order = new Integer[numElements];
+        int count = 0;
+        for(int i = 0; i < numElements; i++ ) {
+            ASN1Value el = elementAt(i);
+            if( el != null ) {
+                offsets[count] = buffer.size();
+                el.encode(tagAt(i), buffer);
+                order[count] = count;
+                count++;
             }
         }
+        offsets[count] = buffer.size();
+
+        // What ordering method? If the first two elements have the same
+        // tag this is a SET OF, which DER orders by encoding. Otherwise
+        // the tags are all different and DER orders by tag.
+        if( count >= 2 ) {
+            byte[] buf = buffer.getBuffer();
+            Arrays.sort(order, 0, count,
+                sameTag(buf, offsets[0], offsets[1]) ?
+                    new EncodingComparator(buf, offsets) :
+                    new TagComparator(buf, offsets, count));
+        }
 
         // write header
-        ASN1Header header = new ASN1Header( implicitTag, FORM, totalBytes );
+        ASN1Header header = new ASN1Header( implicitTag, FORM,
+            buffer.size() );
         header.encode(ostream);
 
         // write contents in order
-        for(i=0; i < numElements; i++ ) {
-            ostream.write( encodings.elementAt(i) );
+        for(int i = 0; i < count; i++ ) {
+            int el = order[i];
+            buffer.writeRange(offsets[el], offsets[el + 1], ostream);
         }
     }
 
@@ -226,88 +226,126 @@ public class SET implements ASN1Value {
     public void BERencode(Tag implicitTag, OutputStream ostream)
         throws IOException
     {
-        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        // lengths measured for the header are reused by the elements
+        EncodedLengthCache pass = EncodedLengthCache.open();
+        try {
+            // write header
+            ASN1Header header = new ASN1Header( implicitTag, FORM,
+                getContentLength() );
+            header.encode(ostream);
+
+            // write contents
+            int size = elements.size();
+            for(int i = 0; i < size; i++ ) {
+                ASN1Value el = elementAt(i);
+                if(el!=null) {
+                    el.encode(tagAt(i), ostream);
+                }
+            }
+        } finally {
+            pass.close();
+        }
+    }
 
-        // compute contents
+    public long getEncodedLength(Tag implicitTag)
+        throws IOException
+    {
+        long contentLength = getContentLength();
+        return ASN1Header.getEncodedLength(implicitTag, contentLength) +
+            contentLength;
+    }
+
+    // The total length of the encoded elements, which is the same
+    // whatever order they are written in.
+    private long getContentLength() throws IOException {
+        long total = 0;
         int size = elements.size();
         for(int i = 0; i < size; i++ ) {
             ASN1Value el = elementAt(i);
             if(el!=null) {
-                el.encode(tagAt(i), bos);
+                total += el.getEncodedLength(tagAt(i));
             }
         }
+        return total;
+    }
 
-        byte[] bytes = bos.toByteArray();
-
-        // write header
-        ASN1Header header = new ASN1Header( implicitTag, FORM, bytes.length );
-        header.encode(ostream);
+    // A ByteArrayOutputStream whose buffer can be read in place.
+    private static class EncodingBuffer extends ByteArrayOutputStream {
+        byte[] getBuffer() {
+            return buf;
+        }
 
-        // write contents
-        ostream.write(bytes);
+        void writeRange(int from, int to, OutputStream ostream)
+            throws IOException
+        {
+            ostream.write(buf, from, to - from);
+        }
     }
 
-    // performs ascending lexicographic ordering
-    // linear search, but number of items is usually going to be small.
-    private static void insertInOrder(Vector<byte[]> encs, byte[] enc) {
-        int size = encs.size();
+    // Orders elements by their encodings, compared as unsigned octet
+    // strings, with a shorter encoding first if it is a prefix of the
+    // longer one.
+    private static class EncodingComparator implements Comparator<Integer> {
+        private final byte[] buf;
+        private final int[] offsets;
 
-        // find the lowest item that we are less than or equal to
-        int i;
-        for(i=0; i < size; i++) {
-            if( compare(enc, encs.elementAt(i)) < 1 ) {
-                break;
-            }
+        EncodingComparator(byte[] buf, int[] offsets) {
+            this.buf = buf;
+            this.offsets = offsets;
         }
 
-        // insert ourself before this item
-        encs.insertElementAt(enc, i);
-    }
-
-    // performs ascending ordering by tag
-    // linear search, but number of items is usually going to be small.
-    private static void insertInOrder(Vector<byte[]> encs, byte[] enc, Vector<Integer> tags,
-                int tag)
-    {
-        int size = encs.size();
+        public int compare(Integer left, Integer right) {
+            int l = offsets[left];
+            int lEnd = offsets[left + 1];
+            int r = offsets[right];
+            int rEnd = offsets[right + 1];
 
-        // find the lowest item that we are less than or equal to
-        int i;
-        for(i = 0; i < size; i++) {
-            if( tag <= tags.elementAt(i).intValue() ) {
-                break;
+            for( ; l < lEnd && r < rEnd; l++, r++ ) {
+                int diff = (buf[l] & 0xff) - (buf[r] & 0xff);
+                if( diff != 0 ) {
+                    return diff;
+                }
             }
+            return (lEnd - l) - (rEnd - r);
         }
-
-        // insert ourself before this item
-        encs.insertElementAt(enc, i);
-        tags.insertElementAt(new Integer(i), i );
     }
 
+    // Orders elements by tag class, then by tag number, as read back from
+    // their encodings.
+    private static class TagComparator implements Comparator<Integer> {
+        private final long[] keys;
 
-    // compares two byte arrays
-    // returns 1 if left > right, -1 if left < right, 0 if left == right
-    private static int compare(byte[] left, byte[] right) {
-        int min = (left.length < right.length) ? left.length : right.length;
-
-        for(int i=0; i < min; i++) {
-            if( (left[i]&0xff) < (right[i]&0xff) ) {
-                return -1;
-            } else if( (left[i]&0xff) > (right[i]&0xff) ) {
-                return 1;
+        TagComparator(byte[] buf, int[] offsets, int count) {
+            keys = new long[count];
+            for( int i = 0; i < keys.length; i++ ) {
+                keys[i] = tagKey(buf, offsets[i]);
             }
         }
 
-        // equal up to the minimal endpoint
-        if( left.length > min ) {
-            Assert._assert(right.length==min);
-            return 1;
+        public int compare(Integer left, Integer right) {
+            return Long.compare(keys[left], keys[right]);
         }
-        if( right.length > min ) {
-            Assert._assert(left.length==min);
-            return -1;
+    }
+
+    // Returns a key that sorts tags by class, then by number, given the
+    // offset of an identifier octet.
+    private static long tagKey(byte[] buf, int offset) {
+        int idOctet = buf[offset] & 0xff;
+        long num = idOctet & 0x1f;
+        if( num == 0x1f ) {
+            // long form: 7 bits per octet until one without the high bit
+            num = 0;
+            int b;
+            do {
+                b = buf[++offset] & 0xff;
+                num = (num << 7) | (b & 0x7f);
+            } while( (b & 0x80) != 0 );
         }
-        return 0;
+        return ((long) (idOctet >>> 6) << 56) | num;
+    }
+
+    private static boolean sameTag(byte[] buf, int left, int right) {
+        return tagKey(buf, left) == tagKey(buf, right);
     }
 
     /**
@@ -0,0 +1,90 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.asn1;
+
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+
+/**
+ * An input stream over a region of a byte array that templates decode
+ * from without copying. <code>OCTET_STRING</code>, <code>BIT_STRING</code>
+ * and <code>ANY</code> values decoded from a SliceInputStream refer to
+ * their contents in the array instead of reading them into new arrays.
+ *
+ * <p>Such values keep the whole array reachable, and see any later
+ * changes to it. The array must not be modified while they are in use;
+ * copy the values (for example with <code>toByteArray</code>) to keep
+ * them longer than the array.
+ *
+ * @see ASN1Util#decode(ASN1Template, java.nio.ByteBuffer)
+ */
+public class SliceInputStream extends ByteArrayInputStream {
+
+    /**
+     * @param buf The array to read from.
+     */
+    public SliceInputStream(byte[] buf) {
+        super(buf);
+    }
+
+    /**
+     * @param buf The array to read from.
+     * @param offset The index of the first byte to read.
+     * @param length The number of bytes to read.
+     */
+    public SliceInputStream(byte[] buf, int offset, int length) {
+        super(buf, offset, length);
+    }
+
+    /**
+     * Returns the index in the array of the next byte to be read.
+     *
+     * @return Position in the array.
+     */
+    public synchronized int getPosition() {
+        return pos;
+    }
+
+    byte[] getBuffer() {
+        return buf;
+    }
+
+    /**
+     * Consumes the next <code>length</code> bytes by skipping them on
+     * <code>istream</code>, which reads from this stream, so that any
+     * stream in between counts them. Returns the index in the array of
+     * the first of them.
+     */
+    int take(InputStream istream, int length)
+        throws IOException, InvalidBERException
+    {
+        int start = getPosition();
+        if( available() < length ) {
+            throw new InvalidBERException.EOF();
+        }
+        long skipped = istream.skip(length);
+        if( skipped != length || getPosition() != start + length ) {
+            throw new IOException("Unable to skip " + length + " bytes");
+        }
+        return start;
+    }
+
+    /**
+     * Returns the SliceInputStream that <code>istream</code> reads from,
+     * looking through the counting streams that SEQUENCE and SET
+     * templates wrap around their input, or null if it does not read
+     * from one.
+     */
+    static SliceInputStream getSource(InputStream istream) {
+        while( istream instanceof CountingStream ) {
+            istream = ((CountingStream) istream).getSource();
+        }
+        if( istream instanceof SliceInputStream ) {
+            return (SliceInputStream) istream;
+        }
+        return null;
+    }
+}
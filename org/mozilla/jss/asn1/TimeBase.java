@@ -33,6 +33,13 @@ public abstract class TimeBase implements ASN1Value {
         encode(getTag(), ostream);
     }
 
+    public long getEncodedLength(Tag implicit) {
+        // YYMMDDHHMMSSZ or YYYYMMDDHHMMSSZ
+        int contentLength = isUTC() ? 13 : 15;
+        return ASN1Header.getEncodedLength(implicit, contentLength) +
+            contentLength;
+    }
+
     /**
      * Write the DER-encoding of this TimeBase.
      */
@@ -0,0 +1,209 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "_jni/org_mozilla_jss_crypto_AeadCipher.h"
+#include <nspr.h>
+#include <nss.h>
+#include <pk11func.h>
+#include <pkcs11t.h>
+#include <secerr.h>
+#include <string.h>
+
+#include <jssutil.h>
+#include <jss_exceptions.h>
+#include <jss_ids.h>
+#include "pk11util.h"
+
+/*
+ * Copies len bytes of a byte array, starting at offset, into a new buffer
+ * from PR_Malloc. Returns NULL and throws if it fails.
+ */
+static unsigned char *
+copyFromArray(JNIEnv *env, jbyteArray array, jint offset, jint len)
+{
+    unsigned char *copy = PR_Malloc(len > 0 ? len : 1);
+
+    if( copy == NULL ) {
+        JSS_throw(env, OUT_OF_MEMORY_ERROR);
+        return NULL;
+    }
+    (*env)->GetByteArrayRegion(env, array, offset, len, (jbyte*) copy);
+    if( (*env)->ExceptionOccurred(env) != NULL ) {
+        PR_Free(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+static void
+freeCopy(unsigned char *copy, jint len)
+{
+    if( copy != NULL ) {
+        memset(copy, 0, len);
+        PR_Free(copy);
+    }
+}
+
+/***********************************************************************
+ *
+ * AeadCipher.aeadOp
+ *
+ * Seals or opens a whole message with PK11_Encrypt or PK11_Decrypt. The
+ * caller has checked that output has room for the result.
+ *
+ * Byte arrays are copied rather than pinned, so the token call doesn't
+ * hold off the garbage collector. NSS may write plaintext before it
+ * checks the tag, so decryption always goes into a scratch buffer that
+ * is copied to output only once the tag has verified. Encryption writes
+ * straight into a direct output buffer; if it overlaps a direct input
+ * anywhere but at the same address, the input is copied first.
+ *
+ * RETURNS
+ *      The number of bytes written to output, or -1 if an exception was
+ *      thrown.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_crypto_AeadCipher_aeadOp
+    (JNIEnv *env, jclass clazz, jobject keyObj, jboolean encrypt,
+        jbyteArray nonceArray, jbyteArray aadArray, jint tagLen,
+        jobject input, jint inOffset, jint inLen,
+        jobject output, jint outOffset, jint outLen)
+{
+    PK11SymKey *key = NULL;
+    CK_GCM_PARAMS gcm;
+    SECItem param;
+    jsize nonceLen, aadLen = 0;
+    unsigned char *nonce = NULL, *aad = NULL;
+    unsigned char *inCopy = NULL, *scratch = NULL;
+    unsigned char *indata, *outdata = NULL;
+    jint resultLen;
+    unsigned int opLen = 0;
+    SECStatus status;
+    PRErrorCode err;
+    jint retval = -1;
+
+    PR_ASSERT(env!=NULL && keyObj!=NULL && nonceArray!=NULL &&
+        input!=NULL && output!=NULL);
+    PR_ASSERT(inOffset >= 0 && inLen >= 0 && outOffset >= 0 && outLen >= 0);
+
+    if( !(*env)->IsInstanceOf(env, keyObj, JSS_CLASS(PK11SymKey)) ) {
+        JSS_throwMsg(env, INVALID_KEY_EXCEPTION, "Key is not a PKCS #11 key");
+        return -1;
+    }
+    if( JSS_PK11_getSymKeyPtr(env, keyObj, &key) != PR_SUCCESS ) {
+        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL );
+        return -1;
+    }
+
+    resultLen = encrypt ? inLen + tagLen : inLen - tagLen;
+    PR_ASSERT(resultLen >= 0 && resultLen <= outLen);
+
+    nonceLen = (*env)->GetArrayLength(env, nonceArray);
+    nonce = copyFromArray(env, nonceArray, 0, nonceLen);
+    if( nonce == NULL ) {
+        goto finish;
+    }
+    if( aadArray != NULL ) {
+        aadLen = (*env)->GetArrayLength(env, aadArray);
+        aad = copyFromArray(env, aadArray, 0, aadLen);
+        if( aad == NULL ) {
+            goto finish;
+        }
+    }
+
+    indata = (unsigned char*) (*env)->GetDirectBufferAddress(env, input);
+    if( indata == NULL ) {
+        inCopy = copyFromArray(env, input, inOffset, inLen);
+        if( inCopy == NULL ) {
+            goto finish;
+        }
+        indata = inCopy;
+    } else {
+        indata += inOffset;
+    }
+
+    if( encrypt ) {
+        outdata = (unsigned char*) (*env)->GetDirectBufferAddress(env,
+            output);
+    }
+    if( outdata == NULL ) {
+        scratch = PR_Malloc(resultLen > 0 ? resultLen : 1);
+        if( scratch == NULL ) {
+            JSS_throw(env, OUT_OF_MEMORY_ERROR);
+            goto finish;
+        }
+    } else {
+        outdata += outOffset;
+
+        /* In place is fine, but a shifted overlap would clobber the input. */
+        if( inCopy == NULL && indata != outdata &&
+            indata < outdata + resultLen && outdata < indata + inLen )
+        {
+            inCopy = PR_Malloc(inLen);
+            if( inCopy == NULL ) {
+                JSS_throw(env, OUT_OF_MEMORY_ERROR);
+                goto finish;
+            }
+            memcpy(inCopy, indata, inLen);
+            indata = inCopy;
+        }
+    }
+
+    memset(&gcm, 0, sizeof(gcm));
+    gcm.pIv = (CK_BYTE_PTR) nonce;
+    gcm.ulIvLen = nonceLen;
+#if NSS_VMAJOR > 3 || (NSS_VMAJOR == 3 && NSS_VMINOR >= 52)
+    gcm.ulIvBits = nonceLen * 8;
+#endif
+    gcm.pAAD = (CK_BYTE_PTR) aad;
+    gcm.ulAADLen = aadLen;
+    gcm.ulTagBits = tagLen * 8;
+    param.type = siBuffer;
+    param.data = (unsigned char*) &gcm;
+    param.len = sizeof(gcm);
+
+    if( encrypt ) {
+        status = PK11_Encrypt(key, CKM_AES_GCM, &param,
+                    scratch != NULL ? scratch : outdata, &opLen, resultLen,
+                    indata, inLen);
+    } else {
+        status = PK11_Decrypt(key, CKM_AES_GCM, &param,
+                    scratch, &opLen, resultLen, indata, inLen);
+    }
+    if( status != SECSuccess ) {
+        err = PR_GetError();
+        if( !encrypt && err == SEC_ERROR_BAD_DATA ) {
+            JSS_throwMsgPrErrArg(env, AEAD_BAD_TAG_EXCEPTION,
+                "Message failed authentication", err);
+        } else {
+            JSS_throwMsgPrErrArg(env, TOKEN_EXCEPTION,
+                encrypt ? "AEAD encryption failed" :
+                          "AEAD decryption failed", err);
+        }
+        goto finish;
+    }
+
+    /* Only now that the tag has verified may plaintext reach the caller. */
+    if( scratch != NULL ) {
+        outdata = (unsigned char*) (*env)->GetDirectBufferAddress(env,
+            output);
+        if( outdata != NULL ) {
+            memcpy(outdata + outOffset, scratch, opLen);
+        } else {
+            (*env)->SetByteArrayRegion(env, output, outOffset, opLen,
+                (jbyte*) scratch);
+            if( (*env)->ExceptionOccurred(env) != NULL ) {
+                goto finish;
+            }
+        }
+    }
+    retval = opLen;
+
+finish:
+    freeCopy(scratch, resultLen);
+    freeCopy(inCopy, inLen);
+    freeCopy(aad, aadLen);
+    freeCopy(nonce, nonceLen);
+    return retval;
+}
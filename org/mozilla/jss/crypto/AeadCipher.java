@@ -0,0 +1,186 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.crypto;
+
+import java.nio.ByteBuffer;
+import java.security.InvalidKeyException;
+
+import javax.crypto.AEADBadTagException;
+import javax.crypto.ShortBufferException;
+
+/**
+ * Single-call authenticated encryption. Each <code>seal</code> or
+ * <code>open</code> is one PKCS #11 operation on a whole message, with no
+ * cipher context to set up or tear down; nothing is allocated on the Java
+ * heap unless a buffer is neither direct nor backed by an accessible array.
+ * Array-backed buffers are copied to and from native memory rather than
+ * pinned for the length of the token call.
+ *
+ * <p><code>seal</code> writes the ciphertext followed by the tag, and
+ * <code>open</code> expects the same layout. The output may occupy the same
+ * memory as the input, starting at the same place, to encrypt or decrypt in
+ * place: use a second buffer object over the same memory, such as a
+ * <code>duplicate()</code> of the input, since each buffer's position is
+ * advanced past the bytes it supplied or received.
+ *
+ * <p>A nonce must never be used twice with the same key.
+ */
+public final class AeadCipher {
+
+    /**
+     * AES in Galois/Counter Mode with a 128-bit tag.
+     */
+    public static final AeadCipher AES_GCM =
+        new AeadCipher("AES/GCM/NoPadding", 16);
+
+    private final String name;
+    private final int tagLength;
+
+    private AeadCipher(String name, int tagLength) {
+        this.name = name;
+        this.tagLength = tagLength;
+    }
+
+    /**
+     * Returns the length in bytes of the authentication tag.
+     */
+    public int getTagLength() {
+        return tagLength;
+    }
+
+    public String toString() {
+        return name;
+    }
+
+    /**
+     * Encrypts and authenticates the remaining bytes of <code>in</code>,
+     * writing the ciphertext and tag to <code>out</code>.
+     *
+     * @param key The encryption key.
+     * @param nonce The nonce, unique for this key.
+     * @param aad Additional data to authenticate but not encrypt, or null.
+     * @param in The plaintext. Its position is advanced to its limit.
+     * @param out Receives <code>in.remaining() + getTagLength()</code>
+     *      bytes. Its position is advanced past them.
+     * @return The number of bytes written to <code>out</code>.
+     * @exception ShortBufferException If <code>out</code> does not have
+     *      room for the result. Neither buffer is changed.
+     * @exception InvalidKeyException If the key is not a PKCS #11 key.
+     * @exception TokenException If the token fails the operation.
+     */
+    public int seal(SymmetricKey key, byte[] nonce, byte[] aad,
+            ByteBuffer in, ByteBuffer out)
+        throws ShortBufferException, InvalidKeyException, TokenException
+    {
+        int inLen = in.remaining();
+        if (out.remaining() - tagLength < inLen) {
+            throw new ShortBufferException("Output buffer has room for " +
+                out.remaining() + " bytes; " + (inLen + tagLength) +
+                " are needed");
+        }
+        try {
+            return run(true, key, nonce, aad, in, out);
+        } catch (AEADBadTagException e) {
+            // only reported when decrypting
+            throw new TokenException(e.getMessage());
+        }
+    }
+
+    /**
+     * Checks and decrypts the remaining bytes of <code>in</code>, which
+     * hold ciphertext followed by the tag, writing the plaintext to
+     * <code>out</code>.
+     *
+     * @param key The decryption key.
+     * @param nonce The nonce the message was sealed with.
+     * @param aad The additional data the message was sealed with, or null.
+     * @param in The ciphertext and tag. Its position is advanced to its
+     *      limit.
+     * @param out Receives <code>in.remaining() - getTagLength()</code>
+     *      bytes. Its position is advanced past them.
+     * @return The number of bytes written to <code>out</code>.
+     * @exception AEADBadTagException If the message, nonce or additional
+     *      data fail authentication. The message is decrypted into native
+     *      memory and only copied to <code>out</code> once the tag has
+     *      verified, so <code>out</code> is unchanged.
+     * @exception ShortBufferException If <code>out</code> does not have
+     *      room for the result. Neither buffer is changed.
+     * @exception InvalidKeyException If the key is not a PKCS #11 key.
+     * @exception TokenException If the token fails the operation.
+     */
+    public int open(SymmetricKey key, byte[] nonce, byte[] aad,
+            ByteBuffer in, ByteBuffer out)
+        throws AEADBadTagException, ShortBufferException,
+            InvalidKeyException, TokenException
+    {
+        int inLen = in.remaining();
+        if (inLen < tagLength) {
+            throw new AEADBadTagException("Input is shorter than the tag");
+        }
+        if (out.remaining() < inLen - tagLength) {
+            throw new ShortBufferException("Output buffer has room for " +
+                out.remaining() + " bytes; " + (inLen - tagLength) +
+                " are needed");
+        }
+        return run(false, key, nonce, aad, in, out);
+    }
+
+    private int run(boolean encrypt, SymmetricKey key, byte[] nonce,
+            byte[] aad, ByteBuffer in, ByteBuffer out)
+        throws AEADBadTagException, InvalidKeyException, TokenException
+    {
+        if (nonce == null || nonce.length == 0) {
+            throw new IllegalArgumentException("A nonce is required");
+        }
+        if (out.isReadOnly()) {
+            throw new java.nio.ReadOnlyBufferException();
+        }
+
+        Object inData;
+        int inOffset;
+        int inLen = in.remaining();
+        if (in.isDirect()) {
+            inData = in;
+            inOffset = in.position();
+        } else if (in.hasArray()) {
+            inData = in.array();
+            inOffset = in.arrayOffset() + in.position();
+        } else {
+            byte[] copy = new byte[inLen];
+            in.duplicate().get(copy);
+            inData = copy;
+            inOffset = 0;
+        }
+
+        Object outData;
+        int outOffset;
+        if (out.isDirect()) {
+            outData = out;
+            outOffset = out.position();
+        } else {
+            outData = out.array();
+            outOffset = out.arrayOffset() + out.position();
+        }
+
+        int written = aeadOp(key, encrypt, nonce, aad, tagLength,
+            inData, inOffset, inLen, outData, outOffset, out.remaining());
+
+        in.position(in.limit());
+        out.position(out.position() + written);
+        return written;
+    }
+
+    /**
+     * Runs PK11_Encrypt or PK11_Decrypt with AES-GCM over
+     * <code>in[inOffset..inOffset+inLen)</code> into
+     * <code>out[outOffset..outOffset+outLen)</code>. Each of in and out is
+     * a direct ByteBuffer or a byte array. Returns the bytes written.
+     */
+    private static native int aeadOp(SymmetricKey key, boolean encrypt,
+            byte[] nonce, byte[] aad, int tagLength,
+            Object in, int inOffset, int inLen,
+            Object out, int outOffset, int outLen)
+        throws AEADBadTagException, InvalidKeyException, TokenException;
+}
@@ -12,11 +12,12 @@
 #include <pk11func.h>
 
 #include <jssutil.h>
+#include <jss_ids.h>
 
 #include "Algorithm.h"
 
-static PRStatus
-getAlgInfo(JNIEnv *env, jobject alg, JSS_AlgInfo *info);
+static jint
+getAlgIndex(JNIEnv *env, jobject alg);
 
 /***********************************************************************
 **
@@ -95,6 +96,32 @@ JSS_AlgInfo JSS_AlgTable[NUM_ALGS] = {
 /* REMEMBER TO UPDATE NUM_ALGS!!! */
 };
 
+/*
+ * The mechanism for each entry of JSS_AlgTable. Entries stored as OID tags
+ * are mapped to mechanisms once, the first time any is needed, rather than
+ * on every lookup; NSS must be initialized by then, which it is by the time
+ * an Algorithm reaches native code.
+ */
+static CK_MECHANISM_TYPE mechTable[NUM_ALGS];
+static PRCallOnceType mechTableOnce;
+
+static PRStatus
+initMechTable(void)
+{
+    int i;
+
+    for( i = 0; i < NUM_ALGS; i++ ) {
+        if( JSS_AlgTable[i].type == PK11_MECH ) {
+            mechTable[i] = (CK_MECHANISM_TYPE) JSS_AlgTable[i].val;
+        } else {
+            PR_ASSERT( JSS_AlgTable[i].type == SEC_OID_TAG );
+            mechTable[i] =
+                PK11_AlgtagToMechanism( (SECOidTag) JSS_AlgTable[i].val);
+        }
+    }
+    return PR_SUCCESS;
+}
+
 /***********************************************************************
  *
  * J S S _ g e t P K 1 1 M e c h F r o m A l g
@@ -109,17 +136,16 @@ JSS_AlgInfo JSS_AlgTable[NUM_ALGS] = {
 CK_MECHANISM_TYPE
 JSS_getPK11MechFromAlg(JNIEnv *env, jobject alg)
 {
-    JSS_AlgInfo info;
+    jint index;
 
-    if( getAlgInfo(env, alg, &info) != PR_SUCCESS) {
+    index = getAlgIndex(env, alg);
+    if( index == -1 ) {
         return CKM_INVALID_MECHANISM;
     }
-    if( info.type == PK11_MECH ) {
-        return (CK_MECHANISM_TYPE) info.val;
-    } else {
-        PR_ASSERT( info.type == SEC_OID_TAG );
-        return PK11_AlgtagToMechanism( (SECOidTag) info.val);
+    if( PR_CallOnce(&mechTableOnce, initMechTable) != PR_SUCCESS ) {
+        return CKM_INVALID_MECHANISM;
     }
+    return mechTable[index];
 }
 
 /***********************************************************************
@@ -136,11 +162,14 @@ JSS_getPK11MechFromAlg(JNIEnv *env, jobject alg)
 SECOidTag
 JSS_getOidTagFromAlg(JNIEnv *env, jobject alg)
 {
+    jint index;
     JSS_AlgInfo info;
 
-    if( getAlgInfo(env, alg, &info) != PR_SUCCESS) {
+    index = getAlgIndex(env, alg);
+    if( index == -1 ) {
         return SEC_OID_UNKNOWN;
     }
+    info = JSS_AlgTable[index];
     if( info.type == SEC_OID_TAG ) {
         return (SECOidTag) info.val;
     } else {
@@ -159,78 +188,25 @@ JSS_getOidTagFromAlg(JNIEnv *env, jobject alg)
  *      alg
  *          An org.mozilla.jss.Algorithm object. Must not be NULL.
  * RETURNS
- *      The index obtained from the algorithm, or -1 if an exception was
- *      thrown.
+ *      The index obtained from the algorithm, or -1 if it is not a valid
+ *      index.
  */
 static jint
 getAlgIndex(JNIEnv *env, jobject alg)
 {
-    jclass algClass;
-    jint index=-1;
-    jfieldID indexField;
+    jint index;
 
     PR_ASSERT(env!=NULL && alg!=NULL);
+    PR_ASSERT( (*env)->IsInstanceOf(env, alg, JSS_CLASS(Algorithm)) );
 
-    algClass = (*env)->GetObjectClass(env, alg);
-
-#ifdef DEBUG
-    /* Make sure this really is an Algorithm. */
-    {
-    jclass realClass = ((*env)->FindClass(env, ALGORITHM_CLASS_NAME));
-    PR_ASSERT( (*env)->IsInstanceOf(env, alg, realClass) );
-    }
-#endif
-
-    indexField = (*env)->GetFieldID(
-                                    env,
-                                    algClass,
-                                    OID_INDEX_FIELD_NAME,
-                                    OID_INDEX_FIELD_SIG);
-    if(indexField==NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
+    index = (*env)->GetIntField(env, alg, JSS_FIELD(Algorithm, oidIndex));
+    if( index < 0 || index >= NUM_ALGS ) {
+        PR_ASSERT(PR_FALSE);
+        return -1;
     }
-
-    index = (*env)->GetIntField(env, alg, indexField);
-    PR_ASSERT( (index >= 0) && (index < NUM_ALGS) );
-
-finish:
     return index;
 }
 
-/***********************************************************************
- *
- * J S S _ g e t E n u m F r o m A l g
- *
- * INPUTS
- *      alg
- *          An org.mozilla.jss.Algorithm object. Must not be NULL.
- * OUTPUTS
- *      info
- *          Pointer to a JSS_AlgInfo which will get the information about
- *          this algorithm, if it is found.  Must not be NULL.
- * RETURNS
- *      PR_SUCCESS if the enum was found, otherwise PR_FAILURE.
- */
-static PRStatus
-getAlgInfo(JNIEnv *env, jobject alg, JSS_AlgInfo *info)
-{
-    jint index;
-    PRStatus status = PR_FAILURE;
-
-    PR_ASSERT(env!=NULL && alg!=NULL && info!=NULL);
-
-    index = getAlgIndex(env, alg);
-    if( index == -1 ) {
-        goto finish;
-    }
-    *info = JSS_AlgTable[index];
-    status = PR_SUCCESS;
-
-finish:
-    return status;
-}
-
 /***********************************************************************
  *
  * EncryptionAlgorithm.getIVLength
@@ -0,0 +1,297 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.crypto;
+
+import java.security.GeneralSecurityException;
+import java.security.KeyFactory;
+import java.security.PublicKey;
+import java.security.spec.X509EncodedKeySpec;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
+
+/**
+ * Verifies many signatures at once, spreading them over a pool of worker
+ * threads. Each item is verified exactly as
+ * <code>initVerify</code>/<code>update</code>/<code>verify</code> on a
+ * <code>Signature</code> would, and gets its own result; one bad item
+ * does not affect the others.
+ *
+ * <p>Items may give their key as a <code>PublicKey</code> or as an encoded
+ * SubjectPublicKeyInfo. SPKIs are decoded by the Mozilla-JSS provider's
+ * KeyFactory for the item's signing algorithm; the decoded keys are kept
+ * and reused for later items, in this and later batches, with the same
+ * encoding.
+ *
+ * <p>A BatchVerifier may be shared between threads.
+ */
+public class BatchVerifier implements AutoCloseable {
+
+    /**
+     * One signature to verify.
+     */
+    public static class Item {
+        private final PublicKey key;
+        private final byte[] spki;
+        private final SignatureAlgorithm algorithm;
+        private final byte[] data;
+        private final byte[] signature;
+
+        /**
+         * @param key The public key to verify with.
+         * @param algorithm The signature algorithm.
+         * @param data The signed data.
+         * @param signature The signature over <code>data</code>.
+         */
+        public Item(PublicKey key, SignatureAlgorithm algorithm,
+                byte[] data, byte[] signature) {
+            this(key, null, algorithm, data, signature);
+        }
+
+        /**
+         * @param spki The DER-encoded SubjectPublicKeyInfo of the key to
+         *      verify with.
+         * @param algorithm The signature algorithm.
+         * @param data The signed data.
+         * @param signature The signature over <code>data</code>.
+         */
+        public Item(byte[] spki, SignatureAlgorithm algorithm,
+                byte[] data, byte[] signature) {
+            this(null, spki, algorithm, data, signature);
+        }
+
+        private Item(PublicKey key, byte[] spki, SignatureAlgorithm algorithm,
+                byte[] data, byte[] signature) {
+            if (algorithm == null || data == null || signature == null) {
+                throw new NullPointerException();
+            }
+            this.key = key;
+            this.spki = spki;
+            this.algorithm = algorithm;
+            this.data = data;
+            this.signature = signature;
+        }
+    }
+
+    /**
+     * The outcome of verifying one item.
+     */
+    public static class Result {
+        private final boolean valid;
+        private final Exception exception;
+
+        Result(boolean valid, Exception exception) {
+            this.valid = valid;
+            this.exception = exception;
+        }
+
+        /**
+         * Returns true if the signature verified.
+         */
+        public boolean isValid() {
+            return valid;
+        }
+
+        /**
+         * Returns the exception that prevented verification, for example
+         * an undecodable key or an unsupported algorithm, or null if the
+         * item was verified (successfully or not).
+         */
+        public Exception getException() {
+            return exception;
+        }
+    }
+
+    // Decoded SPKIs are dropped wholesale once there are this many.
+    private static final int MAX_CACHED_KEYS = 1024;
+
+    private final CryptoToken token;
+    private final ExecutorService executor;
+    private final boolean ownExecutor;
+    private final int parallelism;
+    private final Map<SPKI, PublicKey> keys =
+        new ConcurrentHashMap<SPKI, PublicKey>();
+
+    /**
+     * Creates a BatchVerifier that verifies on the internal crypto token
+     * using its own pool of one thread per available processor.
+     */
+    public BatchVerifier() {
+        this(TokenSupplierManager.getTokenSupplier().getInternalCryptoToken(),
+            Runtime.getRuntime().availableProcessors());
+    }
+
+    /**
+     * Creates a BatchVerifier with its own pool of worker threads, which
+     * is shut down by <code>close</code>.
+     *
+     * @param token The token to verify on.
+     * @param threads The number of worker threads.
+     */
+    public BatchVerifier(CryptoToken token, int threads) {
+        if (threads < 1) {
+            throw new IllegalArgumentException(
+                "threads must be positive: " + threads);
+        }
+        this.token = token;
+        this.parallelism = threads;
+        this.executor = threads == 1 ? null :
+            Executors.newFixedThreadPool(threads, new ThreadFactory() {
+                public Thread newThread(Runnable r) {
+                    Thread t = new Thread(r, "BatchVerifier");
+                    t.setDaemon(true);
+                    return t;
+                }
+            });
+        this.ownExecutor = true;
+    }
+
+    /**
+     * Creates a BatchVerifier that runs on the caller's executor, which
+     * <code>close</code> leaves running.
+     *
+     * @param token The token to verify on.
+     * @param executor The executor to run verification tasks on.
+     * @param parallelism The number of tasks to split each batch into.
+     */
+    public BatchVerifier(CryptoToken token, ExecutorService executor,
+            int parallelism) {
+        if (parallelism < 1) {
+            throw new IllegalArgumentException(
+                "parallelism must be positive: " + parallelism);
+        }
+        this.token = token;
+        this.executor = executor;
+        this.ownExecutor = false;
+        this.parallelism = parallelism;
+    }
+
+    /**
+     * Verifies every item, returning the results in the same order.
+     *
+     * @param items The signatures to verify.
+     * @return One result per item.
+     * @exception InterruptedException If the calling thread is interrupted
+     *      while waiting for the workers.
+     */
+    public Result[] verify(List<Item> items) throws InterruptedException {
+        final Item[] work = items.toArray(new Item[items.size()]);
+        final Result[] results = new Result[work.length];
+
+        int tasks = Math.min(parallelism, work.length);
+        if (executor == null || tasks <= 1) {
+            verifyRange(work, results, 0, work.length);
+            return results;
+        }
+
+        // Contiguous slices, so each task sets up one Signature context
+        // per algorithm rather than one per item.
+        List<Callable<Void>> slices = new ArrayList<Callable<Void>>(tasks);
+        for (int i = 0; i < tasks; i++) {
+            final int from = (int) ((long) work.length * i / tasks);
+            final int to = (int) ((long) work.length * (i + 1) / tasks);
+            slices.add(new Callable<Void>() {
+                public Void call() {
+                    verifyRange(work, results, from, to);
+                    return null;
+                }
+            });
+        }
+
+        for (Future<Void> f : executor.invokeAll(slices)) {
+            try {
+                f.get();
+            } catch (ExecutionException e) {
+                Throwable cause = e.getCause();
+                if (cause instanceof Error) {
+                    throw (Error) cause;
+                }
+                throw new RuntimeException(cause);
+            }
+        }
+        return results;
+    }
+
+    /**
+     * Shuts down the worker pool if this BatchVerifier created it.
+     */
+    public void close() {
+        if (ownExecutor && executor != null) {
+            executor.shutdown();
+        }
+    }
+
+    private void verifyRange(Item[] items, Result[] results, int from,
+            int to) {
+        Map<SignatureAlgorithm, Signature> contexts =
+            new HashMap<SignatureAlgorithm, Signature>();
+
+        for (int i = from; i < to; i++) {
+            Item item = items[i];
+            try {
+                Signature sig = contexts.get(item.algorithm);
+                if (sig == null) {
+                    sig = token.getSignatureContext(item.algorithm);
+                    contexts.put(item.algorithm, sig);
+                }
+                sig.initVerify(getKey(item));
+                sig.update(item.data);
+                results[i] = new Result(sig.verify(item.signature), null);
+            } catch (Exception e) {
+                results[i] = new Result(false, e);
+            }
+        }
+    }
+
+    private PublicKey getKey(Item item) throws GeneralSecurityException {
+        if (item.key != null) {
+            return item.key;
+        }
+
+        SPKI spki = new SPKI(item.spki);
+        PublicKey key = keys.get(spki);
+        if (key == null) {
+            KeyFactory factory = KeyFactory.getInstance(
+                item.algorithm.getSigningAlg().toString(), "Mozilla-JSS");
+            key = factory.generatePublic(new X509EncodedKeySpec(item.spki));
+            if (keys.size() >= MAX_CACHED_KEYS) {
+                keys.clear();
+            }
+            keys.put(new SPKI(item.spki.clone()), key);
+        }
+        return key;
+    }
+
+    /**
+     * An encoded SPKI usable as a map key.
+     */
+    private static final class SPKI {
+        private final byte[] encoded;
+        private final int hash;
+
+        SPKI(byte[] encoded) {
+            this.encoded = encoded;
+            this.hash = Arrays.hashCode(encoded);
+        }
+
+        public int hashCode() {
+            return hash;
+        }
+
+        public boolean equals(Object o) {
+            return o instanceof SPKI &&
+                Arrays.equals(encoded, ((SPKI) o).encoded);
+        }
+    }
+}
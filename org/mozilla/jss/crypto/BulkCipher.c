@@ -0,0 +1,238 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "_jni/org_mozilla_jss_crypto_BulkCipher.h"
+
+#include <nspr.h>
+#include <seccomon.h>
+#include <pk11func.h>
+#include <secitem.h>
+#include <secerr.h>
+
+/* JSS includes */
+#include <jss_exceptions.h>
+#include <jssutil.h>
+#include <pk11util.h>
+#include <Algorithm.h>
+#include <jss_ids.h>
+
+/* Larger than any block cipher IV */
+#define MAX_IV_LENGTH 64
+
+/*
+ * Record input is copied to the token in pieces of this size rather than
+ * pinned, since a token call can block.
+ */
+#define RECORD_CHUNK_SIZE 8192
+
+/*
+ * Runs one record through a fresh context: the IV of a PKCS #11 context
+ * is fixed when it is created. Output goes to *scratch, which is grown
+ * as needed and kept for the next record.
+ *
+ * RETURNS
+ *      The output length, or -1 with *err set. If the input cannot be
+ *      read, -1 is returned with a Java exception pending.
+ */
+static int
+cipherRecord(JNIEnv *env, CK_MECHANISM_TYPE mech, CK_ATTRIBUTE_TYPE op,
+    PK11SymKey *key, jbyteArray ivBA, jbyteArray inBA, int blockSize,
+    unsigned char **scratch, int *scratchLen, PRErrorCode *err)
+{
+    jbyte ivBuf[MAX_IV_LENGTH];
+    SECItem iv;
+    SECItem *param = NULL;
+    PK11Context *context = NULL;
+    jbyte chunk[RECORD_CHUNK_SIZE];
+    jsize inLen, off, n;
+    int opLen = 0;
+    unsigned int finalLen = 0;
+    int needed;
+    int retval = -1;
+
+    if( ivBA != NULL ) {
+        iv.type = siBuffer;
+        iv.len = (*env)->GetArrayLength(env, ivBA);
+        if( iv.len > MAX_IV_LENGTH ) {
+            *err = SEC_ERROR_INVALID_ARGS;
+            goto finish;
+        }
+        (*env)->GetByteArrayRegion(env, ivBA, 0, iv.len, ivBuf);
+        iv.data = (unsigned char*) ivBuf;
+    }
+    param = PK11_ParamFromIV(mech, ivBA != NULL ? &iv : NULL);
+
+    context = PK11_CreateContextBySymKey(mech, op, key, param);
+    if( context == NULL ) {
+        *err = PR_GetError();
+        goto finish;
+    }
+
+    inLen = (*env)->GetArrayLength(env, inBA);
+    needed = inLen + blockSize;
+    if( needed > *scratchLen ) {
+        unsigned char *grown = PR_Realloc(*scratch, needed);
+        if( grown == NULL ) {
+            *err = PR_OUT_OF_MEMORY_ERROR;
+            goto finish;
+        }
+        *scratch = grown;
+        *scratchLen = needed;
+    }
+
+    for( off = 0; off < inLen; off += n ) {
+        int chunkOut;
+
+        n = inLen - off;
+        if( n > RECORD_CHUNK_SIZE ) {
+            n = RECORD_CHUNK_SIZE;
+        }
+        (*env)->GetByteArrayRegion(env, inBA, off, n, chunk);
+        if( (*env)->ExceptionOccurred(env) ) {
+            goto finish;
+        }
+        if( PK11_CipherOp(context, *scratch + opLen, &chunkOut,
+                *scratchLen - opLen, (unsigned char*) chunk, n)
+                != SECSuccess )
+        {
+            *err = PR_GetError();
+            goto finish;
+        }
+        opLen += chunkOut;
+    }
+    if( PK11_DigestFinal(context, *scratch + opLen, &finalLen,
+            *scratchLen - opLen) != SECSuccess )
+    {
+        *err = PR_GetError();
+        goto finish;
+    }
+    retval = opLen + finalLen;
+
+finish:
+    if( context != NULL ) {
+        PK11_DestroyContext(context, PR_TRUE /*freeit*/);
+    }
+    if( param != NULL ) {
+        SECITEM_FreeItem(param, PR_TRUE /*freeit*/);
+    }
+    if( retval < 0 && *err == 0 ) {
+        *err = SEC_ERROR_LIBRARY_FAILURE;
+    }
+    return retval;
+}
+
+/*
+ * Builds the message for a failed record, in the form JSS_throwMsgPrErr
+ * gives exceptions. Returns NULL if an exception was thrown.
+ */
+static jstring
+errorMessage(JNIEnv *env, CK_ATTRIBUTE_TYPE op, PRErrorCode errCode)
+{
+    const char *errStr = JSS_strerror(errCode);
+    char *msg;
+    jstring retval;
+
+    if( errStr == NULL ) {
+        errStr = "Unknown error";
+    }
+    msg = PR_smprintf("%s: (%ld) %s",
+        op == CKA_ENCRYPT ? "Encryption failed" : "Decryption failed",
+        errCode, errStr);
+    if( msg == NULL ) {
+        JSS_throw(env, OUT_OF_MEMORY_ERROR);
+        return NULL;
+    }
+    retval = (*env)->NewStringUTF(env, msg);
+    PR_smprintf_free(msg);
+    return retval;
+}
+
+/***********************************************************************
+ *
+ * BulkCipher.cipherBatch
+ *
+ * Encrypts or decrypts each inputs[i] with ivs[i] under one key, storing
+ * the result in outputs[i]. A record that fails leaves outputs[i] null and
+ * the reason in errors[i]; the other records are unaffected. An exception
+ * is thrown only if the batch as a whole cannot go on.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_crypto_BulkCipher_cipherBatch
+    (JNIEnv *env, jclass clazz, jobject keyObj, jobject algObj,
+        jboolean encrypt, jboolean padded, jint blockSize,
+        jobjectArray ivs, jobjectArray inputs, jobjectArray outputs,
+        jobjectArray errors)
+{
+    CK_MECHANISM_TYPE mech;
+    CK_ATTRIBUTE_TYPE op;
+    PK11SymKey *key = NULL;
+    unsigned char *scratch = NULL;
+    int scratchLen = 0;
+    jsize count, i;
+
+    PR_ASSERT(env!=NULL && keyObj!=NULL && algObj!=NULL);
+
+    if( !(*env)->IsInstanceOf(env, keyObj, JSS_CLASS(PK11SymKey)) ) {
+        JSS_throwMsg(env, INVALID_KEY_EXCEPTION, "Key is not a PKCS #11 key");
+        goto finish;
+    }
+
+    mech = JSS_getPK11MechFromAlg(env, algObj);
+    if( mech == CKM_INVALID_MECHANISM ) {
+        JSS_throwMsg(env, TOKEN_EXCEPTION, "Unable to resolve algorithm to"
+            " PKCS #11 mechanism");
+        goto finish;
+    }
+    if( padded ) {
+        mech = PK11_GetPadMechanism(mech);
+    }
+    op = encrypt ? CKA_ENCRYPT : CKA_DECRYPT;
+
+    if( JSS_PK11_getSymKeyPtr(env, keyObj, &key) != PR_SUCCESS ) {
+        goto finish;
+    }
+
+    count = (*env)->GetArrayLength(env, inputs);
+
+    for( i = 0; i < count; i++ ) {
+        jbyteArray ivBA, inBA, outBA;
+        PRErrorCode err = 0;
+        int len;
+
+        ivBA = (*env)->GetObjectArrayElement(env, ivs, i);
+        inBA = (*env)->GetObjectArrayElement(env, inputs, i);
+        len = cipherRecord(env, mech, op, key, ivBA, inBA, blockSize,
+                &scratch, &scratchLen, &err);
+        if( ivBA != NULL ) {
+            (*env)->DeleteLocalRef(env, ivBA);
+        }
+        (*env)->DeleteLocalRef(env, inBA);
+        if( (*env)->ExceptionOccurred(env) ) {
+            goto finish;
+        }
+
+        if( len < 0 ) {
+            jstring msg = errorMessage(env, op, err);
+            if( msg == NULL ) {
+                goto finish;
+            }
+            (*env)->SetObjectArrayElement(env, errors, i, msg);
+            (*env)->DeleteLocalRef(env, msg);
+            continue;
+        }
+        outBA = (*env)->NewByteArray(env, len);
+        if( outBA == NULL ) {
+            ASSERT_OUTOFMEM(env);
+            goto finish;
+        }
+        (*env)->SetByteArrayRegion(env, outBA, 0, len, (jbyte*) scratch);
+        (*env)->SetObjectArrayElement(env, outputs, i, outBA);
+        (*env)->DeleteLocalRef(env, outBA);
+    }
+
+finish:
+    if( scratch != NULL ) {
+        PR_Free(scratch);
+    }
+}
@@ -0,0 +1,278 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.crypto;
+
+import java.security.InvalidKeyException;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.Semaphore;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Encrypts or decrypts a stream of independent records under one key,
+ * such as when re-encrypting stored data for key rotation.
+ *
+ * <p>Records are queued by <code>submit</code> and taken by a pool of
+ * worker threads in batches; each batch is processed in a single native
+ * call, so the per-record cost is that of the cipher operation itself
+ * rather than of setting up a <code>Cipher</code> and crossing into native
+ * code several times. Results are delivered through the returned futures
+ * as each batch completes.
+ *
+ * <p>At most <code>maxPending</code> records may be queued or in progress;
+ * <code>submit</code> blocks beyond that, so a fast producer is held to
+ * the speed of the workers.
+ */
+public class BulkCipher implements AutoCloseable {
+
+    private static final class Job {
+        final byte[] iv;
+        final byte[] data;
+        final CompletableFuture<byte[]> result =
+            new CompletableFuture<byte[]>();
+
+        Job(byte[] iv, byte[] data) {
+            this.iv = iv;
+            this.data = data;
+        }
+    }
+
+    // tells a worker to exit; passed on to the next one
+    private static final Job STOP = new Job(null, null);
+
+    private final SymmetricKey key;
+    private final EncryptionAlgorithm algorithm;
+    private final boolean encrypt;
+    private final int batchSize;
+    private final BlockingQueue<Job> queue = new LinkedBlockingQueue<Job>();
+    private final Semaphore pending;
+    private final Thread[] workers;
+
+    // held while queueing a record and while closing, so no record can
+    // be queued behind STOP
+    private final Object queueLock = new Object();
+    private volatile boolean closed = false;
+
+    private final AtomicLong records = new AtomicLong();
+    private final AtomicLong bytes = new AtomicLong();
+    private final AtomicLong startNanos = new AtomicLong();
+    private volatile long lastNanos;
+
+    /**
+     * @param key The key to use for every record.
+     * @param algorithm The encryption algorithm.
+     * @param encrypt true to encrypt, false to decrypt.
+     * @param threads The number of worker threads.
+     * @param batchSize The most records processed in one native call.
+     * @param maxPending The most records that may be queued or in
+     *      progress before <code>submit</code> blocks.
+     * @exception InvalidKeyException If the key is not a PKCS #11 key.
+     * @exception TokenException If the algorithm has no PKCS #11
+     *      mechanism.
+     */
+    public BulkCipher(SymmetricKey key, EncryptionAlgorithm algorithm,
+            boolean encrypt, int threads, int batchSize, int maxPending)
+        throws InvalidKeyException, TokenException
+    {
+        if (threads < 1 || batchSize < 1 || maxPending < 1) {
+            throw new IllegalArgumentException(
+                "threads, batchSize and maxPending must be positive");
+        }
+
+        // an empty batch checks the key and the mechanism
+        cipherBatch(key, algorithm, encrypt, algorithm.isPadded(),
+            algorithm.getBlockSize(), new byte[0][], new byte[0][],
+            new byte[0][], new String[0]);
+        this.key = key;
+        this.algorithm = algorithm;
+        this.encrypt = encrypt;
+        this.batchSize = batchSize;
+        this.pending = new Semaphore(maxPending);
+
+        workers = new Thread[threads];
+        for (int i = 0; i < threads; i++) {
+            workers[i] = new Thread(new Runnable() {
+                public void run() {
+                    work();
+                }
+            }, "BulkCipher-" + i);
+            workers[i].setDaemon(true);
+            workers[i].start();
+        }
+    }
+
+    /**
+     * Queues one record, blocking while the maximum number of records
+     * are pending.
+     *
+     * @param iv The IV for this record, or null if the algorithm takes
+     *      none.
+     * @param data The record. It must not be modified until the result
+     *      is complete.
+     * @return A future that completes with the output, or with a
+     *      TokenException if this record failed.
+     * @exception InterruptedException If interrupted while waiting for
+     *      room.
+     * @exception IllegalStateException If this BulkCipher is closed,
+     *      including while waiting for room.
+     */
+    public CompletableFuture<byte[]> submit(byte[] iv, byte[] data)
+        throws InterruptedException
+    {
+        int ivLength = algorithm.getIVLength();
+        if (ivLength > 0 && (iv == null || iv.length != ivLength)) {
+            throw new IllegalArgumentException(algorithm +
+                " needs a " + ivLength + "-byte IV");
+        }
+        if (data == null) {
+            throw new NullPointerException();
+        }
+        if (closed) {
+            throw new IllegalStateException("BulkCipher is closed");
+        }
+
+        pending.acquire();
+        Job job = new Job(ivLength > 0 ? iv : null, data);
+        synchronized (queueLock) {
+            if (closed) {
+                pending.release();
+                throw new IllegalStateException("BulkCipher is closed");
+            }
+            startNanos.compareAndSet(0, System.nanoTime());
+            queue.add(job);
+        }
+        return job.result;
+    }
+
+    /**
+     * Returns the number of records processed so far.
+     */
+    public long getRecordCount() {
+        return records.get();
+    }
+
+    /**
+     * Returns the number of input bytes processed so far.
+     */
+    public long getByteCount() {
+        return bytes.get();
+    }
+
+    /**
+     * Returns the records processed per second, from the first
+     * <code>submit</code> to the most recently completed batch.
+     */
+    public double getRecordsPerSecond() {
+        return perSecond(records.get());
+    }
+
+    /**
+     * Returns the input megabytes (2<sup>20</sup> bytes) processed per
+     * second, over the same period as <code>getRecordsPerSecond</code>.
+     */
+    public double getMegabytesPerSecond() {
+        return perSecond(bytes.get()) / (1024 * 1024);
+    }
+
+    private double perSecond(long count) {
+        long start = startNanos.get();
+        long elapsed = lastNanos - start;
+        if (start == 0 || elapsed <= 0) {
+            return 0;
+        }
+        return count * 1e9 / elapsed;
+    }
+
+    /**
+     * Stops taking records, finishes the ones already submitted, and
+     * stops the workers.
+     */
+    public void close() throws InterruptedException {
+        synchronized (queueLock) {
+            if (closed) {
+                return;
+            }
+            closed = true;
+            queue.add(STOP);
+        }
+        for (Thread worker : workers) {
+            worker.join();
+        }
+        queue.clear();
+    }
+
+    private void work() {
+        List<Job> batch = new ArrayList<Job>(batchSize);
+        boolean stop = false;
+
+        while (!stop) {
+            try {
+                batch.add(queue.take());
+            } catch (InterruptedException e) {
+                return;
+            }
+            queue.drainTo(batch, batchSize - 1);
+
+            if (batch.remove(STOP)) {
+                stop = true;
+                queue.add(STOP);
+            }
+            if (!batch.isEmpty()) {
+                process(batch);
+            }
+            batch.clear();
+        }
+    }
+
+    private void process(List<Job> batch) {
+        int count = batch.size();
+        byte[][] ivs = new byte[count][];
+        byte[][] inputs = new byte[count][];
+        byte[][] outputs = new byte[count][];
+        String[] errors = new String[count];
+        long inputBytes = 0;
+
+        for (int i = 0; i < count; i++) {
+            Job job = batch.get(i);
+            ivs[i] = job.iv;
+            inputs[i] = job.data;
+            inputBytes += job.data.length;
+        }
+
+        try {
+            cipherBatch(key, algorithm, encrypt, algorithm.isPadded(),
+                algorithm.getBlockSize(), ivs, inputs, outputs, errors);
+        } catch (Throwable e) {
+            for (Job job : batch) {
+                job.result.completeExceptionally(e);
+            }
+            pending.release(count);
+            return;
+        }
+
+        records.addAndGet(count);
+        bytes.addAndGet(inputBytes);
+        lastNanos = System.nanoTime();
+        pending.release(count);
+
+        for (int i = 0; i < count; i++) {
+            CompletableFuture<byte[]> result = batch.get(i).result;
+            if (outputs[i] != null) {
+                result.complete(outputs[i]);
+            } else {
+                result.completeExceptionally(new TokenException(errors[i]));
+            }
+        }
+    }
+
+    private static native void cipherBatch(SymmetricKey key,
+            EncryptionAlgorithm algorithm, boolean encrypt, boolean padded,
+            int blockSize, byte[][] ivs, byte[][] inputs, byte[][] outputs,
+            String[] errors)
+        throws InvalidKeyException, TokenException;
+}
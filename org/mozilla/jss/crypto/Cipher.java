@@ -6,9 +6,11 @@ package org.mozilla.jss.crypto;
 
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
+import java.nio.ByteBuffer;
 import java.security.spec.AlgorithmParameterSpec;
 
 import javax.crypto.BadPaddingException;
+import javax.crypto.ShortBufferException;
 
 import org.mozilla.jss.util.Assert;
 
@@ -107,6 +109,124 @@ public abstract class Cipher {
         throws IllegalStateException, IllegalBlockSizeException,
         BadPaddingException, TokenException;
 
+    /**
+     * Updates the encryption context with additional input, writing the
+     *  output directly into a caller-supplied array.
+     * @param input Bytes of plaintext (if encrypting) or ciphertext (if
+     *      decrypting).
+     * @param inputOffset The index in <code>input</code> at which to begin
+     *      reading.
+     * @param inputLen The number of bytes from <code>input</code> to read.
+     * @param output The array that receives the output.
+     * @param outputOffset The index in <code>output</code> at which to begin
+     *      writing.
+     * @return The number of bytes written to <code>output</code>.
+     * @exception ShortBufferException If the output does not fit in
+     *      <code>output</code>.
+     */
+    public int update(byte[] input, int inputOffset, int inputLen,
+            byte[] output, int outputOffset)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        // Subclasses that can write into output directly should override
+        // this; here the output is produced first and then copied.
+        byte[] out = update(input, inputOffset, inputLen);
+        return copyOutput(out, output, outputOffset);
+    }
+
+    /**
+     * Updates the encryption context with all the bytes remaining in
+     *  <code>input</code>, writing the output into <code>output</code>.
+     *  Both buffers' positions are advanced. When <code>output</code> has
+     *  room for the input plus one block, the output is written in place,
+     *  including into direct buffers.
+     * @return The number of bytes written to <code>output</code>.
+     * @exception ShortBufferException If the output does not fit in
+     *      <code>output</code>.
+     */
+    public int update(ByteBuffer input, ByteBuffer output)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        byte[] in = new byte[input.remaining()];
+        input.get(in);
+        return copyOutput(update(in), output);
+    }
+
+    /**
+     * Completes a cipher operation, writing the output directly into a
+     *  caller-supplied array.
+     * @param input Bytes of plaintext (if encrypting) or ciphertext (if
+     *      decrypting). May be <code>null</code> if
+     *      <code>inputLen</code> is zero.
+     * @param inputOffset The index in <code>input</code> at which to begin
+     *      reading.
+     * @param inputLen The number of bytes from <code>input</code> to read.
+     * @param output The array that receives the output.
+     * @param outputOffset The index in <code>output</code> at which to begin
+     *      writing.
+     * @return The number of bytes written to <code>output</code>.
+     * @exception ShortBufferException If the output does not fit in
+     *      <code>output</code>.
+     */
+    public int doFinal(byte[] input, int inputOffset, int inputLen,
+            byte[] output, int outputOffset)
+        throws IllegalStateException, IllegalBlockSizeException,
+        BadPaddingException, ShortBufferException, TokenException
+    {
+        if( input == null ) {
+            input = new byte[0];
+        }
+        byte[] out = doFinal(input, inputOffset, inputLen);
+        return copyOutput(out, output, outputOffset);
+    }
+
+    /**
+     * Completes a cipher operation with all the bytes remaining in
+     *  <code>input</code>, writing the output into <code>output</code>.
+     *  Both buffers' positions are advanced.
+     * @return The number of bytes written to <code>output</code>.
+     * @exception ShortBufferException If the output does not fit in
+     *      <code>output</code>.
+     */
+    public int doFinal(ByteBuffer input, ByteBuffer output)
+        throws IllegalStateException, IllegalBlockSizeException,
+        BadPaddingException, ShortBufferException, TokenException
+    {
+        byte[] in = new byte[input.remaining()];
+        input.get(in);
+        return copyOutput(doFinal(in), output);
+    }
+
+    /*
+     * Used by the default output-buffer methods above. The operation has
+     * already consumed its input by the time the output is found not to
+     * fit, as with any cipher that cannot report its output size first.
+     */
+    private static int copyOutput(byte[] out, byte[] output, int outputOffset)
+        throws ShortBufferException
+    {
+        if( outputOffset < 0 || outputOffset > output.length ) {
+            throw new ArrayIndexOutOfBoundsException(outputOffset);
+        }
+        if( out.length > output.length - outputOffset ) {
+            throw new ShortBufferException(out.length + " needed, " +
+                (output.length - outputOffset) + " supplied");
+        }
+        System.arraycopy(out, 0, output, outputOffset, out.length);
+        return out.length;
+    }
+
+    private static int copyOutput(byte[] out, ByteBuffer output)
+        throws ShortBufferException
+    {
+        if( out.length > output.remaining() ) {
+            throw new ShortBufferException(out.length + " needed, " +
+                output.remaining() + " supplied");
+        }
+        output.put(out);
+        return out.length;
+    }
+
     /**
      * Pads a byte array so that its length is a multiple of the given
      *  blocksize.  The method of padding is the one defined in the RSA
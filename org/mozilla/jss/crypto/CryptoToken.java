@@ -45,6 +45,84 @@ public interface CryptoToken {
     getDigestContext(DigestAlgorithm algorithm)
         throws java.security.NoSuchAlgorithmException, DigestException;
 
+    /**
+     * Hashes a portion of an array in a single step on this token. The
+     * default implementation uses a digest context from
+     * <code>getDigestContext</code>; tokens that can hash without one
+     * override it.
+     *
+     * @param algorithm A digest algorithm; HMAC algorithms are not allowed.
+     * @param input The array holding the data to hash.
+     * @param offset The index of the first byte to hash.
+     * @param len The number of bytes to hash.
+     * @return The digest.
+     * @exception java.security.NoSuchAlgorithmException If this token
+     *  does not support the given algorithm.
+     * @exception DigestException If an error occurs while digesting.
+     */
+    public default byte[]
+    digest(DigestAlgorithm algorithm, byte[] input, int offset, int len)
+        throws java.security.NoSuchAlgorithmException, DigestException
+    {
+        if( algorithm instanceof HMACAlgorithm ) {
+            throw new DigestException("HMAC requires a key");
+        }
+        JSSMessageDigest digest = getDigestContext(algorithm);
+        digest.update(input, offset, len);
+        return digest.digest();
+    }
+
+    /**
+     * Hashes the bytes remaining in a buffer in a single step on this
+     * token, and advances the buffer's position to its limit.
+     *
+     * @param algorithm A digest algorithm; HMAC algorithms are not allowed.
+     * @param input The data to hash.
+     * @return The digest.
+     * @exception java.security.NoSuchAlgorithmException If this token
+     *  does not support the given algorithm.
+     * @exception DigestException If an error occurs while digesting.
+     */
+    public default byte[]
+    digest(DigestAlgorithm algorithm, java.nio.ByteBuffer input)
+        throws java.security.NoSuchAlgorithmException, DigestException
+    {
+        if( algorithm instanceof HMACAlgorithm ) {
+            throw new DigestException("HMAC requires a key");
+        }
+        JSSMessageDigest digest = getDigestContext(algorithm);
+        digest.update(input);
+        return digest.digest();
+    }
+
+    /**
+     * Computes an HMAC over a portion of an array in a single step with
+     * a key on this token. The default implementation uses a digest
+     * context from <code>getDigestContext</code>.
+     *
+     * @param key The HMAC key.
+     * @param algorithm The HMAC algorithm.
+     * @param input The array holding the data to authenticate.
+     * @param offset The index of the first byte to authenticate.
+     * @param len The number of bytes to authenticate.
+     * @return The HMAC.
+     * @exception java.security.NoSuchAlgorithmException If this token
+     *  does not support the given algorithm.
+     * @exception DigestException If an error occurs while digesting.
+     * @exception InvalidKeyException If the key cannot be used for HMAC.
+     */
+    public default byte[]
+    hmac(SymmetricKey key, HMACAlgorithm algorithm, byte[] input,
+            int offset, int len)
+        throws java.security.NoSuchAlgorithmException, DigestException,
+            InvalidKeyException
+    {
+        JSSMessageDigest digest = getDigestContext(algorithm);
+        digest.initHMAC(key);
+        digest.update(input, offset, len);
+        return digest.digest();
+    }
+
     // !!! MAC ???
 
     /**
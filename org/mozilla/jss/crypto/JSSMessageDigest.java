@@ -4,8 +4,10 @@
 
 package org.mozilla.jss.crypto;
 
+import java.nio.ByteBuffer;
 import java.security.DigestException;
 import java.security.InvalidKeyException;
+import java.security.NoSuchAlgorithmException;
 
 /**
  * A class for performing message digesting (hashing) and MAC operations.
@@ -44,6 +46,28 @@ public abstract class JSSMessageDigest {
     public abstract void update(byte[] input, int offset, int len)
         throws DigestException;
 
+    /**
+     * Updates the digest with the bytes remaining in a buffer, and
+     * advances the buffer's position to its limit.
+     *
+     * @param input The buffer to feed to the digest.
+     * @exception DigestException If an error occurs while digesting.
+     */
+    public void update(ByteBuffer input) throws DigestException {
+        if( input.hasArray() ) {
+            update(input.array(), input.arrayOffset() + input.position(),
+                input.remaining());
+            input.position(input.limit());
+            return;
+        }
+        byte[] chunk = new byte[Math.min(input.remaining(), 8192)];
+        while( input.hasRemaining() ) {
+            int len = Math.min(input.remaining(), chunk.length);
+            input.get(chunk, 0, len);
+            update(chunk, 0, len);
+        }
+    }
+
     /**
      * Updates the digest with an array.
      *
@@ -93,6 +117,73 @@ public abstract class JSSMessageDigest {
         return digest();
     }
 
+    /**
+     * Hashes <code>input</code> in a single step on the internal module,
+     * without creating a digest context. This is much cheaper than the
+     * streaming interface for small inputs.
+     *
+     * @param alg A digest algorithm; HMAC algorithms are not allowed.
+     * @param input The data to hash.
+     * @return The digest.
+     * @exception DigestException If an error occurs while digesting.
+     */
+    public static byte[] digest(DigestAlgorithm alg, byte[] input)
+        throws DigestException
+    {
+        try {
+            return getInternalToken().digest(alg, input, 0, input.length);
+        } catch( NoSuchAlgorithmException e ) {
+            throw new DigestException(e.getMessage(), e);
+        }
+    }
+
+    /**
+     * Hashes the bytes remaining in <code>input</code> in a single step,
+     * without creating a digest context, and advances the buffer's
+     * position to its limit. Direct buffers are hashed in place.
+     *
+     * @param alg A digest algorithm; HMAC algorithms are not allowed.
+     * @param input The data to hash.
+     * @return The digest.
+     * @exception DigestException If an error occurs while digesting.
+     */
+    public static byte[] digest(DigestAlgorithm alg, ByteBuffer input)
+        throws DigestException
+    {
+        try {
+            return getInternalToken().digest(alg, input);
+        } catch( NoSuchAlgorithmException e ) {
+            throw new DigestException(e.getMessage(), e);
+        }
+    }
+
+    /**
+     * Computes an HMAC over <code>input</code> in a single step on the
+     * key's token, without creating a digest context.
+     *
+     * @param key The HMAC key.
+     * @param alg The HMAC algorithm.
+     * @param input The data to authenticate.
+     * @return The HMAC.
+     * @exception DigestException If an error occurs while digesting.
+     * @exception InvalidKeyException If the key cannot be used for HMAC.
+     */
+    public static byte[] hmac(SymmetricKey key, HMACAlgorithm alg,
+            byte[] input)
+        throws DigestException, InvalidKeyException
+    {
+        try {
+            return key.getOwningToken().hmac(key, alg, input, 0,
+                input.length);
+        } catch( NoSuchAlgorithmException e ) {
+            throw new DigestException(e.getMessage(), e);
+        }
+    }
+
+    private static CryptoToken getInternalToken() {
+        return TokenSupplierManager.getTokenSupplier().getInternalCryptoToken();
+    }
+
     /**
      * Resets this digest for further use.  This clears all input and
      * output streams. If this is an HMAC digest, the HMAC key is not
@@ -101,6 +192,18 @@ public abstract class JSSMessageDigest {
      */
     public abstract void reset() throws DigestException;
 
+    /**
+     * Returns a copy of this digest, including the input it has seen so
+     * far.
+     *
+     * @return A new JSSMessageDigest.
+     * @exception CloneNotSupportedException If this digest cannot be
+     *      copied.
+     */
+    public Object clone() throws CloneNotSupportedException {
+        throw new CloneNotSupportedException();
+    }
+
     /**
      * @return The algorithm that this digest uses.
      */
@@ -3,12 +3,15 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 package org.mozilla.jss.crypto;
 
+import java.nio.ByteBuffer;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.Provider;
 import java.security.PublicKey;
 import java.security.SignatureException;
 import java.security.spec.AlgorithmParameterSpec;
+import java.util.Arrays;
+import java.util.List;
 
 /**
  * A class for producing and verifying digital signatures.
@@ -111,6 +114,80 @@ public class Signature {
 		return engine.engineSign(outbuf, offset, len);
 	}
 
+	/**
+	 * Signs a batch of messages with the key given to
+	 * <code>initSign</code>, each as if it had been passed to
+	 * <code>update</code> on its own followed by <code>sign</code>.
+	 * Any data already passed to <code>update</code> is discarded.
+	 * Unlike <code>sign</code>, this leaves the context initialized for
+	 * signing with the same key, so batches can follow one another
+	 * without calling <code>initSign</code> again.
+	 *
+	 * <p>The signatures are stored back to back in <code>outbuf</code>.
+	 * <code>getMaxSignatureLength() * messages.size()</code> bytes is
+	 * always enough room.
+	 *
+	 * @param messages The messages to sign. The position of each buffer
+	 *      is advanced to its limit.
+	 * @param outbuf Buffer to hold the signatures.
+	 * @param offset Offset in buffer at which to store the first signature.
+	 * @param sigLengths Receives the length of each signature; must have
+	 *      at least <code>messages.size()</code> elements.
+	 * @return The total number of bytes placed into outbuf.
+	 * @exception SignatureException If an error occurred while signing, or
+	 *		outbuf was too small to contain the signatures.
+	 * @exception TokenException If an error occurred on the token.
+	 */
+	public int signAll(List<ByteBuffer> messages, byte[] outbuf, int offset,
+		int[] sigLengths)
+		throws SignatureException, TokenException
+	{
+		return engine.engineSignAll(messages, outbuf, offset, sigLengths);
+	}
+
+	/**
+	 * Signs a batch of messages as <code>signAll(List, byte[], int,
+	 * int[])</code> does, returning the signatures in the order of the
+	 * messages.
+	 *
+	 * @param messages The messages to sign. The position of each buffer
+	 *      is advanced to its limit.
+	 * @return The signatures.
+	 * @exception SignatureException If an error occurred while signing.
+	 * @exception TokenException If an error occurred on the token.
+	 */
+	public byte[][] signAll(List<ByteBuffer> messages)
+		throws SignatureException, TokenException
+	{
+		int count = messages.size();
+		byte[] outbuf = new byte[engine.engineGetMaxSignatureLength() * count];
+		int[] sigLengths = new int[count];
+
+		engine.engineSignAll(messages, outbuf, 0, sigLengths);
+
+		byte[][] sigs = new byte[count][];
+		int offset = 0;
+		for (int i = 0; i < count; i++) {
+			sigs[i] = Arrays.copyOfRange(outbuf, offset,
+				offset + sigLengths[i]);
+			offset += sigLengths[i];
+		}
+		return sigs;
+	}
+
+	/**
+	 * Returns an upper bound on the length of a signature made with the
+	 * key given to <code>initSign</code>.
+	 * @exception SignatureException If the context is not initialized
+	 *		for signing.
+	 * @exception TokenException If an error occurred on the token.
+	 */
+	public int getMaxSignatureLength()
+		throws SignatureException, TokenException
+	{
+		return engine.engineGetMaxSignatureLength();
+	}
+
 	/**
 	 * Finish a verification operation.
 	 * @param signature The signature to be verified.
@@ -166,6 +243,21 @@ public class Signature {
 		engine.engineUpdate(data, off, len);
 	}
 
+	/**
+	 * Provide more data for a signature or verification operation.
+	 * Direct buffers are read in place.
+	 * @param data A buffer whose remaining bytes will be signed or
+	 * 		verified. Its position is advanced to its limit.
+	 * @exception SignatureException If an error occurs in the
+	 * 		signature/verification.
+ 	 * @exception TokenException If an error occurs on the token.
+	 */
+	public void update(ByteBuffer data)
+		throws SignatureException, TokenException
+	{
+		engine.engineUpdate(data);
+	}
+
 	/**
 	 * Returns the name of the algorithm to be used for signing.
 	 */
@@ -3,7 +3,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 package org.mozilla.jss.crypto;
 
+import java.nio.ByteBuffer;
 import java.security.*;
+import java.util.List;
 import java.security.SecureRandom;
 import java.security.spec.AlgorithmParameterSpec;
 
@@ -28,12 +30,59 @@ public abstract class SignatureSpi {
 	public abstract void engineUpdate(byte[] b, int off, int len)
 		throws SignatureException, TokenException;
 
+	/**
+	 * Feeds the bytes remaining in <code>data</code> to the operation and
+	 * advances its position to its limit. This implementation goes
+	 * through <code>engineUpdate(byte[], int, int)</code>.
+	 */
+	public void engineUpdate(ByteBuffer data)
+		throws SignatureException, TokenException
+	{
+		if( data.hasArray() ) {
+			engineUpdate(data.array(), data.arrayOffset() + data.position(),
+				data.remaining());
+			data.position(data.limit());
+			return;
+		}
+		byte[] chunk = new byte[Math.min(data.remaining(), 8192)];
+		while( data.hasRemaining() ) {
+			int len = Math.min(data.remaining(), chunk.length);
+			data.get(chunk, 0, len);
+			engineUpdate(chunk, 0, len);
+		}
+	}
+
 	public abstract byte[] engineSign()
         throws SignatureException, TokenException;
  
 	public abstract int engineSign(byte[] outbuf, int offset, int len)
 		throws SignatureException, TokenException;
 
+	/**
+	 * Signs each message in turn, storing the signatures back to back in
+	 * <code>outbuf</code> starting at <code>offset</code> and their
+	 * lengths in <code>sigLengths</code>. Returns the number of bytes
+	 * stored. This implementation is not supported.
+	 */
+	public int engineSignAll(List<ByteBuffer> messages, byte[] outbuf,
+		int offset, int[] sigLengths)
+		throws SignatureException, TokenException
+	{
+		throw new UnsupportedOperationException(
+			"Batch signing is not supported by this implementation");
+	}
+
+	/**
+	 * Returns an upper bound on the length of the signatures produced
+	 * with the current signing key. This implementation is not supported.
+	 */
+	public int engineGetMaxSignatureLength()
+		throws SignatureException, TokenException
+	{
+		throw new UnsupportedOperationException(
+			"Signature length is not known to this implementation");
+	}
+
 	public abstract boolean engineVerify(byte[] sigBytes)
 		throws SignatureException, TokenException;
 
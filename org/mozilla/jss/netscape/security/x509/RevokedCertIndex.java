@@ -0,0 +1,337 @@
+// --- BEGIN COPYRIGHT BLOCK ---
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// (C) 2007 Red Hat, Inc.
+// All rights reserved.
+// --- END COPYRIGHT BLOCK ---
+package org.mozilla.jss.netscape.security.x509;
+
+import java.io.IOException;
+import java.io.OutputStream;
+import java.math.BigInteger;
+import java.security.cert.CRLException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+import org.mozilla.jss.netscape.security.util.DerValue;
+
+/**
+ * An index over the revokedCertificates of a DER encoded CRL, used by
+ * <code>X509CRLImpl</code> instead of decoding every entry up front.
+ * <p>
+ * The index keeps the encoded CRL and the offset of each entry in it,
+ * sorted by serial number, which takes four bytes per entry. Building it
+ * checks only the structure of each entry: that it fits in the list, that
+ * it starts with a serial number and a revocation date, and that anything
+ * after them is a SEQUENCE of extensions. No entry is decoded then.
+ * Lookups binary search the offsets, comparing serial numbers in place,
+ * and decode only the entry that was asked for, so an entry whose dates or
+ * extensions cannot be decoded is reported when it is looked up. The index
+ * is never modified once built, so it may be searched from any number of
+ * threads without locking.
+ */
+final class RevokedCertIndex {
+
+    private final byte[] der; // DER encoded CRL
+    private final int start; // first entry
+    private final int end; // end of the last entry
+    private final int[] entries; // entry offsets, sorted by serial number
+
+    private RevokedCertIndex(byte[] der, int start, int end, int[] entries) {
+        this.der = der;
+        this.start = start;
+        this.end = end;
+        this.entries = entries;
+    }
+
+    /**
+     * Builds the index for a DER encoded CRL. The array is referenced,
+     * not copied, and must not be modified afterwards.
+     *
+     * @param crl the encoded CRL.
+     * @param v1 true if this is a v1 CRL, whose entries may not have
+     *            extensions.
+     * @exception CRLException if the list of entries is malformed, or if
+     *                two entries have the same serial number.
+     */
+    static RevokedCertIndex build(byte[] crl, boolean v1)
+            throws CRLException {
+        // CertificateList and TBSCertList
+        int crlEnd = endOf(crl, 0, crl.length, DerValue.tag_Sequence);
+        int tbs = contentsOf(crl, 0);
+        int tbsEnd = endOf(crl, tbs, crlEnd, DerValue.tag_Sequence);
+        int pos = contentsOf(crl, tbs);
+
+        // Skip version, signature and issuer up to thisUpdate, then
+        // thisUpdate and nextUpdate. Only revokedCertificates can follow
+        // as a SEQUENCE.
+        while (pos < tbsEnd && !isTime(crl[pos]))
+            pos = endOf(crl, pos, tbsEnd, (byte) 0);
+        if (pos < tbsEnd)
+            pos = endOf(crl, pos, tbsEnd, (byte) 0);
+        if (pos < tbsEnd && isTime(crl[pos]))
+            pos = endOf(crl, pos, tbsEnd, (byte) 0);
+
+        if (pos >= tbsEnd || crl[pos] != DerValue.tag_Sequence)
+            return new RevokedCertIndex(crl, 0, 0, new int[0]);
+
+        int listEnd = endOf(crl, pos, tbsEnd, DerValue.tag_Sequence);
+        int first = contentsOf(crl, pos);
+
+        int[] entries = new int[16];
+        int count = 0;
+        for (pos = first; pos < listEnd;) {
+            int entryEnd = endOf(crl, pos, listEnd, DerValue.tag_Sequence);
+
+            // userCertificate, revocationDate, crlEntryExtensions OPTIONAL
+            int serial = contentsOf(crl, pos);
+            int date = endOf(crl, serial, entryEnd, DerValue.tag_Integer);
+            if (lengthOf(crl, serial) == 0)
+                throw new CRLException("Invalid encoding, empty serial number");
+            if (date >= entryEnd || !isTime(crl[date]))
+                throw new CRLException("Invalid encoding for revocationDate");
+            int exts = endOf(crl, date, entryEnd, (byte) 0);
+            if (exts < entryEnd) {
+                if (v1)
+                    throw new CRLException("Invalid encoding, extensions" +
+                            " not supported in CRL v1 entries.");
+                if (endOf(crl, exts, entryEnd, DerValue.tag_Sequence) != entryEnd)
+                    throw new CRLException("Invalid encoding, data after" +
+                            " the extensions at " + exts);
+            }
+
+            if (count == entries.length)
+                entries = Arrays.copyOf(entries, count * 2);
+            entries[count++] = pos;
+            pos = entryEnd;
+        }
+        entries = Arrays.copyOf(entries, count);
+
+        RevokedCertIndex index = new RevokedCertIndex(crl, first, listEnd,
+                entries);
+        index.sort();
+        for (int i = 1; i < entries.length; i++) {
+            if (index.compareEntries(entries[i - 1], entries[i]) == 0)
+                throw new CRLException("Invalid encoding, duplicate serial" +
+                        " number at " + entries[i]);
+        }
+        return index;
+    }
+
+    /**
+     * Returns the number of entries.
+     */
+    int size() {
+        return entries.length;
+    }
+
+    /**
+     * Returns true if there is an entry for the serial number.
+     */
+    boolean contains(BigInteger serialNumber) {
+        return find(serialNumber) >= 0;
+    }
+
+    /**
+     * Decodes the entry for the serial number.
+     *
+     * @return the entry, or null if there is none.
+     * @exception CRLException on parsing errors.
+     * @exception X509ExtensionException on extension parsing errors.
+     */
+    RevokedCertImpl get(BigInteger serialNumber)
+            throws CRLException, X509ExtensionException {
+        int entry = find(serialNumber);
+        if (entry < 0)
+            return null;
+        return decode(der, entry);
+    }
+
+    /**
+     * Decodes every entry, in the order they appear in the CRL.
+     *
+     * @exception CRLException on parsing errors.
+     * @exception X509ExtensionException on extension parsing errors.
+     */
+    List<RevokedCertImpl> decodeAll()
+            throws CRLException, X509ExtensionException {
+        List<RevokedCertImpl> list = new ArrayList<RevokedCertImpl>(entries.length);
+        for (int pos = start; pos < end; pos = contentsOf(der, pos) + lengthOf(der, pos))
+            list.add(decode(der, pos));
+        return list;
+    }
+
+    /**
+     * Writes the encoded entries, in the order they appear in the CRL,
+     * without the enclosing SEQUENCE header.
+     */
+    void encode(OutputStream out) throws IOException {
+        out.write(der, start, end - start);
+    }
+
+    private static RevokedCertImpl decode(byte[] der, int entry)
+            throws CRLException, X509ExtensionException {
+        int length = contentsOf(der, entry) + lengthOf(der, entry) - entry;
+        try {
+            return new RevokedCertImpl(new DerValue(der, entry, length));
+        } catch (IOException e) {
+            throw new CRLException("Parsing error: " + e.getMessage());
+        }
+    }
+
+    // Returns the offset of the entry for the serial number, or -1.
+    private int find(BigInteger serialNumber) {
+        byte[] key = serialNumber.toByteArray();
+        int low = 0;
+        int high = entries.length - 1;
+        while (low <= high) {
+            int mid = (low + high) >>> 1;
+            int serial = contentsOf(der, entries[mid]);
+            int cmp = compareSerials(der, contentsOf(der, serial),
+                    lengthOf(der, serial), key, 0, key.length);
+            if (cmp < 0)
+                low = mid + 1;
+            else if (cmp > 0)
+                high = mid - 1;
+            else
+                return entries[mid];
+        }
+        return -1;
+    }
+
+    private int compareEntries(int left, int right) {
+        int l = contentsOf(der, left);
+        int r = contentsOf(der, right);
+        return compareSerials(der, contentsOf(der, l), lengthOf(der, l),
+                der, contentsOf(der, r), lengthOf(der, r));
+    }
+
+    // Sorts the entries by serial number. CRLs are usually issued in
+    // serial number order already, so check for that first.
+    private void sort() {
+        boolean sorted = true;
+        for (int i = 1; i < entries.length && sorted; i++)
+            sorted = compareEntries(entries[i - 1], entries[i]) <= 0;
+        if (sorted)
+            return;
+
+        // bottom-up merge sort, without boxing the offsets
+        int n = entries.length;
+        int[] from = entries;
+        int[] to = new int[n];
+        for (int width = 1; width < n; width *= 2) {
+            for (int lo = 0; lo < n; lo += 2 * width) {
+                int mid = Math.min(lo + width, n);
+                int hi = Math.min(lo + 2 * width, n);
+                int i = lo;
+                int j = mid;
+                for (int k = lo; k < hi; k++) {
+                    if (i < mid && (j >= hi || compareEntries(from[i], from[j]) <= 0))
+                        to[k] = from[i++];
+                    else
+                        to[k] = from[j++];
+                }
+            }
+            int[] swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from != entries)
+            System.arraycopy(from, 0, entries, 0, n);
+    }
+
+    /*
+     * Compares two DER INTEGER contents numerically: two's complement,
+     * big endian, possibly with redundant leading sign octets.
+     */
+    static int compareSerials(byte[] a, int aOff, int aLen,
+                              byte[] b, int bOff, int bLen) {
+        boolean aNeg = a[aOff] < 0;
+        boolean bNeg = b[bOff] < 0;
+        if (aNeg != bNeg)
+            return aNeg ? -1 : 1;
+
+        byte sign = aNeg ? (byte) 0xff : 0;
+        while (aLen > 1 && a[aOff] == sign && (a[aOff + 1] < 0) == aNeg) {
+            aOff++;
+            aLen--;
+        }
+        while (bLen > 1 && b[bOff] == sign && (b[bOff + 1] < 0) == bNeg) {
+            bOff++;
+            bLen--;
+        }
+
+        // more octets means further from zero
+        if (aLen != bLen)
+            return (aLen < bLen) != aNeg ? -1 : 1;
+
+        for (int i = 0; i < aLen; i++) {
+            int diff = (a[aOff + i] & 0xff) - (b[bOff + i] & 0xff);
+            if (diff != 0)
+                return diff;
+        }
+        return 0;
+    }
+
+    private static boolean isTime(byte tag) {
+        return tag == DerValue.tag_UtcTime || tag == DerValue.tag_GeneralizedTime;
+    }
+
+    /*
+     * The helpers below read the tag and length octets of the value at
+     * pos. contentsOf and lengthOf assume the value has already been
+     * checked by endOf.
+     */
+
+    private static int contentsOf(byte[] der, int pos) {
+        int b = der[pos + 1] & 0xff;
+        return (b < 0x80) ? pos + 2 : pos + 2 + (b & 0x7f);
+    }
+
+    private static int lengthOf(byte[] der, int pos) {
+        int b = der[pos + 1] & 0xff;
+        if (b < 0x80)
+            return b;
+        int length = 0;
+        for (int i = 0; i < (b & 0x7f); i++)
+            length = (length << 8) | (der[pos + 2 + i] & 0xff);
+        return length;
+    }
+
+    // Checks that the value at pos has the given tag (any tag if 0) and
+    // fits before limit, and returns the offset just past it.
+    private static int endOf(byte[] der, int pos, int limit, byte tag)
+            throws CRLException {
+        if (pos + 2 > limit)
+            throw new CRLException("Invalid encoding, truncated value at " + pos);
+        if (tag != 0 && der[pos] != tag)
+            throw new CRLException("Invalid encoding, expected tag " + tag +
+                    " at " + pos + " but found " + der[pos]);
+        if ((der[pos] & 0x1f) == 0x1f)
+            throw new CRLException("Invalid encoding, unexpected tag at " + pos);
+
+        int b = der[pos + 1] & 0xff;
+        if (b == 0x80 || b > 0x84)
+            throw new CRLException("Invalid encoding, unsupported length at " + pos);
+        int contents = contentsOf(der, pos);
+        if (contents > limit)
+            throw new CRLException("Invalid encoding, truncated value at " + pos);
+        int length = lengthOf(der, pos);
+        if (length < 0 || length > limit - contents)
+            throw new CRLException("Invalid encoding, value at " + pos +
+                    " overruns its container");
+        return contents + length;
+    }
+}
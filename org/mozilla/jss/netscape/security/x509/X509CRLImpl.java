@@ -21,6 +21,7 @@ import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
 import java.math.BigInteger;
+import java.security.GeneralSecurityException;
 import java.security.InvalidKeyException;
 import java.security.NoSuchAlgorithmException;
 import java.security.NoSuchProviderException;
@@ -102,6 +103,8 @@ public class X509CRLImpl extends X509CRL {
     private Date nextUpdate = null;
     //    private static final Hashtable revokedCerts = new Hashtable();
     private Hashtable<BigInteger, RevokedCertificate> revokedCerts = new Hashtable<BigInteger, RevokedCertificate>();
+    // used instead of revokedCerts when the entries are indexed
+    private RevokedCertIndex revokedIndex = null;
     //    private static CRLExtensions    extensions = null;
     private CRLExtensions extensions = null;
     private boolean entriesIncluded = true;
@@ -134,11 +137,40 @@ public class X509CRLImpl extends X509CRL {
 
     public X509CRLImpl(byte[] crlData, boolean includeEntries)
             throws CRLException, X509ExtensionException {
+        this(crlData, includeEntries, false);
+    }
+
+    /**
+     * Unmarshals an X.509 CRL from its encoded form, optionally
+     * indexing the revoked certificates instead of decoding them.
+     * <p>
+     * An indexed CRL keeps <code>crlData</code>, which must not be
+     * modified afterwards, and the offsets of its entries sorted by
+     * serial number. <code>isRevoked</code> and
+     * <code>getRevokedCertificate</code> binary search the offsets and
+     * decode only the entry asked for, without locking. This suits very
+     * large CRLs that are mostly used for lookups. Only the structure of
+     * the entries is checked here, along with duplicate serial numbers;
+     * an entry whose dates or extensions cannot be decoded makes the
+     * methods that decode it throw <code>IllegalStateException</code>.
+     *
+     * @param crlData the encoded bytes, with no trailing padding.
+     * @param includeEntries false to ignore the revoked certificates.
+     * @param indexEntries true to index the revoked certificates rather
+     *            than keep them decoded.
+     * @exception CRLException on parsing errors.
+     * @exception X509ExtensionException on extension handling errors.
+     */
+    public X509CRLImpl(byte[] crlData, boolean includeEntries,
+                       boolean indexEntries)
+            throws CRLException, X509ExtensionException {
         try {
             entriesIncluded = includeEntries;
             DerValue in = new DerValue(crlData);
 
-            parse(in, includeEntries);
+            parse(in, includeEntries && !indexEntries);
+            if (includeEntries && indexEntries)
+                revokedIndex = RevokedCertIndex.build(crlData, version == 0);
             signedCRL = crlData;
         } catch (IOException e) {
             throw new CRLException("Parsing error: " + e.getMessage());
@@ -341,7 +373,12 @@ public class X509CRLImpl extends X509CRL {
             if (nextUpdate != null)
                 tmp.putUTCTime(nextUpdate);
 
-            if (!revokedCerts.isEmpty()) {
+            if (revokedIndex != null) {
+                if (revokedIndex.size() != 0) {
+                    revokedIndex.encode(rCerts);
+                    tmp.write(DerValue.tag_Sequence, rCerts);
+                }
+            } else if (!revokedCerts.isEmpty()) {
                 for (Enumeration<RevokedCertificate> e = revokedCerts.elements(); e.hasMoreElements();)
                     ((RevokedCertImpl) e.nextElement()).encode(rCerts);
                 tmp.write(DerValue.tag_Sequence, rCerts);
@@ -532,7 +569,19 @@ public class X509CRLImpl extends X509CRL {
                 + "\n");
         if (nextUpdate != null)
             sb.append("Next Update: " + nextUpdate + "\n");
-        if (revokedCerts.isEmpty())
+        if (revokedIndex != null) {
+            if (revokedIndex.size() == 0)
+                sb.append("\nNO certificates have been revoked\n");
+            else {
+                sb.append("\nRevoked Certificates:\n");
+                try {
+                    for (RevokedCertImpl entry : revokedIndex.decodeAll())
+                        sb.append(entry);
+                } catch (GeneralSecurityException e) {
+                    sb.append(e.getMessage());
+                }
+            }
+        } else if (revokedCerts.isEmpty())
             sb.append("\nNO certificates have been revoked\n");
         else {
             sb.append("\nRevoked Certificates:\n");
@@ -560,6 +609,8 @@ public class X509CRLImpl extends X509CRL {
      *         false otherwise.
      */
     public boolean isRevoked(BigInteger serialNumber) {
+        if (revokedIndex != null)
+            return revokedIndex.contains(serialNumber);
         if (revokedCerts == null || revokedCerts.isEmpty())
             return false;
         return revokedCerts.containsKey(serialNumber);
@@ -657,6 +708,13 @@ public class X509CRLImpl extends X509CRL {
      * @see RevokedCertificate
      */
     public X509CRLEntry getRevokedCertificate(BigInteger serialNumber) {
+        if (revokedIndex != null) {
+            try {
+                return revokedIndex.get(serialNumber);
+            } catch (GeneralSecurityException e) {
+                throw indexedEntryError(e);
+            }
+        }
         if (revokedCerts == null || revokedCerts.isEmpty())
             return null;
         return revokedCerts.get(serialNumber);
@@ -671,6 +729,15 @@ public class X509CRLImpl extends X509CRL {
      * @see RevokedCertificate
      */
     public Set<RevokedCertificate> getRevokedCertificates() {
+        if (revokedIndex != null) {
+            if (revokedIndex.size() == 0)
+                return null;
+            try {
+                return new LinkedHashSet<RevokedCertificate>(revokedIndex.decodeAll());
+            } catch (GeneralSecurityException e) {
+                throw indexedEntryError(e);
+            }
+        }
         if (revokedCerts == null || revokedCerts.isEmpty())
             return null;
         else {
@@ -681,6 +748,17 @@ public class X509CRLImpl extends X509CRL {
 
     @SuppressWarnings("unchecked")
     public Hashtable<BigInteger, RevokedCertificate> getListOfRevokedCertificates() {
+        if (revokedIndex != null) {
+            Hashtable<BigInteger, RevokedCertificate> list =
+                    new Hashtable<BigInteger, RevokedCertificate>();
+            try {
+                for (RevokedCertImpl entry : revokedIndex.decodeAll())
+                    list.put(entry.getSerialNumber(), entry);
+            } catch (GeneralSecurityException e) {
+                throw indexedEntryError(e);
+            }
+            return list;
+        }
         if (revokedCerts == null) {
             return null;
         } else {
@@ -688,7 +766,20 @@ public class X509CRLImpl extends X509CRL {
         }
     }
 
+    /*
+     * Indexed entries are decoded on demand. Fail closed on one that
+     * cannot be decoded rather than report the certificate as not
+     * revoked.
+     */
+    private static IllegalStateException indexedEntryError(
+            GeneralSecurityException e) {
+        return new IllegalStateException("Indexed CRL entry could not be" +
+                " decoded: " + e.getMessage(), e);
+    }
+
     public int getNumberOfRevokedCertificates() {
+        if (revokedIndex != null)
+            return revokedIndex.size();
         if (revokedCerts == null)
             return -1;
         else
@@ -0,0 +1,329 @@
+// --- BEGIN COPYRIGHT BLOCK ---
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// (C) 2007 Red Hat, Inc.
+// All rights reserved.
+// --- END COPYRIGHT BLOCK ---
+package org.mozilla.jss.netscape.security.x509;
+
+import java.io.IOException;
+import java.io.OutputStream;
+import java.math.BigInteger;
+import java.security.InvalidKeyException;
+import java.security.NoSuchAlgorithmException;
+import java.security.NoSuchProviderException;
+import java.security.PrivateKey;
+import java.security.Signature;
+import java.security.SignatureException;
+import java.security.cert.CRLException;
+import java.security.interfaces.RSAKey;
+import java.util.Date;
+
+import org.mozilla.jss.netscape.security.util.BigInt;
+import org.mozilla.jss.netscape.security.util.DerOutputStream;
+import org.mozilla.jss.netscape.security.util.DerValue;
+
+/**
+ * Writes a signed X.509 CRL to a stream without holding its revoked
+ * certificates in memory.
+ * <p>
+ * <code>X509CRLImpl.sign</code> builds the whole CRL in memory, which
+ * takes several times the size of the encoded CRL. This class instead
+ * reads the revoked certificates from an <code>Iterable</code>, for
+ * example a database cursor, and encodes them one at a time. Each byte
+ * of the TBSCertList is written to the output and passed to the
+ * signature as it is produced, so memory use does not depend on the
+ * number of entries. With the Mozilla-JSS provider the signature is
+ * computed by a PK11Signature context, so keys on a token can be used.
+ * <p>
+ * DER needs the length of every SEQUENCE before its contents, so the
+ * entries are read once to measure them and again to write them. The
+ * <code>Iterable</code> must return the same entries, in the same order,
+ * each time it is iterated. For RSA keys the length of the signature is
+ * known in advance and the CRL is written in that second pass. For other
+ * keys the signature must be computed before the CRL can be written, so
+ * the entries are read a third time.
+ * <p>
+ * The output is not buffered or closed by this class; wrap a file
+ * stream in a <code>BufferedOutputStream</code>.
+ *
+ * @see X509CRLImpl
+ */
+public class X509CRLWriter {
+
+    private final static boolean isExplicit = true;
+
+    private X500Name issuer;
+    private Date thisUpdate;
+    private Date nextUpdate;
+    private Iterable<? extends RevokedCertificate> revokedCerts;
+    private CRLExtensions extensions;
+
+    /**
+     * Creates a writer for a CRL with the given revoked certificates and
+     * extensions.
+     *
+     * @param issuer the name of the CA issuing this CRL.
+     * @param thisDate the Date of this issue.
+     * @param nextDate the Date of the next CRL, or null.
+     * @param badCerts the revoked certificates. Each call to
+     *            <code>sign</code> iterates over them two or three
+     *            times, and every iteration must return the same
+     *            entries in the same order. A one-shot source such as
+     *            an open cursor must be wrapped in an
+     *            <code>Iterable</code> that re-runs the query. If the
+     *            entries change, the CRL written is wrong or signing
+     *            fails with a CRLException.
+     * @param crlExts the CRL extensions, or null.
+     */
+    public X509CRLWriter(X500Name issuer, Date thisDate, Date nextDate,
+                         Iterable<? extends RevokedCertificate> badCerts,
+                         CRLExtensions crlExts) {
+        this.issuer = issuer;
+        this.thisUpdate = thisDate;
+        this.nextUpdate = nextDate;
+        this.revokedCerts = badCerts;
+        this.extensions = crlExts;
+    }
+
+    /**
+     * Signs the CRL with the default provider and writes its DER
+     * encoding to the output stream.
+     *
+     * @param key the private key used for signing.
+     * @param algorithm the name of the signature algorithm used.
+     * @param out the stream to write the CRL to.
+     *
+     * @exception NoSuchAlgorithmException on unsupported signature
+     *                algorithms.
+     * @exception InvalidKeyException on incorrect key.
+     * @exception NoSuchProviderException on incorrect provider.
+     * @exception SignatureException on signature errors.
+     * @exception CRLException if any mandatory data was omitted, or
+     *                on encoding and output errors.
+     * @exception X509ExtensionException on extension encoding errors.
+     */
+    public void sign(PrivateKey key, String algorithm, OutputStream out)
+            throws CRLException, NoSuchAlgorithmException, InvalidKeyException,
+            NoSuchProviderException, SignatureException, X509ExtensionException {
+        sign(key, algorithm, null, out);
+    }
+
+    /**
+     * Signs the CRL and writes its DER encoding to the output stream.
+     * Nothing is written if the revoked certificates cannot be encoded,
+     * but the output is incomplete if they change between passes or
+     * signing fails part way.
+     *
+     * @param key the private key used for signing.
+     * @param algorithm the name of the signature algorithm used.
+     * @param provider the name of the provider, or null for the default.
+     * @param out the stream to write the CRL to.
+     *
+     * @exception NoSuchAlgorithmException on unsupported signature
+     *                algorithms.
+     * @exception InvalidKeyException on incorrect key.
+     * @exception NoSuchProviderException on incorrect provider.
+     * @exception SignatureException on signature errors.
+     * @exception CRLException if any mandatory data was omitted, or
+     *                on encoding and output errors.
+     * @exception X509ExtensionException on extension encoding errors.
+     */
+    public void sign(PrivateKey key, String algorithm, String provider,
+                     OutputStream out)
+            throws CRLException, NoSuchAlgorithmException, InvalidKeyException,
+            NoSuchProviderException, SignatureException, X509ExtensionException {
+        if (issuer == null || thisUpdate == null)
+            throw new CRLException("Null Issuer or thisUpdate");
+
+        Signature sigEngine = null;
+        if (provider == null)
+            sigEngine = Signature.getInstance(algorithm);
+        else
+            sigEngine = Signature.getInstance(algorithm, provider);
+
+        sigEngine.initSign(key);
+        AlgorithmId sigAlgId = AlgorithmId.get(sigEngine.getAlgorithm());
+
+        try {
+            // measure the entries, and see whether any need v2
+            DerOutputStream entry = new DerOutputStream();
+            long entriesLength = 0;
+            boolean v2 = (extensions != null);
+            for (RevokedCertificate badCert : revokedCerts) {
+                entry.reset();
+                ((RevokedCertImpl) badCert).encode(entry);
+                entriesLength += entry.size();
+                if (badCert.hasExtensions())
+                    v2 = true;
+            }
+
+            // everything before and after the entries is small
+            DerOutputStream head = new DerOutputStream();
+            if (v2) // v2 crl encode version
+                head.putInteger(new BigInt(1));
+            sigAlgId.encode(head);
+            issuer.encode(head);
+
+            // from 2050 should encode GeneralizedTime
+            head.putUTCTime(thisUpdate);
+
+            if (nextUpdate != null)
+                head.putUTCTime(nextUpdate);
+
+            DerOutputStream tail = new DerOutputStream();
+            if (extensions != null)
+                extensions.encode(tail, isExplicit);
+
+            DerOutputStream algId = new DerOutputStream();
+            sigAlgId.encode(algId);
+
+            long infoLength = head.size() + tail.size();
+            if (entriesLength != 0)
+                infoLength += headerLength(entriesLength) + entriesLength;
+            long tbsLength = headerLength(infoLength) + infoLength;
+
+            int sigLength = signatureLength(key);
+            byte[] signature;
+
+            if (sigLength < 0) {
+                // sign first, then write
+                encodeInfo(new SignatureOutputStream(sigEngine, null),
+                        infoLength, head, entriesLength, tail);
+                signature = sigEngine.sign();
+
+                writeHeader(out, DerValue.tag_Sequence, tbsLength +
+                        algId.size() + bitStringLength(signature.length));
+                encodeInfo(out, infoLength, head, entriesLength, tail);
+            } else {
+                // sign while writing
+                writeHeader(out, DerValue.tag_Sequence, tbsLength +
+                        algId.size() + bitStringLength(sigLength));
+                encodeInfo(new SignatureOutputStream(sigEngine, out),
+                        infoLength, head, entriesLength, tail);
+                signature = sigEngine.sign();
+
+                if (signature.length != sigLength)
+                    throw new CRLException("Signature is " + signature.length +
+                            " bytes, expected " + sigLength);
+            }
+
+            algId.writeTo(out);
+            writeHeader(out, DerValue.tag_BitString, signature.length + 1);
+            out.write(0); // all of last octet is used
+            out.write(signature);
+
+        } catch (IOException e) {
+            if (e.getCause() instanceof SignatureException)
+                throw (SignatureException) e.getCause();
+            throw new CRLException("Error while encoding data: " +
+                                   e.getMessage());
+        }
+    }
+
+    /*
+     * Writes the TBSCertList, encoding the entries again. They must add
+     * up to the length measured before, or the lengths already written
+     * would be wrong.
+     */
+    private void encodeInfo(OutputStream out, long infoLength,
+                            DerOutputStream head, long entriesLength,
+                            DerOutputStream tail)
+            throws CRLException, X509ExtensionException, IOException {
+        writeHeader(out, DerValue.tag_Sequence, infoLength);
+        head.writeTo(out);
+
+        if (entriesLength != 0) {
+            writeHeader(out, DerValue.tag_Sequence, entriesLength);
+            DerOutputStream entry = new DerOutputStream();
+            long written = 0;
+            for (RevokedCertificate badCert : revokedCerts) {
+                entry.reset();
+                ((RevokedCertImpl) badCert).encode(entry);
+                written += entry.size();
+                if (written > entriesLength)
+                    break;
+                entry.writeTo(out);
+            }
+            if (written != entriesLength)
+                throw new CRLException("Revoked certificates changed while" +
+                        " writing the CRL");
+        }
+
+        tail.writeTo(out);
+    }
+
+    /*
+     * Returns the length of a signature made with the key, or -1 if it
+     * is not known before signing. RSA signatures are as long as the
+     * modulus; DSA and ECDSA signatures are DER encoded and vary.
+     */
+    private static int signatureLength(PrivateKey key) {
+        if (!(key instanceof RSAKey))
+            return -1;
+        BigInteger modulus = ((RSAKey) key).getModulus();
+        if (modulus == null)
+            return -1;
+        return (modulus.bitLength() + 7) / 8;
+    }
+
+    private static long bitStringLength(int sigLength) {
+        return headerLength(sigLength + 1) + sigLength + 1;
+    }
+
+    private static int headerLength(long length) {
+        if (length < 128)
+            return 2;
+        return 2 + (64 - Long.numberOfLeadingZeros(length) + 7) / 8;
+    }
+
+    private static void writeHeader(OutputStream out, byte tag, long length)
+            throws IOException {
+        if (length > Integer.MAX_VALUE)
+            throw new IOException("CRL is too large: " + length + " bytes");
+        DerOutputStream header = new DerOutputStream(6);
+        header.write(tag);
+        header.putLength((int) length);
+        header.writeTo(out);
+    }
+
+    /*
+     * Passes everything written to it to a signature, and to another
+     * stream if there is one.
+     */
+    private static class SignatureOutputStream extends OutputStream {
+
+        private Signature sigEngine;
+        private OutputStream out;
+
+        SignatureOutputStream(Signature sigEngine, OutputStream out) {
+            this.sigEngine = sigEngine;
+            this.out = out;
+        }
+
+        public void write(int b) throws IOException {
+            write(new byte[] { (byte) b }, 0, 1);
+        }
+
+        public void write(byte[] b, int off, int len) throws IOException {
+            try {
+                sigEngine.update(b, off, len);
+            } catch (SignatureException e) {
+                throw new IOException(e);
+            }
+            if (out != null)
+                out.write(b, off, len);
+        }
+    }
+}
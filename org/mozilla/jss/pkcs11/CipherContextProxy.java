@@ -7,7 +7,7 @@ package org.mozilla.jss.pkcs11;
 import org.mozilla.jss.util.NativeProxy;
 
 final class CipherContextProxy extends NativeProxy {
-    public CipherContextProxy(byte[] pointer) {
+    public CipherContextProxy(long pointer) {
         super(pointer);
     }
 
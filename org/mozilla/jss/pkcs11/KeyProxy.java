@@ -5,7 +5,7 @@ package org.mozilla.jss.pkcs11;
 
 abstract class KeyProxy extends org.mozilla.jss.util.NativeProxy {
 
-    protected KeyProxy(byte[] pointer) {
+    protected KeyProxy(long pointer) {
         super(pointer);
     }
 
@@ -7,7 +7,7 @@ package org.mozilla.jss.pkcs11;
 import org.mozilla.jss.util.*;
 
 final class ModuleProxy extends NativeProxy {
-    ModuleProxy(byte[] pointer) {
+    ModuleProxy(long pointer) {
         super(pointer);
     }
 
@@ -384,16 +384,16 @@ JSS_PK11_wrapCertAndSlotAndNickname(JNIEnv *env, CERTCertificate **cert,
 {
 	jclass certClass;
 	jmethodID constructor;
-	jbyteArray certPtr;
-	jbyteArray slotPtr;
+	jlong certPtr;
+	jlong slotPtr;
 	jstring jnickname = NULL;
 	jobject Cert=NULL;
 
 	PR_ASSERT(env!=NULL && cert!=NULL && *cert!=NULL
 		&& slot!=NULL);
 
-	certPtr = JSS_ptrToByteArray(env, *cert);
-	slotPtr = JSS_ptrToByteArray(env, *slot);
+	certPtr = JSS_ptrToLong(*cert);
+	slotPtr = JSS_ptrToLong(*slot);
 	if (nickname) {
 		jnickname = (*env)->NewStringUTF(env, nickname);
 	}
@@ -113,9 +113,9 @@ public class PK11Cert implements org.mozilla.jss.crypto.X509Certificate {
 	//	this.certProxy = proxy;
 	//}
 
-	PK11Cert(byte[] certPtr, byte[] slotPtr, String nickname) {
-        Assert._assert(certPtr!=null);
-        Assert._assert(slotPtr!=null);
+	PK11Cert(long certPtr, long slotPtr, String nickname) {
+        Assert._assert(certPtr!=0);
+        Assert._assert(slotPtr!=0);
 		certProxy = new CertProxy(certPtr);
 		tokenProxy = new TokenProxy(slotPtr);
 		this.nickname = nickname;
@@ -135,7 +135,7 @@ class CertProxy extends org.mozilla.jss.util.NativeProxy {
 
     public static Logger logger = LoggerFactory.getLogger(CertProxy.class);
 
-    public CertProxy(byte[] pointer) {
+    public CertProxy(long pointer) {
         super(pointer);
     }
 
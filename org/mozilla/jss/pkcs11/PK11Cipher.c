@@ -9,9 +9,11 @@
 #include <seccomon.h>
 #include <pk11func.h>
 #include <secitem.h>
+#include <string.h>
 
 /* JSS includes */
 #include <java_ids.h>
+#include <jss_ids.h>
 #include <jss_exceptions.h>
 #include <jssutil.h>
 #include <pk11util.h>
@@ -239,6 +241,194 @@ finish:
     
 
 
+/*
+ * Byte arrays are copied through native buffers this many bytes at a
+ * time rather than pinned while the token works, since a token call can
+ * block and a pinned array holds off the garbage collector. The size is
+ * a multiple of every cipher block size, so only the last chunk of an
+ * input can end part way through a block.
+ */
+#define CIPHER_CHUNK_SIZE 8192
+
+/*
+ * Room for the output of one chunk, plus the data a padded mode holds
+ * back from earlier calls or adds when it is finalized.
+ */
+#define CIPHER_SCRATCH_SIZE (CIPHER_CHUNK_SIZE + 64)
+
+/*
+ * Resolves one side of a cipherOpInto call: a direct ByteBuffer is
+ * resolved to its address, while a byte array is copied in chunks.
+ */
+static unsigned char *
+getDirectAddress(JNIEnv *env, jobject buf, PRBool *isArray)
+{
+    unsigned char *addr;
+
+    *isArray = PR_FALSE;
+    if( buf == NULL ) {
+        return NULL;
+    }
+    addr = (unsigned char*) (*env)->GetDirectBufferAddress(env, buf);
+    if( addr == NULL ) {
+        *isArray = PR_TRUE;
+    }
+    return addr;
+}
+
+/*
+ * Frees a chunk buffer, clearing it first since it may hold plaintext.
+ */
+static void
+freeChunk(unsigned char *chunk, size_t len)
+{
+    if( chunk != NULL ) {
+        memset(chunk, 0, len);
+        PR_Free(chunk);
+    }
+}
+
+/***********************************************************************
+ *
+ * PK11Cipher.cipherOpInto
+ *
+ * Runs input through the context and, if doFinal is set, finalizes it,
+ * writing all output into the caller's buffer. Each of input and output
+ * is either a byte array or a direct ByteBuffer; the offsets and lengths
+ * have been checked by the caller. Direct buffers are used in place.
+ * Byte arrays are copied through native buffers in chunks of
+ * CIPHER_CHUNK_SIZE bytes, so neither array is pinned during a token
+ * call. Output never runs ahead of the input consumed, so working in
+ * place in one array is safe.
+ *
+ * RETURNS
+ *      The number of bytes written to output, or -1 if an exception was
+ *      thrown.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_pkcs11_PK11Cipher_cipherOpInto
+    (JNIEnv *env, jclass clazz, jobject contextObj, jobject input,
+        jint inOffset, jint inLen, jobject output, jint outOffset,
+        jint outLen, jboolean doFinal)
+{
+    PK11Context *context=NULL;
+    unsigned char *inbuf=NULL, *outbuf=NULL;
+    unsigned char *inChunk=NULL, *outChunk=NULL;
+    unsigned char *in, *out;
+    PRBool inIsArray=PR_FALSE, outIsArray=PR_FALSE;
+    jint chunkSize, consumed = 0, written = 0;
+    jint n;
+    int opLen, maxOut;
+    unsigned int finalLen;
+    jint retval = -1;
+
+    PR_ASSERT(env!=NULL && contextObj!=NULL && output!=NULL);
+    PR_ASSERT(inOffset >= 0 && inLen >= 0 && outOffset >= 0 && outLen >= 0);
+
+    if( JSS_PK11_getCipherContext(env, contextObj, &context) != PR_SUCCESS) {
+        goto finish;
+    }
+
+    inbuf = getDirectAddress(env, input, &inIsArray);
+    outbuf = getDirectAddress(env, output, &outIsArray);
+
+    if( inIsArray ) {
+        inChunk = PR_Malloc(CIPHER_CHUNK_SIZE);
+        if( inChunk == NULL ) {
+            JSS_throw(env, OUT_OF_MEMORY_ERROR);
+            goto finish;
+        }
+    }
+    if( outIsArray ) {
+        outChunk = PR_Malloc(CIPHER_SCRATCH_SIZE);
+        if( outChunk == NULL ) {
+            JSS_throw(env, OUT_OF_MEMORY_ERROR);
+            goto finish;
+        }
+    }
+    chunkSize = (inIsArray || outIsArray) ? CIPHER_CHUNK_SIZE : inLen;
+
+    while( consumed < inLen ) {
+        n = inLen - consumed;
+        if( n > chunkSize ) {
+            n = chunkSize;
+        }
+        if( inIsArray ) {
+            (*env)->GetByteArrayRegion(env, input, inOffset + consumed, n,
+                (jbyte*) inChunk);
+            if( (*env)->ExceptionOccurred(env) != NULL ) {
+                goto finish;
+            }
+            in = inChunk;
+        } else {
+            in = inbuf + inOffset + consumed;
+        }
+        maxOut = outLen - written;
+        if( outIsArray ) {
+            out = outChunk;
+            if( maxOut > CIPHER_SCRATCH_SIZE ) {
+                maxOut = CIPHER_SCRATCH_SIZE;
+            }
+        } else {
+            out = outbuf + outOffset + written;
+        }
+
+        if( PK11_CipherOp(context, out, &opLen, maxOut, in, n)
+                != SECSuccess )
+        {
+            JSS_throwMsgPrErrArg(env, TOKEN_EXCEPTION,
+                "Cipher context update failed", PR_GetError());
+            goto finish;
+        }
+        PR_ASSERT(opLen >= 0 && opLen <= maxOut);
+        if( outIsArray && opLen > 0 ) {
+            (*env)->SetByteArrayRegion(env, output, outOffset + written,
+                opLen, (jbyte*) outChunk);
+            if( (*env)->ExceptionOccurred(env) != NULL ) {
+                goto finish;
+            }
+        }
+        consumed += n;
+        written += opLen;
+    }
+
+    if( doFinal ) {
+        maxOut = outLen - written;
+        if( outIsArray ) {
+            out = outChunk;
+            if( maxOut > CIPHER_SCRATCH_SIZE ) {
+                maxOut = CIPHER_SCRATCH_SIZE;
+            }
+        } else {
+            out = outbuf + outOffset + written;
+        }
+
+        if( PK11_DigestFinal(context, out, &finalLen, (unsigned int) maxOut)
+                != SECSuccess )
+        {
+            JSS_throwMsgPrErrArg(env, TOKEN_EXCEPTION,
+                "Cipher context finalization failed", PR_GetError());
+            goto finish;
+        }
+        PR_ASSERT(finalLen <= (unsigned int) maxOut);
+        if( outIsArray && finalLen > 0 ) {
+            (*env)->SetByteArrayRegion(env, output, outOffset + written,
+                finalLen, (jbyte*) outChunk);
+            if( (*env)->ExceptionOccurred(env) != NULL ) {
+                goto finish;
+            }
+        }
+        written += finalLen;
+    }
+    retval = written;
+
+finish:
+    freeChunk(outChunk, CIPHER_SCRATCH_SIZE);
+    freeChunk(inChunk, CIPHER_CHUNK_SIZE);
+    PR_ASSERT( retval >= 0 || (*env)->ExceptionOccurred(env) );
+    return retval;
+}
+
 /***********************************************************************
  *
  * J S S _ P K 1 1 _ g e t C i p h e r C o n t e x t
@@ -281,36 +471,14 @@ JSS_PK11_getCipherContext(JNIEnv *env, jobject proxy, PK11Context **pContext)
 jobject
 JSS_PK11_wrapCipherContextProxy(JNIEnv *env, PK11Context **context) {
 
-    jbyteArray pointer=NULL;
-    jclass proxyClass;
-    jmethodID constructor;
     jobject contextObj=NULL;
 
     PR_ASSERT( env!=NULL && context!=NULL && *context!=NULL );
 
-    /* convert pointer to byte array */
-    pointer = JSS_ptrToByteArray(env, *context);
-
-    /*
-     * Lookup the class and constructor
-     */
-    proxyClass = (*env)->FindClass(env, CIPHER_CONTEXT_PROXY_CLASS_NAME);
-    if(proxyClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-    constructor = (*env)->GetMethodID(env, proxyClass,
-                            PLAIN_CONSTRUCTOR,
-                            CIPHER_CONTEXT_PROXY_CONSTRUCTOR_SIG);
-    if(constructor == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     /* call the constructor */
-    contextObj = (*env)->NewObject(env, proxyClass, constructor, pointer);
+    contextObj = (*env)->NewObject(env, JSS_CLASS(CipherContextProxy),
+        JSS_METHOD(CipherContextProxy, init), JSS_ptrToLong(*context));
 
-finish:
     if(contextObj == NULL) {
         /* didn't work, so free resources */
         PK11_DestroyContext( (PK11Context*)*context, PR_TRUE /*freeit*/ );
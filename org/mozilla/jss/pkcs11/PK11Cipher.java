@@ -4,12 +4,16 @@
 
 package org.mozilla.jss.pkcs11;
 
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.NoSuchAlgorithmException;
 import java.security.spec.AlgorithmParameterSpec;
+import java.util.Arrays;
 
 import javax.crypto.BadPaddingException;
+import javax.crypto.ShortBufferException;
 import javax.crypto.spec.IvParameterSpec;
 import javax.crypto.spec.RC2ParameterSpec;
 
@@ -208,6 +212,185 @@ final class PK11Cipher extends org.mozilla.jss.crypto.Cipher {
                     algorithm.isPadded() );
     }
 
+    public int update(byte[] input, int inputOffset, int inputLen,
+            byte[] output, int outputOffset)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        return cipherOp(input, inputOffset, inputLen, output, outputOffset,
+                    false);
+    }
+
+    public int update(ByteBuffer input, ByteBuffer output)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        return cipherOp(input, output, false);
+    }
+
+    public int doFinal(byte[] input, int inputOffset, int inputLen,
+            byte[] output, int outputOffset)
+        throws IllegalStateException, IllegalBlockSizeException,
+        BadPaddingException, ShortBufferException, TokenException
+    {
+        return cipherOp(input, inputOffset, inputLen, output, outputOffset,
+                    true);
+    }
+
+    public int doFinal(ByteBuffer input, ByteBuffer output)
+        throws IllegalStateException, IllegalBlockSizeException,
+        BadPaddingException, ShortBufferException, TokenException
+    {
+        return cipherOp(input, output, true);
+    }
+
+    private int cipherOp(byte[] input, int inputOffset, int inputLen,
+            byte[] output, int outputOffset, boolean doFinal)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        if( state == UNINITIALIZED ) {
+            throw new IllegalStateException();
+        }
+        if( inputLen != 0 ) {
+            checkRange(input.length, inputOffset, inputLen);
+        }
+        checkRange(output.length, outputOffset, 0);
+        int outputLen = output.length - outputOffset;
+        if( !hasRoomFor(inputLen, outputLen, doFinal) ) {
+            byte[] out = cipherOpCopy(input, inputOffset, inputLen, doFinal);
+            checkOutputSpace(out.length, outputLen);
+            System.arraycopy(out, 0, output, outputOffset, out.length);
+            return out.length;
+        }
+
+        // NSS can work in place, but not on partially overlapping regions
+        if( input == output && inputOffset != outputOffset &&
+            inputOffset < outputOffset + outputLen &&
+            outputOffset < inputOffset + inputLen )
+        {
+            input = Arrays.copyOfRange(input, inputOffset,
+                        inputOffset + inputLen);
+            inputOffset = 0;
+        }
+
+        return cipherOpInto(contextProxy, input, inputOffset, inputLen,
+                    output, outputOffset, outputLen, doFinal);
+    }
+
+    private int cipherOp(ByteBuffer input, ByteBuffer output, boolean doFinal)
+        throws IllegalStateException, ShortBufferException, TokenException
+    {
+        if( state == UNINITIALIZED ) {
+            throw new IllegalStateException();
+        }
+        if( output.isReadOnly() ) {
+            throw new ReadOnlyBufferException();
+        }
+        int inputLen = input.remaining();
+        int outputLen = output.remaining();
+        if( !hasRoomFor(inputLen, outputLen, doFinal) ) {
+            byte[] in = new byte[inputLen];
+            input.duplicate().get(in);
+            byte[] out = cipherOpCopy(in, 0, inputLen, doFinal);
+            checkOutputSpace(out.length, outputLen);
+            input.position(input.limit());
+            output.put(out);
+            return out.length;
+        }
+
+        Object in;
+        int inputOffset;
+        if( input.hasArray() ) {
+            in = input.array();
+            inputOffset = input.arrayOffset() + input.position();
+        } else if( input.isDirect() ) {
+            in = input;
+            inputOffset = input.position();
+        } else {
+            // read-only heap buffer
+            byte[] copy = new byte[inputLen];
+            input.duplicate().get(copy);
+            in = copy;
+            inputOffset = 0;
+        }
+
+        Object out;
+        int outputOffset;
+        if( output.hasArray() ) {
+            out = output.array();
+            outputOffset = output.arrayOffset() + output.position();
+        } else {
+            out = output;
+            outputOffset = output.position();
+        }
+
+        if( in == out && inputOffset != outputOffset ) {
+            byte[] copy = new byte[inputLen];
+            input.duplicate().get(copy);
+            in = copy;
+            inputOffset = 0;
+        }
+
+        int written = cipherOpInto(contextProxy, in, inputOffset, inputLen,
+                        out, outputOffset, outputLen, doFinal);
+        input.position(input.limit());
+        output.position(output.position() + written);
+        return written;
+    }
+
+    private static void checkRange(int length, int offset, int len) {
+        if( offset < 0 || len < 0 || offset > length - len ) {
+            throw new ArrayIndexOutOfBoundsException(
+                "offset " + offset + ", length " + len + ", array length " +
+                length);
+        }
+    }
+
+    /**
+     * An update can emit up to one block more than its input, since NSS
+     * may be holding back a partial block from the previous call. A final
+     * call can add a whole padding block on top of that. Only when there
+     * is room for that much can NSS write into the caller's buffer
+     * directly; PK11_DigestFinal fails outright on a short buffer, after
+     * the context is consumed.
+     */
+    private boolean hasRoomFor(int inputLen, int outputLen, boolean doFinal) {
+        long blockSize = algorithm.getBlockSize();
+        long worstCase = inputLen + (doFinal ? 2 * blockSize : blockSize);
+        return outputLen >= worstCase;
+    }
+
+    /**
+     * Fallback for output buffers too small for the worst case: the
+     * output may still fit, but it has to be produced separately first.
+     */
+    private byte[] cipherOpCopy(byte[] input, int inputOffset, int inputLen,
+            boolean doFinal)
+        throws TokenException
+    {
+        if( !doFinal ) {
+            return updateContext(contextProxy,
+                Arrays.copyOfRange(input, inputOffset, inputOffset + inputLen),
+                algorithm.getBlockSize());
+        }
+        byte[] first = (inputLen == 0) ? new byte[0] : updateContext(
+            contextProxy,
+            Arrays.copyOfRange(input, inputOffset, inputOffset + inputLen),
+            algorithm.getBlockSize());
+        byte[] last = finalizeContext(contextProxy, algorithm.getBlockSize(),
+                    algorithm.isPadded());
+        byte[] combined = Arrays.copyOf(first, first.length + last.length);
+        System.arraycopy(last, 0, combined, first.length, last.length);
+        return combined;
+    }
+
+    private static void checkOutputSpace(int needed, int outputLen)
+        throws ShortBufferException
+    {
+        if( needed > outputLen ) {
+            throw new ShortBufferException(needed + " needed, " +
+                outputLen + " supplied");
+        }
+    }
+
     private static native CipherContextProxy
     initContext(boolean encrypt, SymmetricKey key, EncryptionAlgorithm alg,
                  byte[] IV, boolean padded)
@@ -223,6 +406,20 @@ final class PK11Cipher extends org.mozilla.jss.crypto.Cipher {
     updateContext( CipherContextProxy context, byte[] input, int blocksize )
         throws TokenException;
 
+    /**
+     * Runs the input through the context, and finalizes it if
+     * <code>doFinal</code> is set, writing directly into the output.
+     * <code>input</code> and <code>output</code> are each either a byte
+     * array or a direct ByteBuffer.
+     *
+     * @return The number of bytes written to the output.
+     */
+    private static native int
+    cipherOpInto( CipherContextProxy context, Object input, int inputOffset,
+            int inputLen, Object output, int outputOffset, int outputLen,
+            boolean doFinal )
+        throws TokenException;
+
     private static native byte[]
     finalizeContext( CipherContextProxy context, int blocksize, boolean padded)
         throws TokenException, IllegalBlockSizeException, BadPaddingException;
@@ -232,7 +429,10 @@ final class PK11Cipher extends org.mozilla.jss.crypto.Cipher {
         key = null;
         IV = null;
         state = UNINITIALIZED;
-        contextProxy = null;
+        if( contextProxy != null ) {
+            contextProxy.close();
+            contextProxy = null;
+        }
     }
 
     /**
@@ -14,7 +14,7 @@ class PK11DSAPrivateKey
 
     private PK11DSAPrivateKey() { super(null); }
 
-    protected PK11DSAPrivateKey(byte[] pointer) {
+    protected PK11DSAPrivateKey(long pointer) {
         super(pointer);
     }
 
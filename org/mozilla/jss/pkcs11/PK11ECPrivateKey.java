@@ -11,7 +11,7 @@ class PK11ECPrivateKey
 
     private PK11ECPrivateKey() { super(null); }
 
-    protected PK11ECPrivateKey(byte[] pointer) {
+    protected PK11ECPrivateKey(long pointer) {
         super(pointer);
     }
 
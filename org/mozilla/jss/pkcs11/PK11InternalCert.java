@@ -89,7 +89,7 @@ public class PK11InternalCert extends PK11Cert
 	/////////////////////////////////////////////////////////////
 	// Construction
 	/////////////////////////////////////////////////////////////
-    PK11InternalCert(byte[] certPtr, byte[] slotPtr, String nickname) {
+    PK11InternalCert(long certPtr, long slotPtr, String nickname) {
         super(certPtr, slotPtr, nickname);
     }
 }
@@ -21,7 +21,7 @@ public final class PK11InternalTokenCert extends PK11InternalCert
         return super.getOwningToken();
     }
 
-    PK11InternalTokenCert(byte[] certPtr, byte[] slotPtr, String nickname) {
+    PK11InternalTokenCert(long certPtr, long slotPtr, String nickname) {
         super(certPtr, slotPtr, nickname);
     }
 }
@@ -9,6 +9,7 @@
 #include <seccomon.h>
 #include <pk11func.h>
 #include <secitem.h>
+#include <sechash.h>
 
 /* JSS includes */
 #include <java_ids.h>
@@ -138,6 +139,86 @@ finish:
 }
 
 
+/***********************************************************************
+ *
+ * PK11MessageDigest.restartContext
+ *
+ * Starts a new operation on an existing context, keeping its key.
+ * Returns JNI_FALSE, without throwing, if the token cannot do this.
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_mozilla_jss_pkcs11_PK11MessageDigest_restartContext
+    (JNIEnv *env, jclass clazz, jobject proxyObj)
+{
+    PK11Context *context = NULL;
+
+    if( JSS_PK11_getCipherContext(env, proxyObj, &context) != PR_SUCCESS ) {
+        (*env)->ExceptionClear(env);
+        return JNI_FALSE;
+    }
+
+    return PK11_DigestBegin(context) == SECSuccess ? JNI_TRUE : JNI_FALSE;
+}
+
+/***********************************************************************
+ *
+ * PK11MessageDigest.cloneContext
+ *
+ * Copies a context, including its key and the state of the operation.
+ * Returns NULL, without throwing, if the token cannot save the state.
+ */
+JNIEXPORT jobject JNICALL
+Java_org_mozilla_jss_pkcs11_PK11MessageDigest_cloneContext
+    (JNIEnv *env, jclass clazz, jobject proxyObj)
+{
+    PK11Context *context = NULL, *copy;
+
+    if( JSS_PK11_getCipherContext(env, proxyObj, &context) != PR_SUCCESS ) {
+        /* exception was thrown */
+        return NULL;
+    }
+
+    copy = PK11_CloneContext(context);
+    if( copy == NULL ) {
+        return NULL;
+    }
+
+    return JSS_PK11_wrapCipherContextProxy(env, &copy);
+}
+
+/***********************************************************************
+ *
+ * PK11MessageDigest.updateDirect
+ *
+ * Digests a region of a direct ByteBuffer in place.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_pkcs11_PK11MessageDigest_updateDirect
+    (JNIEnv *env, jclass clazz, jobject proxyObj, jobject inbuf,
+        jint offset, jint len)
+{
+    PK11Context *context = NULL;
+    unsigned char *bytes;
+
+    if( JSS_PK11_getCipherContext(env, proxyObj, &context) != PR_SUCCESS ) {
+        /* exception was thrown */
+        return;
+    }
+
+    bytes = (unsigned char*) (*env)->GetDirectBufferAddress(env, inbuf);
+    if( bytes == NULL ) {
+        JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+            "Buffer is not a direct buffer");
+        return;
+    }
+    PR_ASSERT( (*env)->GetDirectBufferCapacity(env, inbuf) >= offset+len );
+
+    if( PK11_DigestOp(context, bytes + offset, len) != SECSuccess ) {
+        JSS_throwMsg(env, DIGEST_EXCEPTION, "Digest operation failed");
+    }
+}
+
+
 /***********************************************************************
  *
  * PK11MessageDigest.digest
@@ -179,3 +260,216 @@ finish:
     }
     return outLen;
 }
+
+/*
+ * Copies a finished digest or MAC into a new Java byte array.
+ */
+static jbyteArray
+toByteArray(JNIEnv *env, unsigned char *buf, unsigned int len)
+{
+    jbyteArray array;
+
+    array = (*env)->NewByteArray(env, len);
+    if( array == NULL ) {
+        ASSERT_OUTOFMEM(env);
+        return NULL;
+    }
+    (*env)->SetByteArrayRegion(env, array, 0, len, (jbyte*)buf);
+    return array;
+}
+
+/*
+ * Byte arrays are hashed from copies of at most this many bytes rather
+ * than pinned, since a token call can block and a pinned array holds
+ * off the garbage collector.
+ */
+#define DIGEST_CHUNK_SIZE 8192
+
+/*
+ * Hashes len bytes of a byte array into out. Arrays that fit in one
+ * chunk are hashed with PK11_HashBuf; longer ones go through a digest
+ * context a chunk at a time. Returns SECFailure if hashing failed or an
+ * exception was thrown.
+ */
+static SECStatus
+hashArray(JNIEnv *env, SECOidTag alg, jbyteArray data, jint offset,
+    jint len, unsigned char *out, unsigned int maxOut)
+{
+    unsigned char chunk[DIGEST_CHUNK_SIZE];
+    PK11Context *context;
+    unsigned int outLen;
+    SECStatus status;
+    jint n;
+
+    if( len <= DIGEST_CHUNK_SIZE ) {
+        (*env)->GetByteArrayRegion(env, data, offset, len, (jbyte*)chunk);
+        if( (*env)->ExceptionOccurred(env) != NULL ) {
+            return SECFailure;
+        }
+        return PK11_HashBuf(alg, out, chunk, len);
+    }
+
+    context = PK11_CreateDigestContext(alg);
+    if( context == NULL ) {
+        return SECFailure;
+    }
+    status = PK11_DigestBegin(context);
+    while( status == SECSuccess && len > 0 ) {
+        n = (len < DIGEST_CHUNK_SIZE) ? len : DIGEST_CHUNK_SIZE;
+        (*env)->GetByteArrayRegion(env, data, offset, n, (jbyte*)chunk);
+        if( (*env)->ExceptionOccurred(env) != NULL ) {
+            status = SECFailure;
+            break;
+        }
+        status = PK11_DigestOp(context, chunk, n);
+        offset += n;
+        len -= n;
+    }
+    if( status == SECSuccess ) {
+        status = PK11_DigestFinal(context, out, &outLen, maxOut);
+    }
+    PK11_DestroyContext(context, PR_TRUE);
+    return status;
+}
+
+/***********************************************************************
+ *
+ * PK11MessageDigest.digestOneShot
+ *
+ * Hashes data in a single call, without creating a context object.
+ * data is either a byte array or a direct ByteBuffer; the offset and
+ * length have been checked by the caller. NSS hashes on its internal
+ * module, so the caller only passes the internal crypto token; the
+ * mechanism is checked against it here.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_org_mozilla_jss_pkcs11_PK11MessageDigest_digestOneShot
+    (JNIEnv *env, jclass clazz, jobject tokenObj, jobject algObj,
+        jobject data, jint offset, jint len)
+{
+    PK11SlotInfo *slot = NULL;
+    SECOidTag alg;
+    unsigned char out[HASH_LENGTH_MAX];
+    unsigned int outLen;
+    unsigned char *bytes;
+    SECStatus status;
+
+    if( JSS_PK11_getTokenSlotPtr(env, tokenObj, &slot) != PR_SUCCESS ) {
+        /* exception was thrown */
+        return NULL;
+    }
+    if( !PK11_DoesMechanism(slot, JSS_getPK11MechFromAlg(env, algObj)) ) {
+        JSS_throwMsg(env, NO_SUCH_ALG_EXCEPTION,
+            "Token does not support this digest algorithm");
+        return NULL;
+    }
+
+    alg = JSS_getOidTagFromAlg(env, algObj);
+    outLen = HASH_ResultLenByOidTag(alg);
+    if( outLen == 0 || outLen > sizeof(out) ) {
+        JSS_throwMsg(env, NO_SUCH_ALG_EXCEPTION,
+            "Unsupported digest algorithm");
+        return NULL;
+    }
+
+    bytes = (unsigned char*) (*env)->GetDirectBufferAddress(env, data);
+    if( bytes != NULL ) {
+        status = PK11_HashBuf(alg, out, bytes + offset, len);
+    } else {
+        status = hashArray(env, alg, data, offset, len, out, sizeof(out));
+    }
+
+    if( status != SECSuccess ) {
+        if( (*env)->ExceptionOccurred(env) == NULL ) {
+            JSS_throwMsgPrErr(env, DIGEST_EXCEPTION,
+                "Digest operation failed");
+        }
+        return NULL;
+    }
+
+    return toByteArray(env, out, outLen);
+}
+
+/***********************************************************************
+ *
+ * PK11MessageDigest.hmacOneShot
+ *
+ * Computes an HMAC in a single call, without creating a context object.
+ * data is either a byte array or a direct ByteBuffer; the offset and
+ * length have been checked by the caller.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_org_mozilla_jss_pkcs11_PK11MessageDigest_hmacOneShot
+    (JNIEnv *env, jclass clazz, jobject algObj, jobject keyObj,
+        jobject data, jint offset, jint len)
+{
+    PK11SymKey *origKey = NULL, *newKey = NULL;
+    PK11SlotInfo *slot;
+    PRBool doesMech;
+    CK_MECHANISM_TYPE mech;
+    unsigned char out[HASH_LENGTH_MAX];
+    SECItem param, input, mac;
+    jbyte *arrayBytes = NULL;
+    unsigned char *bytes;
+    jbyteArray macArray = NULL;
+
+    if( JSS_PK11_getSymKeyPtr(env, keyObj, &origKey) != PR_SUCCESS ) {
+        /* exception was thrown */
+        goto finish;
+    }
+
+    /* the MAC is computed on the token that holds the key */
+    mech = JSS_getPK11MechFromAlg(env, algObj);
+    slot = PK11_GetSlotFromKey(origKey);
+    doesMech = PK11_DoesMechanism(slot, mech);
+    PK11_FreeSlot(slot);
+    if( !doesMech ) {
+        JSS_throwMsg(env, NO_SUCH_ALG_EXCEPTION,
+            "Token does not support this HMAC algorithm");
+        goto finish;
+    }
+
+    bytes = (unsigned char*) (*env)->GetDirectBufferAddress(env, data);
+    if( bytes == NULL ) {
+        /* The token may block, so don't hold the array in a critical
+         * region here. */
+        arrayBytes = (*env)->GetByteArrayElements(env, data, NULL);
+        if( arrayBytes == NULL ) {
+            ASSERT_OUTOFMEM(env);
+            goto finish;
+        }
+        bytes = (unsigned char*) arrayBytes;
+    }
+
+    /* copy the key, setting the CKA_SIGN attribute */
+    newKey = PK11_CopySymKeyForSigning(origKey, mech);
+    if( newKey == NULL ) {
+        /* this can fail for keys on an HSM, which may work anyway */
+        newKey = origKey;
+    }
+
+    param.data = NULL;
+    param.len = 0;
+    input.data = bytes + offset;
+    input.len = len;
+    mac.data = out;
+    mac.len = sizeof(out);
+
+    if( PK11_SignWithSymKey(newKey, mech, &param, &mac, &input)
+            != SECSuccess )
+    {
+        JSS_throwMsgPrErr(env, DIGEST_EXCEPTION, "HMAC operation failed");
+        goto finish;
+    }
+
+    macArray = toByteArray(env, mac.data, mac.len);
+
+finish:
+    if( arrayBytes != NULL ) {
+        (*env)->ReleaseByteArrayElements(env, data, arrayBytes, JNI_ABORT);
+    }
+    if( newKey != NULL && newKey != origKey ) {
+        PK11_FreeSymKey(newKey);
+    }
+    return macArray;
+}
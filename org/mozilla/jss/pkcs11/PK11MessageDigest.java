@@ -5,6 +5,7 @@
 package org.mozilla.jss.pkcs11;
 
 import org.mozilla.jss.crypto.*;
+import java.nio.ByteBuffer;
 import java.security.DigestException;
 import java.security.NoSuchAlgorithmException;
 import java.security.InvalidKeyException;
@@ -19,6 +20,14 @@ public final class PK11MessageDigest extends JSSMessageDigest {
     private PK11SymKey hmacKey;
     private DigestAlgorithm alg;
 
+    /**
+     * Updates smaller than this are gathered here and handed to NSS
+     * together, rather than crossing into native code for each one.
+     */
+    private static final int UPDATE_BUFFER_SIZE = 512;
+    private byte[] pending = new byte[UPDATE_BUFFER_SIZE];
+    private int pendingLen = 0;
+
     PK11MessageDigest(PK11Token token, DigestAlgorithm alg)
         throws NoSuchAlgorithmException, DigestException
     {
@@ -32,6 +41,19 @@ public final class PK11MessageDigest extends JSSMessageDigest {
         reset();
     }
 
+    /**
+     * Creates a copy of <code>other</code>, sharing its key but with its
+     * own native context.
+     */
+    private PK11MessageDigest(PK11MessageDigest other,
+            CipherContextProxy digestProxy)
+    {
+        this.token = other.token;
+        this.alg = other.alg;
+        this.hmacKey = other.hmacKey;
+        this.digestProxy = digestProxy;
+    }
+
     public void initHMAC(SymmetricKey key)
         throws DigestException, InvalidKeyException
     {
@@ -40,7 +62,8 @@ public final class PK11MessageDigest extends JSSMessageDigest {
             throw new DigestException("Digest is not an HMAC digest");
         }
 
-        reset();
+        pendingLen = 0;
+        closeContext();
 
         if( ! (key instanceof PK11SymKey) ) {
             throw new InvalidKeyException("HMAC key is not a PKCS #11 key");
@@ -57,6 +80,16 @@ public final class PK11MessageDigest extends JSSMessageDigest {
         this.digestProxy = initHMAC(token, alg, hmacKey);
     }
 
+    public void update(byte input) throws DigestException {
+        if( digestProxy == null ) {
+            throw new DigestException("Digest not correctly initialized");
+        }
+        if( pendingLen == pending.length ) {
+            flush();
+        }
+        pending[pendingLen++] = input;
+    }
+
     public void update(byte[] input, int offset, int len)
         throws DigestException
     {
@@ -68,7 +101,42 @@ public final class PK11MessageDigest extends JSSMessageDigest {
                 "Input buffer is not large enough for offset and length");
         }
 
-        update(digestProxy, input, offset, len);
+        if( len <= pending.length - pendingLen ) {
+            System.arraycopy(input, offset, pending, pendingLen, len);
+            pendingLen += len;
+            return;
+        }
+        flush();
+        if( len < pending.length ) {
+            System.arraycopy(input, offset, pending, 0, len);
+            pendingLen = len;
+        } else {
+            update(digestProxy, input, offset, len);
+        }
+    }
+
+    /**
+     * Direct buffers, including memory-mapped files, are digested in
+     * place without being copied onto the Java heap.
+     */
+    public void update(ByteBuffer input) throws DigestException {
+        if( digestProxy == null ) {
+            throw new DigestException("Digest not correctly initialized");
+        }
+        if( !input.isDirect() ) {
+            super.update(input);
+            return;
+        }
+        flush();
+        updateDirect(digestProxy, input, input.position(), input.remaining());
+        input.position(input.limit());
+    }
+
+    private void flush() {
+        if( pendingLen > 0 ) {
+            update(digestProxy, pending, 0, pendingLen);
+            pendingLen = 0;
+        }
     }
 
     public int digest(byte[] outbuf, int offset, int len)
@@ -82,6 +150,7 @@ public final class PK11MessageDigest extends JSSMessageDigest {
                 "Output buffer is not large enough for offset and length");
         }
 
+        flush();
         int retval = digest(digestProxy, outbuf, offset, len);
 
         reset();
@@ -89,7 +158,17 @@ public final class PK11MessageDigest extends JSSMessageDigest {
         return retval;
     }
 
+    /**
+     * Resets the existing native context in place when possible. This
+     * reuses the context and the signing copy of the HMAC key, so only a
+     * failed restart allocates a new context.
+     */
     public void reset() throws DigestException {
+        pendingLen = 0;
+        if( digestProxy != null && restartContext(digestProxy) ) {
+            return;
+        }
+        closeContext();
         if( ! (alg instanceof HMACAlgorithm) ) {
             // This is a regular digest, so we have enough information
             // to initialize the context
@@ -104,10 +183,110 @@ public final class PK11MessageDigest extends JSSMessageDigest {
         }
     }
 
+    /**
+     * Returns a copy of this digest, including the input it has seen so
+     * far. For HMAC, the copy is already keyed, so cloning a freshly
+     * initialized digest avoids setting up the key again.
+     *
+     * @exception CloneNotSupportedException If the token cannot copy the
+     *      native context.
+     */
+    public Object clone() throws CloneNotSupportedException {
+        if( digestProxy == null ) {
+            return new PK11MessageDigest(this, null);
+        }
+        flush();
+        CipherContextProxy copy = cloneContext(digestProxy);
+        if( copy == null ) {
+            throw new CloneNotSupportedException(
+                "Token cannot copy this digest context");
+        }
+        return new PK11MessageDigest(this, copy);
+    }
+
+    private void closeContext() {
+        if( digestProxy != null ) {
+            // free the old context now instead of waiting for the GC
+            digestProxy.close();
+            digestProxy = null;
+        }
+    }
+
     public DigestAlgorithm getAlgorithm() {
         return alg;
     }
 
+    /**
+     * Hashes data in a single native call, without creating a digest
+     * context. See CryptoToken.digest(DigestAlgorithm, byte[], int, int).
+     * NSS picks the slot, so the token should be the internal token; it
+     * is only used to check that the algorithm is supported.
+     */
+    static byte[] digestOnce(PK11Token token, DigestAlgorithm alg,
+            byte[] input, int offset, int len)
+        throws DigestException, NoSuchAlgorithmException
+    {
+        checkOneShot(alg, input.length, offset, len);
+        return digestOneShot(token, alg, input, offset, len);
+    }
+
+    /**
+     * Hashes the bytes remaining in a buffer in a single native call, and
+     * advances the buffer's position to its limit.
+     */
+    static byte[] digestOnce(PK11Token token, DigestAlgorithm alg,
+            ByteBuffer input)
+        throws DigestException, NoSuchAlgorithmException
+    {
+        int len = input.remaining();
+        checkOneShot(alg, len, 0, len);
+        byte[] out;
+        if( input.isDirect() ) {
+            out = digestOneShot(token, alg, input, input.position(), len);
+        } else if( input.hasArray() ) {
+            out = digestOneShot(token, alg, input.array(),
+                    input.arrayOffset() + input.position(), len);
+        } else {
+            byte[] copy = new byte[len];
+            input.duplicate().get(copy);
+            out = digestOneShot(token, alg, copy, 0, len);
+        }
+        input.position(input.limit());
+        return out;
+    }
+
+    /**
+     * Computes an HMAC in a single native call, without creating a digest
+     * context. See CryptoToken.hmac(SymmetricKey, HMACAlgorithm, byte[],
+     * int, int).
+     */
+    static byte[] hmacOnce(SymmetricKey key, HMACAlgorithm alg,
+            byte[] input, int offset, int len)
+        throws DigestException, InvalidKeyException, NoSuchAlgorithmException
+    {
+        if( ! (key instanceof PK11SymKey) ) {
+            throw new InvalidKeyException("HMAC key is not a PKCS #11 key");
+        }
+        if( input.length < offset+len || offset < 0 || len < 0 ) {
+            throw new IllegalArgumentException(
+                "Input buffer is not large enough for offset and length");
+        }
+        return hmacOneShot(alg, (PK11SymKey) key, input, offset, len);
+    }
+
+    private static void checkOneShot(DigestAlgorithm alg, int length,
+            int offset, int len)
+        throws DigestException
+    {
+        if( alg instanceof HMACAlgorithm ) {
+            throw new DigestException("HMAC digests require a key");
+        }
+        if( length < offset+len || offset < 0 || len < 0 ) {
+            throw new IllegalArgumentException(
+                "Input buffer is not large enough for offset and length");
+        }
+    }
+
     private static native CipherContextProxy
     initDigest(DigestAlgorithm alg)
         throws DigestException;
@@ -119,7 +298,40 @@ public final class PK11MessageDigest extends JSSMessageDigest {
     private static native void
     update(CipherContextProxy proxy, byte[] inbuf, int offset, int len);
 
+    /**
+     * Restarts the context's operation, keeping its key.
+     * @return false if the token could not restart it.
+     */
+    private static native boolean
+    restartContext(CipherContextProxy proxy);
+
+    /**
+     * @return a copy of the context, or null if the token cannot copy it.
+     */
+    private static native CipherContextProxy
+    cloneContext(CipherContextProxy proxy);
+
+    private static native void
+    updateDirect(CipherContextProxy proxy, ByteBuffer inbuf, int offset,
+        int len);
+
     private static native int
     digest(CipherContextProxy proxy, byte[] outbuf, int offset, int len);
 
+    /**
+     * @param input a byte array or a direct ByteBuffer.
+     */
+    private static native byte[]
+    digestOneShot(PK11Token token, DigestAlgorithm alg, Object input,
+        int offset, int len)
+        throws DigestException, NoSuchAlgorithmException;
+
+    /**
+     * @param input a byte array or a direct ByteBuffer.
+     */
+    private static native byte[]
+    hmacOneShot(HMACAlgorithm alg, PK11SymKey key, Object input, int offset,
+        int len)
+        throws DigestException, NoSuchAlgorithmException;
+
 }
@@ -146,12 +146,9 @@ JSS_PK11_wrapPK11Module(JNIEnv *env, SECMODModule **module)
     jclass moduleClass;
     jmethodID constructor;
     jobject newModule=NULL;
-    jbyteArray pointer;
 
     PR_ASSERT(env!=NULL && module!=NULL && *module!=NULL);
 
-    pointer = JSS_ptrToByteArray(env, (void*)*module);
-
     /*
      * Lookup the class and constructor
      */
@@ -174,7 +171,8 @@ JSS_PK11_wrapPK11Module(JNIEnv *env, SECMODModule **module)
     /*
      * Call the constructor
      */
-    newModule = (*env)->NewObject(env, moduleClass, constructor, pointer);
+    newModule = (*env)->NewObject(env, moduleClass, constructor,
+        JSS_ptrToLong(*module));
 
 finish:
     if(newModule==NULL) {
@@ -18,8 +18,8 @@ public final class PK11Module {
     /**
      * This constructor should only be called from native code.
      */
-    private PK11Module(byte[] pointer) {
-        Assert._assert(pointer!=null);
+    private PK11Module(long pointer) {
+        Assert._assert(pointer!=0);
         moduleProxy = new ModuleProxy(pointer);
         reloadTokens();
     }
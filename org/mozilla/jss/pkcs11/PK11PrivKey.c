@@ -31,7 +31,6 @@ JSS_PK11_wrapPrivKey(JNIEnv *env, SECKEYPrivateKey **privk)
 {
 	jclass keyClass;
 	jmethodID constructor;
-	jbyteArray ptrArray;
 	jobject Key=NULL;
     const char *className = NULL;
 
@@ -60,19 +59,16 @@ JSS_PK11_wrapPrivKey(JNIEnv *env, SECKEYPrivateKey **privk)
 	}
 
 	/* find the constructor */
-	constructor = (*env)->GetMethodID(env, keyClass, "<init>", "([B)V");
+	constructor = (*env)->GetMethodID(env, keyClass, PLAIN_CONSTRUCTOR,
+		PK11PRIVKEY_CONSTRUCTOR_SIG);
 	if(constructor == NULL) {
 		ASSERT_OUTOFMEM(env);
 		goto finish;
 	}
 
-	/* convert the pointer to a byte array */
-	ptrArray = JSS_ptrToByteArray(env, (void*)*privk);
-	if(ptrArray == NULL) {
-		goto finish;
-	}
 	/* call the constructor */
-    Key = (*env)->NewObject(env, keyClass, constructor, ptrArray);
+    Key = (*env)->NewObject(env, keyClass, constructor,
+        JSS_ptrToLong(*privk));
 
 finish:
 	if(Key == NULL) {
@@ -22,8 +22,8 @@ public class PK11PrivKey extends org.mozilla.jss.pkcs11.PK11Key
 
     private PK11PrivKey() { }
 
-    protected PK11PrivKey(byte[] pointer) {
-        Assert._assert(pointer!=null);
+    protected PK11PrivKey(long pointer) {
+        Assert._assert(pointer!=0);
         keyProxy = new PrivateKeyProxy(pointer);
     }
 
@@ -127,7 +127,7 @@ class PrivateKeyProxy extends KeyProxy {
 
     public static Logger logger = LoggerFactory.getLogger(PrivateKeyProxy.class);
 
-    public PrivateKeyProxy(byte[] pointer) {
+    public PrivateKeyProxy(long pointer) {
         super(pointer);
     }
 
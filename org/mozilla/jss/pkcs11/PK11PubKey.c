@@ -61,7 +61,6 @@ JSS_PK11_wrapPubKey(JNIEnv *env, SECKEYPublicKey **pKey)
 	jclass keyClass;
     KeyType keyType;
 	jmethodID constructor;
-	jbyteArray ptr;
     char *keyClassName;
 
 	PR_ASSERT(env!=NULL && pKey!=NULL);
@@ -98,13 +97,8 @@ JSS_PK11_wrapPubKey(JNIEnv *env, SECKEYPublicKey **pKey)
 		goto finish;
 	}
 
-	ptr = JSS_ptrToByteArray(env, (void*)*pKey);
-	if(ptr == NULL) {
-		ASSERT_OUTOFMEM(env);
-		goto finish;
-	}
-
-	pubKey = (*env)->NewObject(env, keyClass, constructor, ptr);
+	pubKey = (*env)->NewObject(env, keyClass, constructor,
+		JSS_ptrToLong(*pKey));
 	if(pubKey == NULL) {
 		ASSERT_OUTOFMEM(env);
 		goto finish;
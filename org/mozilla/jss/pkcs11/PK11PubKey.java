@@ -15,8 +15,8 @@ public class PK11PubKey extends org.mozilla.jss.pkcs11.PK11Key
 
     private static final long serialVersionUID = 1L;
 
-    protected PK11PubKey(byte[] pointer) {
-        Assert._assert(pointer!=null);
+    protected PK11PubKey(long pointer) {
+        Assert._assert(pointer!=0);
         keyProxy = new PublicKeyProxy(pointer);
     }
 
@@ -101,7 +101,7 @@ class PublicKeyProxy extends KeyProxy {
 
     public static Logger logger = LoggerFactory.getLogger(PublicKeyProxy.class);
 
-    public PublicKeyProxy(byte[] pointer) {
+    public PublicKeyProxy(long pointer) {
         super(pointer);
     }
 
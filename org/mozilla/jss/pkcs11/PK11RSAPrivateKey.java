@@ -15,7 +15,7 @@ class PK11RSAPrivateKey
 
     private PK11RSAPrivateKey() { super(null); }
 
-    protected PK11RSAPrivateKey(byte[] pointer) {
+    protected PK11RSAPrivateKey(long pointer) {
         super(pointer);
     }
 
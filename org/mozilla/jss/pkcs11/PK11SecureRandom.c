@@ -6,8 +6,10 @@
  * NSS and NSPR header files
  */
 
+#include <nss.h>
 #include <pk11func.h>
 #include <nspr.h>
+#include <string.h>
 
 /*
  * JNI header files
@@ -20,6 +22,77 @@
  */
 
 #include <jssutil.h>
+#include <jss_exceptions.h>
+
+/*
+ * The slot random numbers come from. PK11_GenerateRandom and the old
+ * setSeed looked it up with PK11_GetBestSlot on every call; it is now
+ * looked up on first use (NSS is not yet initialized when the library
+ * is loaded) and cached until NSS shuts down, when the cached reference
+ * is dropped. rngSlotLock guards rngSlot; callers take their own
+ * reference, so a shutdown while they use the slot doesn't free it
+ * under them.
+ */
+static PK11SlotInfo *rngSlot = NULL;
+static PRLock *rngSlotLock = NULL;
+static PRCallOnceType rngSlotLockOnce;
+
+static PRStatus
+initRNGSlotLock(void)
+{
+    rngSlotLock = PR_NewLock();
+    return rngSlotLock == NULL ? PR_FAILURE : PR_SUCCESS;
+}
+
+static SECStatus
+releaseRNGSlot(void *appData, void *nssData)
+{
+    PR_Lock(rngSlotLock);
+    if( rngSlot != NULL ) {
+        PK11_FreeSlot(rngSlot);
+        rngSlot = NULL;
+    }
+    PR_Unlock(rngSlotLock);
+    return SECSuccess;
+}
+
+/*
+ * Returns a new reference to the RNG slot, which the caller must free
+ * with PK11_FreeSlot, or throws a PK11Exception and returns NULL if
+ * there isn't one.
+ */
+static PK11SlotInfo *
+getRNGSlot(JNIEnv *env)
+{
+    PK11SlotInfo *slot = NULL;
+
+    if( PR_CallOnce(&rngSlotLockOnce, initRNGSlotLock) != PR_SUCCESS ) {
+        JSS_throw(env, OUT_OF_MEMORY_ERROR);
+        return NULL;
+    }
+
+    PR_Lock(rngSlotLock);
+    if( rngSlot == NULL ) {
+        rngSlot = PK11_GetBestSlot(CKM_FAKE_RANDOM, NULL);
+        if( rngSlot != NULL &&
+            NSS_RegisterShutdown(releaseRNGSlot, NULL) != SECSuccess )
+        {
+            /* nobody would drop it at shutdown, so don't cache it */
+            slot = rngSlot;
+            rngSlot = NULL;
+        }
+    }
+    if( rngSlot != NULL ) {
+        slot = PK11_ReferenceSlot(rngSlot);
+    }
+    PR_Unlock(rngSlotLock);
+
+    if( slot == NULL ) {
+        JSS_throwMsgPrErr(env, PK11_EXCEPTION,
+            "Unable to find a slot that supports random number generation");
+    }
+    return slot;
+}
 
 /*
  * JNI FUNCTION:  PK11SecureRandom.setSeed
@@ -72,7 +145,6 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_setSeed
      */
 
     jbyte*    jdata   = NULL;
-    jboolean  jIsCopy = JNI_FALSE;
     jsize     jlen    = 0;
 
 
@@ -80,8 +152,7 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_setSeed
      * "C" data members
      */
 
-    PRThread*     VARIABLE_MAY_NOT_BE_USED pThread = NULL;
-    SECStatus     status  = PR_FALSE;
+    SECStatus     status  = SECFailure;
     PK11SlotInfo* slot    = NULL;
 
 
@@ -93,20 +164,11 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_setSeed
 
 
     /*
-     * Attach to the external java thread
-     */
-
-    pThread = PR_AttachThread( PR_SYSTEM_THREAD, 0, NULL );
-    PR_ASSERT( pThread != NULL );
-
-
-    /*
-     * Obtain the appropriate "slot"
+     * Obtain a reference to the cached "slot"
      */
 
-    slot = PK11_GetBestSlot( CKM_FAKE_RANDOM, NULL );
+    slot = getRNGSlot( env );
     if( slot == NULL ) {
-        PR_ASSERT( PR_FALSE );
         goto finish;
     }
 
@@ -116,15 +178,11 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_setSeed
      * that it can be cast into a "C unsigned char*"
      */
 
-    jdata = ( *env )->GetByteArrayElements( env, jseed, &jIsCopy );
-
-
-    /*
-     * Retrieve the length of the "JNI jbyteArray"
-     * so that it can be cast into a "C int"
-     */
-
     jlen = ( *env )->GetArrayLength( env, jseed );
+    jdata = ( *env )->GetByteArrayElements( env, jseed, NULL );
+    if( jdata == NULL ) {
+        goto finish;
+    }
 
 
     /*
@@ -142,30 +200,16 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_setSeed
 finish:
 
     /*
-     * Copy back the contents of the "JNI jbyte*" and
-     * free any resources associated with it
+     * Free the "JNI jbyte*"; the seed is only read
      */
 
-    if(  jIsCopy == JNI_TRUE ) {
-        ( *env )->ReleaseByteArrayElements( env, jseed, jdata, 0 );
+    if( jdata != NULL ) {
+        ( *env )->ReleaseByteArrayElements( env, jseed, jdata, JNI_ABORT );
     }
 
-
-    /*
-     * Free any "C" resources
-     */
-
     if( slot != NULL ) {
         PK11_FreeSlot( slot );
     }
-    slot = NULL;
-
-
-    /*
-     * Detach from the external java thread and return
-     */
-
-    PR_DetachThread();
 
     return;
 }
@@ -221,8 +265,6 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_nextBytes
      * "JNI" data members
      */
 
-    jbyte*    jdata   = NULL;
-    jboolean  jIsCopy = JNI_FALSE;
     jsize     jlen    = 0;
 
 
@@ -230,8 +272,9 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_nextBytes
      * "C" data members
      */
 
-    PRThread*     VARIABLE_MAY_NOT_BE_USED pThread = NULL;
-    SECStatus     status  = PR_FALSE;
+    SECStatus      status  = SECFailure;
+    PK11SlotInfo*  slot    = NULL;
+    unsigned char* data    = NULL;
 
 
     /*
@@ -241,59 +284,49 @@ Java_org_mozilla_jss_pkcs11_PK11SecureRandom_nextBytes
     PR_ASSERT( env != NULL && this != NULL );
 
 
-    /*
-     * Attach to the external java thread
-     */
-
-    pThread = PR_AttachThread( PR_SYSTEM_THREAD, 0, NULL );
-    PR_ASSERT( pThread != NULL );
-
-
-    /*
-     * Convert "JNI jbyteArray" into "JNI jbyte*" so
-     * that it can be cast into a "C unsigned char*"
-     */
+    jlen = ( *env )->GetArrayLength( env, jbytes );
+    if( jlen == 0 ) {
+        return;
+    }
 
-    jdata = ( *env )->GetByteArrayElements( env, jbytes, &jIsCopy );
+    slot = getRNGSlot( env );
+    if( slot == NULL ) {
+        goto finish;
+    }
 
 
     /*
-     * Retrieve the length of the "JNI jbyteArray"
-     * so that it can be cast into a "C int"
+     * Generate into a native buffer rather than the pinned Java array,
+     * so the token call doesn't hold off the garbage collector, then
+     * copy the result out. The array is untouched on failure.
      */
 
-    jlen = ( *env )->GetArrayLength( env, jbytes );
-
-
-    /*
-     * Generate a pseudo-random number; currently,
-     * failures from this routine are ignored
-     */
+    data = PR_Malloc( jlen );
+    if( data == NULL ) {
+        JSS_throw( env, OUT_OF_MEMORY_ERROR );
+        goto finish;
+    }
 
-    status = PK11_GenerateRandom( ( unsigned char* ) jdata, ( int ) jlen );
+    status = PK11_GenerateRandomOnSlot( slot, data, ( int ) jlen );
     if( status != SECSuccess ) {
+        JSS_throwMsgPrErr( env, PK11_EXCEPTION,
+            "Failed to generate random data" );
         goto finish;
     }
 
+    ( *env )->SetByteArrayRegion( env, jbytes, 0, jlen, ( jbyte* ) data );
 
-finish:
 
-    /*
-     * Copy back the contents of the "JNI jbyte*" and
-     * free any resources associated with it
-     */
+finish:
 
-    if( jIsCopy == JNI_TRUE ) {
-        ( *env )->ReleaseByteArrayElements( env, jbytes, jdata, 0 );
+    if( data != NULL ) {
+        memset( data, 0, jlen );
+        PR_Free( data );
     }
 
-
-    /*
-     * Detach from the external java thread and return
-     */
-
-    PR_DetachThread();
+    if( slot != NULL ) {
+        PK11_FreeSlot( slot );
+    }
 
     return;
 }
-
@@ -7,6 +7,10 @@ package org.mozilla.jss.pkcs11;
 /**
  * A random number generator for PKCS #11.
  *
+ * <p>Instances hold no state of their own; all of them draw from the
+ * token's generator, which does its own locking, so one instance may be
+ * shared between threads.
+ *
  * @see org.mozilla.jss.CryptoManager
  */
 public final
@@ -23,7 +27,7 @@ class PK11SecureRandom implements org.mozilla.jss.crypto.JSSSecureRandom
     //  public routines
     ////////////////////////////////////////////////////
 
-    public synchronized native void
+    public native void
     setSeed( byte[] seed );
 
     public void
@@ -39,7 +43,7 @@ class PK11SecureRandom implements org.mozilla.jss.crypto.JSSSecureRandom
         setSeed( data );
     }
 
-    public synchronized native void
+    public native void
     nextBytes( byte bytes[] );
 }
 
@@ -13,9 +13,11 @@
 #include <secerr.h>
 #include <cryptoht.h>
 #include <cryptohi.h>
+#include <keyhi.h>
 
 #include <jssutil.h>
 #include <java_ids.h>
+#include <jss_ids.h>
 #include <jss_exceptions.h>
 #include "pk11util.h"
 
@@ -128,6 +130,37 @@ finish:
 	}
 }
 
+/*
+ * Feeds bytes to the signing or verification context of a PK11Signature.
+ * Throws an exception on failure.
+ */
+static void
+updateSigContext(JNIEnv *env, jobject sig, unsigned char *bytes,
+    unsigned int length)
+{
+    SigContextType type;
+    void *ctxt;
+
+    /* Extract the signature context */
+    if( getSigContext(env, sig, &ctxt, &type) != PR_SUCCESS) {
+        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL);
+        return;
+    }
+    PR_ASSERT(ctxt != NULL);
+
+    /* Update the context */
+    if(type == SGN_CONTEXT) {
+        if( SGN_Update( (SGNContext*)ctxt, bytes, length ) != SECSuccess) {
+            JSS_throwMsg(env, SIGNATURE_EXCEPTION, "update failed");
+        }
+    } else {
+        PR_ASSERT( type == VFY_CONTEXT );
+        if( VFY_Update( (VFYContext*)ctxt, bytes, length ) != SECSuccess) {
+            JSS_throwMsg(env, SIGNATURE_EXCEPTION, "update failed");
+        }
+    }
+}
+
 /**********************************************************************
  *
  * PK11Signature.engineUpdateNative
@@ -137,24 +170,9 @@ JNIEXPORT void JNICALL
 Java_org_mozilla_jss_pkcs11_PK11Signature_engineUpdateNative
     (JNIEnv *env, jobject this, jbyteArray bArray, jint offset, jint length)
 {
-    SigContextType type;
-    void *ctxt;
     jbyte *bytes=NULL;
     jint numBytes;
 
-    /* Extract the signature context */
-    if( getSigContext(env, this, &ctxt, &type) != PR_SUCCESS) {
-        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL);
-        goto finish;
-    }
-    PR_ASSERT(ctxt != NULL);
-
-    /* Get the bytes to be updated */
-    bytes = (*env)->GetByteArrayElements(env, bArray, NULL);
-    if(bytes==NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
     numBytes = (*env)->GetArrayLength(env, bArray);
     PR_ASSERT(numBytes > 0);
 
@@ -165,32 +183,46 @@ Java_org_mozilla_jss_pkcs11_PK11Signature_engineUpdateNative
         goto finish;
     }
 
-    /* Update the context */
-    if(type == SGN_CONTEXT) {
-        if( SGN_Update( (SGNContext*)ctxt,
-                        (unsigned char*)bytes + offset,
-                        (unsigned)length ) != SECSuccess)
-        {
-            JSS_throwMsg(env, SIGNATURE_EXCEPTION, "update failed");
-            goto finish;
-        }
-    } else {
-        PR_ASSERT( type == VFY_CONTEXT );
-        if( VFY_Update( (VFYContext*)ctxt,
-                        (unsigned char*)bytes + offset,
-                        (unsigned) length ) != SECSuccess)
-        {
-            JSS_throwMsg(env, SIGNATURE_EXCEPTION, "update failed");
-            goto finish;
-        }
+    /* Get the bytes to be updated */
+    bytes = (*env)->GetByteArrayElements(env, bArray, NULL);
+    if(bytes==NULL) {
+        ASSERT_OUTOFMEM(env);
+        goto finish;
     }
 
+    updateSigContext(env, this, (unsigned char*)bytes + offset,
+        (unsigned)length);
+
 finish:
     if(bytes!=NULL) {
         (*env)->ReleaseByteArrayElements(env, bArray, bytes, JNI_ABORT);
     }
 }
 
+/**********************************************************************
+ *
+ * PK11Signature.engineUpdateDirectNative
+ *
+ * Updates the context from a region of a direct ByteBuffer, in place.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_pkcs11_PK11Signature_engineUpdateDirectNative
+    (JNIEnv *env, jobject this, jobject buffer, jint offset, jint length)
+{
+    unsigned char *bytes;
+
+    bytes = (unsigned char*) (*env)->GetDirectBufferAddress(env, buffer);
+    if( bytes == NULL ) {
+        JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+            "Buffer is not a direct buffer");
+        return;
+    }
+    PR_ASSERT( offset >= 0 && length >= 0 &&
+        (*env)->GetDirectBufferCapacity(env, buffer) >= offset+length );
+
+    updateSigContext(env, this, bytes + offset, (unsigned)length);
+}
+
 
 /**********************************************************************
  *
@@ -254,6 +286,188 @@ finish:
     return sigArray;
 }
 
+/*
+ * Heap arrays are hashed through a buffer this size rather than pinned,
+ * since signing can block on the token.
+ */
+#define SIGN_CHUNK_SIZE 8192
+
+/**********************************************************************
+ *
+ * PK11Signature.engineSignAllNative
+ *
+ * Signs each data[i][offsets[i]..offsets[i]+lengths[i]) with the signing
+ * context of the PK11Signature, restarting the context for each message.
+ * Each data[i] is either a direct ByteBuffer or a byte[]. The signatures
+ * are stored back to back in outArray starting at outOffset, and their
+ * lengths in sigLenArray. Returns the number of bytes stored.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_pkcs11_PK11Signature_engineSignAllNative
+    (JNIEnv *env, jobject this, jobjectArray data, jintArray offsetArray,
+    jintArray lengthArray, jbyteArray outArray, jint outOffset,
+    jintArray sigLenArray)
+{
+    SGNContext *ctxt;
+    SigContextType type;
+    SECItem signature;
+    jint *offsets=NULL;
+    jint *lengths=NULL;
+    jint *sigLens=NULL;
+    jsize count, i;
+    jint outLen, pos;
+    jobject msg=NULL;
+
+    PR_ASSERT(env!=NULL && this!=NULL);
+
+    signature.data = NULL;
+    pos = outOffset;
+
+    if( getSigContext(env, this, (void**)&ctxt, &type) != PR_SUCCESS) {
+        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL);
+        goto finish;
+    }
+    PR_ASSERT(ctxt!=NULL && type==SGN_CONTEXT);
+
+    count = (*env)->GetArrayLength(env, data);
+    outLen = (*env)->GetArrayLength(env, outArray);
+    PR_ASSERT(outOffset >= 0 && outOffset <= outLen);
+
+    offsets = (*env)->GetIntArrayElements(env, offsetArray, NULL);
+    lengths = (*env)->GetIntArrayElements(env, lengthArray, NULL);
+    sigLens = (*env)->GetIntArrayElements(env, sigLenArray, NULL);
+    if( offsets == NULL || lengths == NULL || sigLens == NULL ) {
+        ASSERT_OUTOFMEM(env);
+        goto finish;
+    }
+
+    for( i = 0; i < count; i++ ) {
+        unsigned char *bytes;
+        unsigned char chunk[SIGN_CHUNK_SIZE];
+        jint off, remaining, n;
+        SECStatus rv = SECSuccess;
+
+        msg = (*env)->GetObjectArrayElement(env, data, i);
+        if( msg == NULL ) {
+            JSS_throw(env, NULL_POINTER_EXCEPTION);
+            goto finish;
+        }
+
+        if( SGN_Begin(ctxt) != SECSuccess ) {
+            JSS_throwMsgPrErr(env, SIGNATURE_EXCEPTION,
+                "Unable to begin signing context");
+            goto finish;
+        }
+
+        bytes = (unsigned char*) (*env)->GetDirectBufferAddress(env, msg);
+        if( bytes != NULL ) {
+            rv = SGN_Update(ctxt, bytes + offsets[i], (unsigned) lengths[i]);
+        } else {
+            off = offsets[i];
+            remaining = lengths[i];
+            while( remaining > 0 && rv == SECSuccess ) {
+                n = (remaining < SIGN_CHUNK_SIZE) ? remaining
+                                                  : SIGN_CHUNK_SIZE;
+                (*env)->GetByteArrayRegion(env, msg, off, n, (jbyte*)chunk);
+                if( (*env)->ExceptionOccurred(env) ) {
+                    goto finish;
+                }
+                rv = SGN_Update(ctxt, chunk, (unsigned) n);
+                off += n;
+                remaining -= n;
+            }
+        }
+        (*env)->DeleteLocalRef(env, msg);
+        msg = NULL;
+        if( rv != SECSuccess ) {
+            JSS_throwMsgPrErr(env, SIGNATURE_EXCEPTION, "update failed");
+            goto finish;
+        }
+
+        if( SGN_End(ctxt, &signature) != SECSuccess ) {
+            JSS_throwMsgPrErr(env, SIGNATURE_EXCEPTION,
+                "Signing operation failed");
+            goto finish;
+        }
+        if( signature.len > (unsigned) (outLen - pos) ) {
+            JSS_throwMsg(env, SIGNATURE_EXCEPTION,
+                "outbuf is not sufficient to hold signatures");
+            goto finish;
+        }
+        (*env)->SetByteArrayRegion(env, outArray, pos, signature.len,
+            (jbyte*) signature.data);
+        sigLens[i] = signature.len;
+        pos += signature.len;
+
+        PR_Free(signature.data);
+        signature.data = NULL;
+    }
+
+    /* leave the context ready for the next message */
+    if( SGN_Begin(ctxt) != SECSuccess ) {
+        JSS_throwMsgPrErr(env, SIGNATURE_EXCEPTION,
+            "Unable to begin signing context");
+    }
+
+finish:
+    if( msg != NULL ) {
+        (*env)->DeleteLocalRef(env, msg);
+    }
+    if( offsets != NULL ) {
+        (*env)->ReleaseIntArrayElements(env, offsetArray, offsets, JNI_ABORT);
+    }
+    if( lengths != NULL ) {
+        (*env)->ReleaseIntArrayElements(env, lengthArray, lengths, JNI_ABORT);
+    }
+    if( sigLens != NULL ) {
+        (*env)->ReleaseIntArrayElements(env, sigLenArray, sigLens, 0);
+    }
+    if( signature.data != NULL ) {
+        PR_Free(signature.data);
+    }
+    return pos - outOffset;
+}
+
+/*
+ * SGN_End DER-encodes DSA and ECDSA signatures as a SEQUENCE of two
+ * INTEGERs, which takes at most this many bytes beyond the raw signature.
+ */
+#define DER_SIG_OVERHEAD 16
+
+/**********************************************************************
+ *
+ * PK11Signature.getMaxSignatureLengthNative
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_pkcs11_PK11Signature_getMaxSignatureLengthNative
+    (JNIEnv *env, jobject this)
+{
+    SECKEYPrivateKey *privk;
+    int len;
+
+    if( getPrivateKey(env, this, &privk) != PR_SUCCESS) {
+        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL);
+        return 0;
+    }
+
+    len = PK11_SignatureLen(privk);
+    if( len <= 0 ) {
+        JSS_throwMsgPrErr(env, TOKEN_EXCEPTION,
+            "Unable to determine signature length");
+        return 0;
+    }
+
+    switch( SECKEY_GetPrivateKeyType(privk) ) {
+      case dsaKey:
+      case ecKey:
+        len += DER_SIG_OVERHEAD;
+        break;
+      default:
+        break;
+    }
+    return len;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_org_mozilla_jss_pkcs11_PK11Signature_engineVerifyNative
 	(JNIEnv *env, jobject this, jbyteArray sigArray)
@@ -324,26 +538,12 @@ finish:
 static SECOidTag
 getAlgorithm(JNIEnv *env, jobject sig)
 {
-    jclass sigClass;
-    jfieldID algField;
     jobject alg;
     SECOidTag retval=SEC_OID_UNKNOWN;
 
     PR_ASSERT(env!=NULL && sig!=NULL);
 
-    sigClass = (*env)->GetObjectClass(env, sig);
-    PR_ASSERT(sigClass != NULL);
-
-    algField = (*env)->GetFieldID(  env,
-                                    sigClass,
-                                    SIG_ALGORITHM_FIELD,
-                                    SIG_ALGORITHM_SIG);
-    if(algField == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    alg = (*env)->GetObjectField(env, sig, algField);
+    alg = (*env)->GetObjectField(env, sig, JSS_FIELD(PK11Signature, algorithm));
     if(alg == NULL) {
         ASSERT_OUTOFMEM(env);
         goto finish;
@@ -364,28 +564,10 @@ finish:
 static void
 setSigContext(JNIEnv *env, jobject sig, jobject context)
 {
-    jclass sigClass;
-    jfieldID contextField;
-
     PR_ASSERT(env!=NULL && sig!=NULL);
 
-    sigClass = (*env)->GetObjectClass(env, sig);
-    PR_ASSERT(sigClass!=NULL);
-
-    contextField = (*env)->GetFieldID(
-                                      env,
-                                      sigClass,
-                                      SIG_CONTEXT_PROXY_FIELD,
-                                      SIG_CONTEXT_PROXY_SIG);
-    if(contextField == NULL) {
-        ASSERT_OUTOFMEM(env);
-        /* This function doesn't advertise that it can throw exceptions,
-         * so we shouldn't throw one */
-        (*env)->ExceptionClear(env);
-        return;
-    }
-
-    (*env)->SetObjectField(env, sig, contextField, context);
+    (*env)->SetObjectField(env, sig, JSS_FIELD(PK11Signature, sigContext),
+        context);
 }
 
 /*
@@ -394,28 +576,13 @@ setSigContext(JNIEnv *env, jobject sig, jobject context)
 static PRStatus
 getSigContext(JNIEnv *env, jobject sig, void**pContext, SigContextType* pType)
 {
-    jfieldID contextField;
-    jclass sigClass;
     jobject proxy;
 
     PR_ASSERT(env!=NULL && sig!=NULL && pContext!=NULL && pType!=NULL);
+    PR_ASSERT( (*env)->IsInstanceOf(env, sig, JSS_CLASS(PK11Signature)) );
 
-    sigClass = (*env)->GetObjectClass(env, sig);
-#ifdef DEBUG
-    {
-        jclass realSigClass = (*env)->FindClass(env, PK11SIGNATURE_CLASS_NAME);
-        PR_ASSERT( (*env)->IsInstanceOf(env, sig, realSigClass) );
-    }
-#endif
-
-    contextField = (*env)->GetFieldID(env, sigClass, SIG_CONTEXT_PROXY_FIELD,
-                        SIG_CONTEXT_PROXY_SIG);
-    if(contextField == NULL) {
-        ASSERT_OUTOFMEM(env);
-        return PR_FAILURE;
-    }
-
-    proxy = (*env)->GetObjectField(env, sig, contextField);
+    proxy = (*env)->GetObjectField(env, sig,
+        JSS_FIELD(PK11Signature, sigContext));
     if(proxy == NULL) {
         PR_ASSERT(PR_FALSE);
         JSS_throw(env, TOKEN_EXCEPTION);
@@ -456,27 +623,12 @@ getPublicKey(JNIEnv *env, jobject sig, SECKEYPublicKey**key)
 static PRStatus
 getSomeKey(JNIEnv *env, jobject sig, void **key, short type)
 {
-    jfieldID keyField;
-    jclass sigClass;
     jobject keyProxy;
 
     PR_ASSERT(env!=NULL && sig!=NULL && key!=NULL);
+    PR_ASSERT( (*env)->IsInstanceOf(env, sig, JSS_CLASS(PK11Signature)) );
 
-    sigClass = (*env)->GetObjectClass(env, sig);
-#ifdef DEBUG
-    {
-    jclass realSigClass = (*env)->FindClass(env, PK11SIGNATURE_CLASS_NAME);
-    PR_ASSERT( (*env)->IsInstanceOf(env, sig, realSigClass) );
-    }
-#endif
-
-    keyField = (*env)->GetFieldID(env, sigClass, SIG_KEY_FIELD, SIG_KEY_SIG);
-    if(keyField == NULL) {
-        ASSERT_OUTOFMEM(env);
-        return PR_FAILURE;
-    }
-
-    keyProxy = (*env)->GetObjectField(env, sig, keyField);
+    keyProxy = (*env)->GetObjectField(env, sig, JSS_FIELD(PK11Signature, key));
     if(keyProxy == NULL) {
         PR_ASSERT(PR_FALSE);
         JSS_throw(env, TOKEN_EXCEPTION);
@@ -562,9 +714,6 @@ JSS_PK11_getSigContext(JNIEnv *env, jobject proxy, void**pContext,
 jobject
 JSS_PK11_wrapSigContextProxy(JNIEnv *env, void **ctxt, SigContextType type)
 {
-    jclass proxyClass;
-    jmethodID constructor;
-    jbyteArray byteArray;
     SigContextProxy *proxy=NULL;
 	jobject Context=NULL;
 
@@ -579,28 +728,9 @@ JSS_PK11_wrapSigContextProxy(JNIEnv *env, void **ctxt, SigContextType type)
     proxy->ctxt = *ctxt;
     proxy->type = type;
 
-    byteArray = JSS_ptrToByteArray(env, (void*)proxy);
-
-    /*
-     * Lookup the class and constructor
-     */
-    proxyClass = (*env)->FindClass(env, SIG_CONTEXT_PROXY_CLASS_NAME);
-    if( proxyClass == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-    constructor = (*env)->GetMethodID(
-                    env,
-                    proxyClass,
-                    SIG_CONTEXT_PROXY_CONSTRUCTOR_NAME,
-                    SIG_CONTEXT_PROXY_CONSTRUCTOR_SIG);
-    if(constructor == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     /* call the constructor */
-    Context = (*env)->NewObject(env, proxyClass, constructor, byteArray);
+    Context = (*env)->NewObject(env, JSS_CLASS(SigContextProxy),
+        JSS_METHOD(SigContextProxy, init), JSS_ptrToLong(proxy));
 
 finish:
 	if(Context==NULL) {
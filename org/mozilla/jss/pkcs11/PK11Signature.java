@@ -5,6 +5,7 @@
 package org.mozilla.jss.pkcs11;
 
 import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.NoSuchAlgorithmException;
@@ -12,6 +13,7 @@ import java.security.PublicKey;
 import java.security.SecureRandom;
 import java.security.SignatureException;
 import java.security.spec.AlgorithmParameterSpec;
+import java.util.List;
 
 import org.mozilla.jss.crypto.Algorithm;
 import org.mozilla.jss.crypto.NoSuchItemOnTokenException;
@@ -94,7 +96,7 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
 
         // Now initialize the signature context
         if( ! raw ) {
-            sigContext = null;
+            closeSigContext();
             initSigContext();
         }
 
@@ -162,7 +164,7 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
 		key = pubKey;
 
         if( ! raw ) {
-            sigContext = null;
+            closeSigContext();
             initVfyContext();
         }
 
@@ -175,13 +177,58 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
 	public void engineUpdate(byte b)
         throws SignatureException, TokenException
     {
-        engineUpdate(new byte[] {b}, 0, 1);
+        checkUpdateState();
+        if( raw ) {
+            rawInput.write(b);
+            return;
+        }
+        if( pendingLen == pending.length ) {
+            flush();
+        }
+        pending[pendingLen++] = b;
     }
 
     public void engineUpdate(byte[] b, int off, int len)
         throws SignatureException, TokenException
     {
         Assert._assert(b != null);
+        checkUpdateState();
+
+        if( raw ) {
+            rawInput.write(b, off, len);
+        } else if( len <= pending.length - pendingLen ) {
+            // small update: gather it rather than crossing into NSS
+            System.arraycopy(b, off, pending, pendingLen, len);
+            pendingLen += len;
+        } else {
+            flush();
+            if( len < pending.length ) {
+                System.arraycopy(b, off, pending, 0, len);
+                pendingLen = len;
+            } else {
+                engineUpdateNative( b, off, len);
+            }
+        }
+    }
+
+    /**
+     * Direct buffers, including memory-mapped files, are fed to NSS in
+     * place without being copied onto the Java heap.
+     */
+    public void engineUpdate(ByteBuffer data)
+        throws SignatureException, TokenException
+    {
+        if( raw || !data.isDirect() ) {
+            super.engineUpdate(data);
+            return;
+        }
+        checkUpdateState();
+        flush();
+        engineUpdateDirectNative(data, data.position(), data.remaining());
+        data.position(data.limit());
+    }
+
+    private void checkUpdateState() throws SignatureException {
         if( (state==SIGN || state==VERIFY) ) {
             if(!raw && sigContext==null) {
                 throw new SignatureException("Signature has no context");
@@ -196,17 +243,24 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
         Assert._assert(tokenProxy!=null);
         Assert._assert(algorithm!=null);
         Assert._assert(key!=null);
+    }
 
-        if( raw ) {
-            rawInput.write(b, off, len);
-        } else {
-            engineUpdateNative( b, off, len);
+    /**
+     * Hands any gathered small updates to the native context.
+     */
+    private void flush() throws TokenException {
+        if( pendingLen > 0 ) {
+            engineUpdateNative(pending, 0, pendingLen);
+            pendingLen = 0;
         }
     }
 
     protected native void engineUpdateNative(byte[] b, int off, int len)
         throws TokenException;
 
+    private native void engineUpdateDirectNative(ByteBuffer b, int off,
+        int len) throws TokenException;
+
 
     public byte[] engineSign()
         throws SignatureException, TokenException
@@ -230,10 +284,11 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
                 rawInput.toByteArray());
             rawInput.reset();
         } else {
+            flush();
             result = engineSignNative();
         }
 		state = UNINITIALIZED;
-		sigContext = null;
+		closeSigContext();
 
 		return result;
     }
@@ -260,6 +315,98 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
 		return sig.length;
     }
 
+    /**
+     * Signs every message with the one native context created by
+     * engineInitSign, in a single native call. The context is left ready
+     * for the next message or batch.
+     */
+    public int engineSignAll(List<ByteBuffer> messages, byte[] outbuf,
+        int offset, int[] sigLengths)
+        throws SignatureException, TokenException
+    {
+        int count = messages.size();
+
+        if( state != SIGN ) {
+            throw new SignatureException("Signature is not initialized");
+        }
+        if( !raw && sigContext == null ) {
+            throw new SignatureException("Signature has no context");
+        }
+        if( offset < 0 || offset > outbuf.length ) {
+            throw new ArrayIndexOutOfBoundsException(offset);
+        }
+        if( sigLengths.length < count ) {
+            throw new IllegalArgumentException(
+                "sigLengths has room for fewer than " + count + " lengths");
+        }
+        pendingLen = 0;
+
+        if( raw ) {
+            int pos = offset;
+            for( int i = 0; i < count; i++ ) {
+                ByteBuffer msg = messages.get(i);
+                byte[] hash = new byte[msg.remaining()];
+                msg.get(hash);
+                byte[] sig = engineRawSignNative(token, (PK11PrivKey)key,
+                    hash);
+                if( sig.length > outbuf.length - pos ) {
+                    throw new SignatureException(
+                        "outbuf is not sufficient to hold signatures");
+                }
+                System.arraycopy(sig, 0, outbuf, pos, sig.length);
+                sigLengths[i] = sig.length;
+                pos += sig.length;
+            }
+            rawInput.reset();
+            return pos - offset;
+        }
+
+        // Direct buffers are read in place and heap buffers through their
+        // arrays; only read-only heap buffers are copied.
+        Object[] data = new Object[count];
+        int[] offsets = new int[count];
+        int[] lengths = new int[count];
+        for( int i = 0; i < count; i++ ) {
+            ByteBuffer msg = messages.get(i);
+            if( msg.isDirect() ) {
+                data[i] = msg;
+                offsets[i] = msg.position();
+            } else if( msg.hasArray() ) {
+                data[i] = msg.array();
+                offsets[i] = msg.arrayOffset() + msg.position();
+            } else {
+                byte[] copy = new byte[msg.remaining()];
+                msg.duplicate().get(copy);
+                data[i] = copy;
+                offsets[i] = 0;
+            }
+            lengths[i] = msg.remaining();
+        }
+
+        int written = engineSignAllNative(data, offsets, lengths, outbuf,
+            offset, sigLengths);
+
+        for( ByteBuffer msg : messages ) {
+            msg.position(msg.limit());
+        }
+        return written;
+    }
+
+    private native int engineSignAllNative(Object[] data, int[] offsets,
+        int[] lengths, byte[] outbuf, int offset, int[] sigLengths)
+        throws SignatureException, TokenException;
+
+    public int engineGetMaxSignatureLength()
+        throws SignatureException, TokenException
+    {
+        if( state != SIGN ) {
+            throw new SignatureException("Signature is not initialized");
+        }
+        return getMaxSignatureLengthNative();
+    }
+
+    private native int getMaxSignatureLengthNative() throws TokenException;
+
     /**
      * Performs raw signing of the given hash with the given private key.
      */
@@ -299,10 +446,11 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
                 rawInput.toByteArray(), sigBytes);
             rawInput.reset();
         } else {
+            flush();
             result = engineVerifyNative(sigBytes);
         }
 		state = UNINITIALIZED;
-		sigContext = null;
+		closeSigContext();
 
 		return result;
     }
@@ -318,6 +466,18 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
 	native protected boolean engineVerifyNative(byte[] sigBytes)
 		throws SignatureException, TokenException;
 
+    /**
+     * Frees the native signature context, if any, without waiting for
+     * the garbage collector.
+     */
+    private void closeSigContext() {
+        pendingLen = 0;
+        if( sigContext != null ) {
+            sigContext.close();
+            sigContext = null;
+        }
+    }
+
     public void engineSetParameter(AlgorithmParameterSpec params)
         throws InvalidAlgorithmParameterException, TokenException
     {
@@ -333,6 +493,11 @@ final class PK11Signature extends org.mozilla.jss.crypto.SignatureSpi {
     protected boolean raw=false; // raw signing only, no hashing
     protected ByteArrayOutputStream rawInput;
 
+    // small updates waiting to be passed to the native context
+    private static final int UPDATE_BUFFER_SIZE = 512;
+    private final byte[] pending = new byte[UPDATE_BUFFER_SIZE];
+    private int pendingLen = 0;
+
 	// states
 	static public final int UNINITIALIZED = 0;
 	static public final int SIGN = 1;
@@ -343,7 +508,7 @@ class SigContextProxy extends NativeProxy {
 
     public static Logger logger = LoggerFactory.getLogger(SigContextProxy.class);
 
-    public SigContextProxy(byte[] pointer) {
+    public SigContextProxy(long pointer) {
         super(pointer);
     }
     protected native void releaseNativeResources();
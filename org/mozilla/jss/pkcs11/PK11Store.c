@@ -17,6 +17,7 @@
 #include <Algorithm.h>
 #include "pk11util.h"
 #include <java_ids.h>
+#include <jss_ids.h>
 #include <jss_exceptions.h>
 
 typedef struct
@@ -42,8 +43,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putSymKeysInVector
 {
     PK11SlotInfo *slot;
     jobject object = NULL;
-    jclass vectorClass;
-    jmethodID addElement;
 
     PK11SymKey *firstSymKey= NULL;
     PK11SymKey *sk  = NULL;
@@ -61,21 +60,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putSymKeysInVector
     }
     PR_ASSERT(slot!=NULL);
 
-    vectorClass = (*env)->GetObjectClass(env, keyVector);
-    if(vectorClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    addElement = (*env)->GetMethodID(env,
-                                     vectorClass,
-                                     VECTOR_ADD_ELEMENT_NAME,
-                                     VECTOR_ADD_ELEMENT_SIG);
-    if(addElement == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     PK11_Authenticate(slot, PR_TRUE /*load certs*/, NULL /*wincx*/);
 
     /* Obtain the symmetric key list. */
@@ -97,7 +81,8 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putSymKeysInVector
             /***************************************************
             * Insert the key into the vector
             ***************************************************/
-            (*env)->CallVoidMethod(env, keyVector, addElement, object);
+            (*env)->CallVoidMethod(env, keyVector,
+                JSS_METHOD(Vector, addElement), object);
         }
 
         sk = PK11_GetNextSymKey( nextSymKey );
@@ -120,8 +105,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPrivateKeys
     SECKEYPrivateKeyListNode *node = NULL;
     SECKEYPrivateKey* key = NULL;
     jobject privateKey = NULL;
-    jclass collectionClass;
-    jmethodID collectionAdd;
 
     PR_ASSERT(env!=NULL && this!=NULL && collection!=NULL);
 
@@ -150,25 +133,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPrivateKeys
         goto finish;
     }
 
-    // get Collection class
-    collectionClass = (*env)->FindClass(env, COLLECTION_CLASS_NAME);
-
-    if (collectionClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    // get Collection.add() method
-    collectionAdd = (*env)->GetMethodID(env,
-                                     collectionClass,
-                                     COLLECTION_ADD_NAME,
-                                     COLLECTION_ADD_SIG);
-
-    if (collectionAdd == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     for(    node = PRIVKEY_LIST_HEAD(list);
             !PRIVKEY_LIST_END(node, list);
             node = PRIVKEY_LIST_NEXT(node) )
@@ -182,7 +146,8 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPrivateKeys
         }
 
         // add private key into collection
-        (*env)->CallBooleanMethod(env, collection, collectionAdd, privateKey);
+        (*env)->CallBooleanMethod(env, collection,
+            JSS_METHOD(Collection, add), privateKey);
     }
 
 finish:
@@ -204,8 +169,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPublicKeys
     SECKEYPublicKeyListNode *node = NULL;
     SECKEYPublicKey* key = NULL;
     jobject publicKey = NULL;
-    jclass collectionClass;
-    jmethodID collectionAdd;
 
     PR_ASSERT(env!=NULL && this!=NULL && collection!=NULL);
 
@@ -234,25 +197,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPublicKeys
         goto finish;
     }
 
-    // get Collection class
-    collectionClass = (*env)->FindClass(env, COLLECTION_CLASS_NAME);
-
-    if (collectionClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    // get Collection.add() method
-    collectionAdd = (*env)->GetMethodID(env,
-                                     collectionClass,
-                                     COLLECTION_ADD_NAME,
-                                     COLLECTION_ADD_SIG);
-
-    if (collectionAdd == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     for(    node = PUBKEY_LIST_HEAD(list);
             !PUBKEY_LIST_END(node, list);
             node = PUBKEY_LIST_NEXT(node) )
@@ -266,7 +210,8 @@ Java_org_mozilla_jss_pkcs11_PK11Store_loadPublicKeys
         }
 
         // add public key into collection
-        (*env)->CallBooleanMethod(env, collection, collectionAdd, publicKey);
+        (*env)->CallBooleanMethod(env, collection,
+            JSS_METHOD(Collection, add), publicKey);
     }
 
 finish:
@@ -285,8 +230,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putCertsInVector
 {
     PK11SlotInfo *slot;
     PK11SlotInfo *slotCopy;
-    jclass vectorClass;
-    jmethodID addElement;
     CERTCertList *certList = NULL;
     CERTCertificate *certCopy;
     CERTCertListNode *node = NULL;
@@ -314,23 +257,6 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putCertsInVector
         goto finish;
     }
 
-    /**************************************************
-     * Get JNI ids
-     **************************************************/
-    vectorClass = (*env)->GetObjectClass(env, certVector);
-    if(vectorClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-    addElement = (*env)->GetMethodID(env,
-                                     vectorClass,
-                                     VECTOR_ADD_ELEMENT_NAME,
-                                     VECTOR_ADD_ELEMENT_SIG);
-    if(addElement == NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     for(    node = CERT_LIST_HEAD(certList);
             !CERT_LIST_END(node, certList);
             node = CERT_LIST_NEXT(node) )
@@ -350,7 +276,8 @@ Java_org_mozilla_jss_pkcs11_PK11Store_putCertsInVector
         /***************************************************
         * Insert the cert into the vector
         ***************************************************/
-        (*env)->CallVoidMethod(env, certVector, addElement, object);
+        (*env)->CallVoidMethod(env, certVector,
+            JSS_METHOD(Vector, addElement), object);
     }
 
 finish:
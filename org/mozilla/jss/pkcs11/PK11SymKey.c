@@ -28,7 +28,6 @@ JSS_PK11_wrapSymKey(JNIEnv *env, PK11SymKey **symKey)
 {
     jclass keyClass;
     jmethodID constructor;
-    jbyteArray ptrArray;
     jobject Key=NULL;
     char *nickname = NULL;
     jstring jnickname = NULL;
@@ -57,13 +56,9 @@ JSS_PK11_wrapSymKey(JNIEnv *env, PK11SymKey **symKey)
         goto finish;
     }
 
-    /* convert the pointer to a byte array */
-    ptrArray = JSS_ptrToByteArray(env, (void*)*symKey);
-    if( ptrArray == NULL ) {
-        goto finish;
-    }
     /* call the constructor */
-    Key = (*env)->NewObject(env, keyClass, constructor, ptrArray, jnickname);
+    Key = (*env)->NewObject(env, keyClass, constructor,
+        JSS_ptrToLong(*symKey), jnickname);
 
 finish:
     if(Key == NULL) {
@@ -10,14 +10,14 @@ import org.mozilla.jss.util.Assert;
 
 public final class PK11SymKey implements SymmetricKey {
 
-    protected PK11SymKey(byte[] pointer) {
-        Assert._assert(pointer!=null);
+    protected PK11SymKey(long pointer) {
+        Assert._assert(pointer!=0);
         keyProxy  = new SymKeyProxy(pointer);
         nickName = null;
     }
 
-    protected PK11SymKey(byte[] pointer,String nickName) {
-        Assert._assert(pointer!=null);
+    protected PK11SymKey(long pointer,String nickName) {
+        Assert._assert(pointer!=0);
         keyProxy  = new SymKeyProxy(pointer);
         this.nickName = nickName;
      }
@@ -103,7 +103,7 @@ public final class PK11SymKey implements SymmetricKey {
 
 class SymKeyProxy extends KeyProxy {
 
-    public SymKeyProxy(byte[] pointer) {
+    public SymKeyProxy(long pointer) {
         super(pointer);
     }
 
@@ -58,7 +58,6 @@ JSS_PK11_wrapPK11Token(JNIEnv *env, PK11SlotInfo **slot)
 {
     jclass tokenClass;
     jmethodID constructor;
-    jbyteArray byteArray;
 	jobject Token=NULL;
     jboolean internal;
     jboolean keyStorage;
@@ -68,8 +67,6 @@ JSS_PK11_wrapPK11Token(JNIEnv *env, PK11SlotInfo **slot)
     internal = (*slot == PK11_GetInternalSlot());
     keyStorage = (*slot == PK11_GetInternalKeySlot());
 
-    byteArray = JSS_ptrToByteArray(env, (void*)*slot);
-
     /*
      * Lookup the class and constructor
      */
@@ -93,7 +90,7 @@ JSS_PK11_wrapPK11Token(JNIEnv *env, PK11SlotInfo **slot)
     Token = (*env)->NewObject(env,
                               tokenClass,
                               constructor,
-                              byteArray,
+                              JSS_ptrToLong(*slot),
                               internal,
                               keyStorage);
 
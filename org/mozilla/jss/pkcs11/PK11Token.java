@@ -16,6 +16,7 @@ import org.mozilla.jss.crypto.CryptoStore;
 import org.mozilla.jss.crypto.CryptoToken;
 import org.mozilla.jss.crypto.DigestAlgorithm;
 import org.mozilla.jss.crypto.EncryptionAlgorithm;
+import org.mozilla.jss.crypto.HMACAlgorithm;
 import org.mozilla.jss.crypto.JSSMessageDigest;
 import org.mozilla.jss.crypto.KeyGenAlgorithm;
 import org.mozilla.jss.crypto.KeyGenerator;
@@ -91,6 +92,40 @@ public final class PK11Token implements CryptoToken {
         return new PK11MessageDigest(this, algorithm);
     }
 
+    public byte[]
+    digest(DigestAlgorithm algorithm, byte[] input, int offset, int len)
+            throws NoSuchAlgorithmException,
+            java.security.DigestException
+    {
+        // NSS hashes on the best slot for the mechanism, which is only
+        // known to be this token when this is the internal token.
+        if( ! isInternalCryptoToken() ) {
+            return CryptoToken.super.digest(algorithm, input, offset, len);
+        }
+        return PK11MessageDigest.digestOnce(this, algorithm, input, offset,
+            len);
+    }
+
+    public byte[]
+    digest(DigestAlgorithm algorithm, java.nio.ByteBuffer input)
+            throws NoSuchAlgorithmException,
+            java.security.DigestException
+    {
+        if( ! isInternalCryptoToken() ) {
+            return CryptoToken.super.digest(algorithm, input);
+        }
+        return PK11MessageDigest.digestOnce(this, algorithm, input);
+    }
+
+    public byte[]
+    hmac(SymmetricKey key, HMACAlgorithm algorithm, byte[] input,
+            int offset, int len)
+            throws NoSuchAlgorithmException,
+            java.security.DigestException, InvalidKeyException
+    {
+        return PK11MessageDigest.hmacOnce(key, algorithm, input, offset, len);
+    }
+
     public Cipher
     getCipherContext(EncryptionAlgorithm algorithm)
             throws NoSuchAlgorithmException, TokenException
@@ -548,8 +583,8 @@ public final class PK11Token implements CryptoToken {
      * native code.
      * @param pointer A byte array containing a pointer to a PKCS #11 slot.
      */
-    protected PK11Token(byte[] pointer, boolean internal, boolean keyStorage) {
-        Assert._assert(pointer!=null);
+    protected PK11Token(long pointer, boolean internal, boolean keyStorage) {
+        Assert._assert(pointer!=0);
         tokenProxy = new TokenProxy(pointer);
         mIsInternalCryptoToken = internal;
         mIsInternalKeyStorageToken = keyStorage;
@@ -19,7 +19,7 @@ public final class PK11TokenCert extends PK11Cert implements TokenCertificate
         return super.getOwningToken();
     }
 
-    PK11TokenCert(byte[] certPtr, byte[] slotPtr, String nickname) {
+    PK11TokenCert(long certPtr, long slotPtr, String nickname) {
         super(certPtr, slotPtr, nickname);
     }
 }
@@ -12,7 +12,7 @@ public final class TokenProxy extends NativeProxy {
 
     public static Logger logger = LoggerFactory.getLogger(TokenProxy.class);
 
-    public TokenProxy(byte[] pointer) {
+    public TokenProxy(long pointer) {
         super(pointer);
     }
 
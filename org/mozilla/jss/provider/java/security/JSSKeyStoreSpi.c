@@ -13,6 +13,7 @@
 #include <certdb.h>
 #include <pk11util.h>
 #include "java_ids.h"
+#include <jss_ids.h>
 
 static PRStatus
 getTokenSlotPtr(JNIEnv *env, jobject keyStoreObj, PK11SlotInfo **ptr)
@@ -335,33 +336,14 @@ Java_org_mozilla_jss_provider_java_security_JSSKeyStoreSpi_getRawAliases
     }
 
     /*
-     * Create the vector object and get its method IDs
+     * Create the set object
      */
-    {
-        jclass setClass;
-        jmethodID setCons;
-
-        setClass = (*env)->FindClass(env, "java/util/HashSet");
-        if( setClass == NULL ) {
-            /* should have thrown an exception */
-            goto finish;
-        }
-        setCons = (*env)->GetMethodID(env, setClass, "<init>", "()V");
-        if( setCons == NULL ) {
-            goto finish;
-        }
-
-        setObj = (*env)->NewObject(env, setClass, setCons);
-        if( setObj == NULL ) {
-            goto finish;
-        }
-
-        setAdd = (*env)->GetMethodID(env, setClass, "add",
-            "(Ljava/lang/Object;)Z");
-        if( setAdd == NULL ) {
-            goto finish;
-        }
+    setObj = (*env)->NewObject(env, JSS_CLASS(HashSet),
+        JSS_METHOD(HashSet, init));
+    if( setObj == NULL ) {
+        goto finish;
     }
+    setAdd = JSS_METHOD(HashSet, add);
 
     cbinfo.setObj = setObj;
     cbinfo.setAdd = setAdd;
@@ -835,7 +817,6 @@ Java_org_mozilla_jss_provider_java_security_JSSKeyStoreSpi_engineSetKeyEntryNati
     (JNIEnv *env, jobject this, jstring alias, jobject keyObj,
         jcharArray password, jobjectArray certChain)
 {
-    jclass privkClass, symkClass;
     const char *nickname = NULL;
     SECKEYPrivateKey *tokenPrivk=NULL;
     PK11SymKey *tokenSymk=NULL;
@@ -851,14 +832,7 @@ Java_org_mozilla_jss_provider_java_security_JSSKeyStoreSpi_engineSetKeyEntryNati
         goto finish;
     }
 
-    privkClass = (*env)->FindClass(env, PK11PRIVKEY_CLASS_NAME);
-    symkClass = (*env)->FindClass(env, PK11SYMKEY_CLASS_NAME);
-    if( privkClass==NULL || symkClass==NULL) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    if( (*env)->IsInstanceOf(env, keyObj, privkClass) ) {
+    if( (*env)->IsInstanceOf(env, keyObj, JSS_CLASS(PK11PrivKey)) ) {
         SECKEYPrivateKey *privk;
 
         if( JSS_PK11_getPrivKeyPtr(env, keyObj, &privk) != PR_SUCCESS ) {
@@ -878,7 +852,7 @@ Java_org_mozilla_jss_provider_java_security_JSSKeyStoreSpi_engineSetKeyEntryNati
                 "Failed to set alias of copied private key");
             goto finish;
         }
-    } else if( (*env)->IsInstanceOf(env, keyObj, symkClass) ) {
+    } else if( (*env)->IsInstanceOf(env, keyObj, JSS_CLASS(PK11SymKey)) ) {
         PK11SymKey *symk;
 
         if( JSS_PK11_getSymKeyPtr(env, keyObj, &symk) != PR_SUCCESS ) {
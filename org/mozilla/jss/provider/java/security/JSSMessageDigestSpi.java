@@ -4,6 +4,7 @@
 
 package org.mozilla.jss.provider.java.security;
 
+import java.nio.ByteBuffer;
 import java.security.DigestException;
 import java.security.MessageDigestSpi;
 
@@ -16,7 +17,9 @@ import org.mozilla.jss.crypto.TokenException;
 import org.mozilla.jss.crypto.TokenRuntimeException;
 import org.mozilla.jss.crypto.TokenSupplierManager;
 
-public abstract class JSSMessageDigestSpi extends MessageDigestSpi {
+public abstract class JSSMessageDigestSpi extends MessageDigestSpi
+    implements Cloneable
+{
 
     private JSSMessageDigest digest;
 
@@ -48,7 +51,9 @@ public abstract class JSSMessageDigestSpi extends MessageDigestSpi {
     }
 
     public Object clone() throws CloneNotSupportedException {
-        throw new CloneNotSupportedException();
+        JSSMessageDigestSpi copy = (JSSMessageDigestSpi) super.clone();
+        copy.digest = (JSSMessageDigest) digest.clone();
+        return copy;
     }
 
     public byte[] engineDigest() {
@@ -93,6 +98,14 @@ public abstract class JSSMessageDigestSpi extends MessageDigestSpi {
       }
     }
 
+    public void engineUpdate(ByteBuffer input) {
+      try {
+        digest.update(input);
+      } catch(java.security.DigestException de) {
+        throw new TokenRuntimeException(de.getMessage());
+      }
+    }
+
     public static class SHA1 extends JSSMessageDigestSpi {
         public SHA1() {
             super( DigestAlgorithm.SHA1 );
@@ -4,6 +4,8 @@
 
 package org.mozilla.jss.provider.java.security;
 
+import java.util.Arrays;
+
 import org.mozilla.jss.crypto.TokenSupplierManager;
 import org.mozilla.jss.crypto.JSSSecureRandom;
 
@@ -33,4 +35,68 @@ public class JSSSecureRandomSpi extends java.security.SecureRandomSpi {
     engineSetSeed(byte[] seed) {
         engine.setSeed(seed);
     }
+
+    /**
+     * Serves small requests from a per-thread pool of random bytes,
+     * refilled from the token POOL_SIZE bytes at a time, so that a stream
+     * of nonce-sized requests costs one native call per refill rather
+     * than one per request. Requests larger than MAX_POOLED go straight
+     * to the token. Bytes are wiped from the pool as they are handed out.
+     *
+     * <p>Seeding applies to the token as usual and discards the calling
+     * thread's pool; other threads keep serving their remaining pooled
+     * bytes until their next refill.
+     */
+    public static class Pooled extends JSSSecureRandomSpi {
+
+        private static final long serialVersionUID = 1L;
+
+        static final int POOL_SIZE = 4096;
+        static final int MAX_POOLED = 256;
+
+        private static final class Pool {
+            final byte[] bytes = new byte[POOL_SIZE];
+            int pos = POOL_SIZE;
+        }
+
+        private static final ThreadLocal<Pool> pools =
+            new ThreadLocal<Pool>() {
+                @Override
+                protected Pool initialValue() {
+                    return new Pool();
+                }
+            };
+
+        @Override
+        protected void
+        engineNextBytes(byte[] bytes) {
+            if (bytes.length > MAX_POOLED) {
+                engine.nextBytes(bytes);
+                return;
+            }
+
+            Pool pool = pools.get();
+            int offset = 0;
+            while (offset < bytes.length) {
+                if (pool.pos == POOL_SIZE) {
+                    engine.nextBytes(pool.bytes);
+                    pool.pos = 0;
+                }
+                int n = Math.min(bytes.length - offset, POOL_SIZE - pool.pos);
+                System.arraycopy(pool.bytes, pool.pos, bytes, offset, n);
+                Arrays.fill(pool.bytes, pool.pos, pool.pos + n, (byte) 0);
+                pool.pos += n;
+                offset += n;
+            }
+        }
+
+        @Override
+        protected void
+        engineSetSeed(byte[] seed) {
+            super.engineSetSeed(seed);
+            Pool pool = pools.get();
+            Arrays.fill(pool.bytes, (byte) 0);
+            pool.pos = POOL_SIZE;
+        }
+    }
 }
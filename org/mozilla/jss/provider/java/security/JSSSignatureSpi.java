@@ -3,12 +3,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 package org.mozilla.jss.provider.java.security;
 
+import java.nio.ByteBuffer;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.InvalidParameterException;
 import java.security.KeyFactory;
 import java.security.NoSuchAlgorithmException;
 import java.security.NoSuchProviderException;
+import java.security.ProviderException;
 import java.security.PublicKey;
 import java.security.SecureRandom;
 import java.security.SignatureException;
@@ -127,6 +129,16 @@ class JSSSignatureSpi extends java.security.SignatureSpi {
         }
     }
 
+    public void engineUpdate(ByteBuffer input) {
+        try {
+            sig.update(input);
+        } catch( TokenException e) {
+            throw new ProviderException("TokenException: "+e.toString(), e);
+        } catch( SignatureException e) {
+            throw new ProviderException("update() failed", e);
+        }
+    }
+
     public byte[] engineSign() throws SignatureException {
         try {
             return sig.sign();
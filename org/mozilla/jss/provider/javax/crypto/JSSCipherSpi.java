@@ -4,6 +4,7 @@
 
 package org.mozilla.jss.provider.javax.crypto;
 
+import java.nio.ByteBuffer;
 import java.security.AlgorithmParameters;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
@@ -330,13 +331,28 @@ class JSSCipherSpi extends javax.crypto.CipherSpi {
     public int engineUpdate(byte[] input, int inputOffset, int inputLen,
         byte[] output, int outputOffset) throws ShortBufferException
     {
-        byte[] bytes = engineUpdate(input, inputOffset, inputLen);
-        if( bytes.length > output.length-outputOffset ) {
-            throw new ShortBufferException(bytes.length +  " needed, " +
-                (output.length-outputOffset) + " supplied");
+        if(cipher == null) {
+            throw new IllegalStateException();
+        }
+        try {
+            return cipher.update(input, inputOffset, inputLen,
+                        output, outputOffset);
+        } catch(TokenException te) {
+            throw new TokenRuntimeException(te.getMessage());
+        }
+    }
+
+    public int engineUpdate(ByteBuffer input, ByteBuffer output)
+        throws ShortBufferException
+    {
+        if(cipher == null) {
+            throw new IllegalStateException();
+        }
+        try {
+            return cipher.update(input, output);
+        } catch(TokenException te) {
+            throw new TokenRuntimeException(te.getMessage());
         }
-        System.arraycopy(bytes, 0, output, outputOffset, bytes.length);
-        return bytes.length;
     }
 
     public byte[] engineDoFinal(byte[] input, int inputOffset, int inputLen)
@@ -367,13 +383,33 @@ class JSSCipherSpi extends javax.crypto.CipherSpi {
             throws ShortBufferException, IllegalBlockSizeException,
             BadPaddingException
     {
-        byte[] bytes = engineDoFinal(input, inputOffset, inputLen);
-        if( bytes.length > output.length-outputOffset ) {
-            throw new ShortBufferException(bytes.length +  " needed, " +
-                (output.length-outputOffset) + " supplied");
+        if( cipher == null ) {
+            throw new IllegalStateException();
+        }
+        try {
+            return cipher.doFinal(input, inputOffset, inputLen,
+                        output, outputOffset);
+        } catch(org.mozilla.jss.crypto.IllegalBlockSizeException ibse) {
+            throw new IllegalBlockSizeException(ibse.getMessage());
+        } catch(TokenException te) {
+            throw new TokenRuntimeException(te.getMessage());
+        }
+    }
+
+    public int engineDoFinal(ByteBuffer input, ByteBuffer output)
+            throws ShortBufferException, IllegalBlockSizeException,
+            BadPaddingException
+    {
+        if( cipher == null ) {
+            throw new IllegalStateException();
+        }
+        try {
+            return cipher.doFinal(input, output);
+        } catch(org.mozilla.jss.crypto.IllegalBlockSizeException ibse) {
+            throw new IllegalBlockSizeException(ibse.getMessage());
+        } catch(TokenException te) {
+            throw new TokenRuntimeException(te.getMessage());
         }
-        System.arraycopy(bytes, 0, output, outputOffset, bytes.length);
-        return bytes.length;
     }
 
     public byte[] engineWrap(Key key)
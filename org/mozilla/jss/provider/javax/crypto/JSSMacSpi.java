@@ -4,6 +4,7 @@
 
 package org.mozilla.jss.provider.javax.crypto;
 
+import java.nio.ByteBuffer;
 import java.security.DigestException;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
@@ -18,7 +19,7 @@ import org.mozilla.jss.crypto.SecretKeyFacade;
 import org.mozilla.jss.crypto.TokenRuntimeException;
 import org.mozilla.jss.crypto.TokenSupplierManager;
 
-class JSSMacSpi extends javax.crypto.MacSpi {
+class JSSMacSpi extends javax.crypto.MacSpi implements Cloneable {
 
     private JSSMessageDigest digest=null;
     private HMACAlgorithm alg;
@@ -72,6 +73,14 @@ class JSSMacSpi extends javax.crypto.MacSpi {
       }
     }
 
+    public void engineUpdate(ByteBuffer input) {
+      try {
+        digest.update(input);
+      } catch(DigestException de) {
+        throw new TokenRuntimeException("DigestException: " + de.getMessage());
+      }
+    }
+
     public byte[] engineDoFinal() {
       try {
         return digest.digest();
@@ -88,8 +97,16 @@ class JSSMacSpi extends javax.crypto.MacSpi {
       }
     }
 
+    /**
+     * Copies the native context, so a Mac that has been initialized once
+     * can be cloned per message without setting up the key again.
+     */
     public Object clone() throws CloneNotSupportedException {
-        throw new CloneNotSupportedException();
+        JSSMacSpi copy = (JSSMacSpi) super.clone();
+        if( digest != null ) {
+            copy.digest = (JSSMessageDigest) digest.clone();
+        }
+        return copy;
     }
 
     public static class HmacSHA1 extends JSSMacSpi {
@@ -0,0 +1,826 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <nspr.h>
+#include <jni.h>
+#include <ssl.h>
+#include <sslerr.h>
+#include <string.h>
+
+#include <jssutil.h>
+#include <jss_exceptions.h>
+#include <java_ids.h>
+#include <pk11util.h>
+#include "_jni/org_mozilla_jss_ssl_JSSEngine.h"
+#include "jssl.h"
+
+/*
+ * The SSLEngine drives NSS over an in-memory transport instead of a
+ * network socket. The bottom PRFileDesc layer holds two byte queues:
+ * "inbound" receives the TLS records handed to unwrap() and is read by
+ * NSS, "outbound" collects the records NSS writes and is drained by
+ * wrap(). The layer reports itself as non-blocking, so whenever NSS runs
+ * out of input it fails with PR_WOULD_BLOCK_ERROR and control returns to
+ * the caller's event loop.
+ */
+
+typedef struct {
+    unsigned char *data;
+    PRInt32 capacity;
+    PRInt32 start;  /* offset of the first unread byte */
+    PRInt32 len;    /* number of unread bytes */
+} EngineBuffer;
+
+typedef struct {
+    EngineBuffer inbound;
+    EngineBuffer outbound;
+    PRBool inboundClosed;
+    PRNetAddr peerAddr;
+} EngineTransport;
+
+#define ENGINE_BUFFER_MIN 4096
+
+static PRDescIdentity engineIdentity = PR_INVALID_IO_LAYER;
+static PRCallOnceType engineIdentityOnce;
+
+static PRStatus
+initEngineIdentity(void)
+{
+    engineIdentity = PR_GetUniqueIdentity("JSS SSLEngine transport");
+    return (engineIdentity == PR_INVALID_IO_LAYER) ? PR_FAILURE : PR_SUCCESS;
+}
+
+static PRIntn
+invalidInt()
+{
+    PR_ASSERT(!"invalidInt called");
+    PR_SetError(PR_NOT_IMPLEMENTED_ERROR, 0);
+    return -1;
+}
+
+/*
+ * Appends len bytes to the buffer, growing it as needed. Returns
+ * PR_FAILURE if memory could not be allocated.
+ */
+static PRStatus
+engineBufferAppend(EngineBuffer *buf, const void *src, PRInt32 len)
+{
+    if( buf->start + buf->len + len > buf->capacity ) {
+        if( buf->len + len <= buf->capacity ) {
+            /* there is room once the consumed prefix is dropped */
+            memmove(buf->data, buf->data + buf->start, buf->len);
+        } else {
+            PRInt32 newCap = buf->capacity * 2;
+            unsigned char *newData;
+
+            if( newCap < buf->len + len ) newCap = buf->len + len;
+            if( newCap < ENGINE_BUFFER_MIN ) newCap = ENGINE_BUFFER_MIN;
+            newData = PR_Malloc(newCap);
+            if( newData == NULL ) {
+                PR_SetError(PR_OUT_OF_MEMORY_ERROR, 0);
+                return PR_FAILURE;
+            }
+            if( buf->len > 0 ) {
+                memcpy(newData, buf->data + buf->start, buf->len);
+            }
+            PR_Free(buf->data);
+            buf->data = newData;
+            buf->capacity = newCap;
+        }
+        buf->start = 0;
+    }
+    memcpy(buf->data + buf->start + buf->len, src, len);
+    buf->len += len;
+    return PR_SUCCESS;
+}
+
+/*
+ * Removes up to len bytes from the front of the buffer into dest.
+ * Returns the number of bytes copied.
+ */
+static PRInt32
+engineBufferTake(EngineBuffer *buf, void *dest, PRInt32 len)
+{
+    if( len > buf->len ) len = buf->len;
+    memcpy(dest, buf->data + buf->start, len);
+    buf->start += len;
+    buf->len -= len;
+    if( buf->len == 0 ) {
+        buf->start = 0;
+    }
+    return len;
+}
+
+static PRInt32
+engine_recv(PRFileDesc *fd, void *buf, PRInt32 amount, PRIntn flags,
+    PRIntervalTime timeout)
+{
+    EngineTransport *transport = (EngineTransport*) fd->secret;
+
+    if( transport->inbound.len == 0 ) {
+        if( transport->inboundClosed ) {
+            return 0;
+        }
+        PR_SetError(PR_WOULD_BLOCK_ERROR, 0);
+        return -1;
+    }
+    return engineBufferTake(&transport->inbound, buf, amount);
+}
+
+static PRInt32
+engine_read(PRFileDesc *fd, void *buf, PRInt32 amount)
+{
+    return engine_recv(fd, buf, amount, 0, PR_INTERVAL_NO_WAIT);
+}
+
+static PRInt32
+engine_send(PRFileDesc *fd, const void *buf, PRInt32 amount, PRIntn flags,
+    PRIntervalTime timeout)
+{
+    EngineTransport *transport = (EngineTransport*) fd->secret;
+
+    if( engineBufferAppend(&transport->outbound, buf, amount) != PR_SUCCESS ) {
+        return -1;
+    }
+    return amount;
+}
+
+static PRInt32
+engine_write(PRFileDesc *fd, const void *buf, PRInt32 amount)
+{
+    return engine_send(fd, buf, amount, 0, PR_INTERVAL_NO_WAIT);
+}
+
+static PRInt32
+engine_writev(PRFileDesc *fd, const PRIOVec *iov, PRInt32 iov_size,
+    PRIntervalTime timeout)
+{
+    PRInt32 total = 0;
+    int i;
+
+    for( i = 0; i < iov_size; i++ ) {
+        if( engine_send(fd, iov[i].iov_base, iov[i].iov_len, 0, timeout) < 0 ) {
+            return -1;
+        }
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+static PRStatus
+engine_shutdown(PRFileDesc *fd, PRShutdownHow how)
+{
+    /* close_notify has already been queued by the SSL layer above us */
+    return PR_SUCCESS;
+}
+
+static PRStatus
+engine_close(PRFileDesc *fd)
+{
+    EngineTransport *transport = (EngineTransport*) fd->secret;
+
+    if( transport != NULL ) {
+        PR_Free(transport->inbound.data);
+        PR_Free(transport->outbound.data);
+        PR_Free(transport);
+        fd->secret = NULL;
+    }
+    fd->dtor(fd);
+    return PR_SUCCESS;
+}
+
+static PRStatus
+engine_getPeerName(PRFileDesc *fd, PRNetAddr *addr)
+{
+    *addr = ((EngineTransport*) fd->secret)->peerAddr;
+    return PR_SUCCESS;
+}
+
+static PRStatus
+engine_getSockName(PRFileDesc *fd, PRNetAddr *addr)
+{
+    memset(addr, 0, sizeof(PRNetAddr));
+    addr->inet.family = PR_AF_INET;
+    return PR_SUCCESS;
+}
+
+static PRStatus
+engine_getSockOpt(PRFileDesc *fd, PRSocketOptionData *data)
+{
+    switch( data->option ) {
+      case PR_SockOpt_Nonblocking:
+        data->value.non_blocking = PR_TRUE;
+        return PR_SUCCESS;
+      default:
+        PR_SetError(PR_OPERATION_NOT_SUPPORTED_ERROR, 0);
+        return PR_FAILURE;
+    }
+}
+
+static PRStatus
+engine_setSockOpt(PRFileDesc *fd, const PRSocketOptionData *data)
+{
+    /* socket options have no meaning for an in-memory transport */
+    return PR_SUCCESS;
+}
+
+static const PRIOMethods engineMethods = {
+    PR_DESC_SOCKET_TCP,
+    (PRCloseFN) engine_close,
+    (PRReadFN) engine_read,
+    (PRWriteFN) engine_write,
+    (PRAvailableFN) invalidInt,
+    (PRAvailable64FN) invalidInt,
+    (PRFsyncFN) invalidInt,
+    (PRSeekFN) invalidInt,
+    (PRSeek64FN) invalidInt,
+    (PRFileInfoFN) invalidInt,
+    (PRFileInfo64FN) invalidInt,
+    (PRWritevFN) engine_writev,
+    (PRConnectFN) invalidInt,
+    (PRAcceptFN) invalidInt,
+    (PRBindFN) invalidInt,
+    (PRListenFN) invalidInt,
+    (PRShutdownFN) engine_shutdown,
+    (PRRecvFN) engine_recv,
+    (PRSendFN) engine_send,
+    (PRRecvfromFN) invalidInt,
+    (PRSendtoFN) invalidInt,
+    (PRPollFN) invalidInt,
+    (PRAcceptreadFN) invalidInt,
+    (PRTransmitfileFN) invalidInt,
+    (PRGetsocknameFN) engine_getSockName,
+    (PRGetpeernameFN) engine_getPeerName,
+    (PRReservedFN) invalidInt,
+    (PRReservedFN) invalidInt,
+    (PRGetsocketoptionFN) engine_getSockOpt,
+    (PRSetsocketoptionFN) engine_setSockOpt,
+    (PRSendfileFN) invalidInt,
+    (PRConnectcontinueFN) invalidInt,
+    (PRReservedFN) invalidInt,
+    (PRReservedFN) invalidInt,
+    (PRReservedFN) invalidInt,
+    (PRReservedFN) invalidInt
+};
+
+static PRFileDesc*
+newEngineTransport(jint port)
+{
+    PRFileDesc *fd;
+    EngineTransport *transport;
+
+    if( PR_CallOnce(&engineIdentityOnce, initEngineIdentity) != PR_SUCCESS ) {
+        return NULL;
+    }
+
+    transport = PR_NEWZAP(EngineTransport);
+    if( transport == NULL ) {
+        return NULL;
+    }
+    transport->peerAddr.inet.family = PR_AF_INET;
+    transport->peerAddr.inet.port = PR_htons((PRUint16) port);
+
+    fd = PR_CreateIOLayerStub(engineIdentity, &engineMethods);
+    if( fd == NULL ) {
+        PR_Free(transport);
+        return NULL;
+    }
+    fd->secret = (PRFilePrivate*) transport;
+    return fd;
+}
+
+/*
+ * Returns the in-memory transport underneath the SSL layer of the
+ * engine, or NULL with an exception thrown.
+ */
+static EngineTransport*
+getTransport(JNIEnv *env, jobject self, JSSL_SocketData **sockp)
+{
+    PRFileDesc *layer;
+
+    if( JSSL_getSockData(env, self, sockp) != PR_SUCCESS ) {
+        return NULL;
+    }
+    layer = PR_GetIdentitiesLayer((*sockp)->fd, engineIdentity);
+    if( layer == NULL || layer->secret == NULL ) {
+        JSS_throwMsg(env, SOCKET_EXCEPTION,
+            "SSLEngine transport has been closed");
+        return NULL;
+    }
+    return (EngineTransport*) layer->secret;
+}
+
+/*
+ * Returns a pointer to len bytes at offset off of either a direct
+ * ByteBuffer or, if direct is NULL, a Java byte array. Arrays are pinned
+ * and must be handed back to releaseEngineRegion.
+ */
+static jbyte*
+getEngineRegion(JNIEnv *env, jobject direct, jbyteArray array, jint off,
+    jint len)
+{
+    jbyte *addr;
+    jlong capacity;
+
+    if( direct != NULL ) {
+        addr = (*env)->GetDirectBufferAddress(env, direct);
+        capacity = (*env)->GetDirectBufferCapacity(env, direct);
+        if( addr == NULL || capacity < 0 ) {
+            JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+                "Buffer is not a direct buffer");
+            return NULL;
+        }
+    } else if( array != NULL ) {
+        capacity = (*env)->GetArrayLength(env, array);
+        addr = NULL;
+    } else {
+        JSS_throw(env, NULL_POINTER_EXCEPTION);
+        return NULL;
+    }
+
+    if( off < 0 || len < 0 || ((jlong)off + len) > capacity ) {
+        JSS_throw(env, INDEX_OUT_OF_BOUNDS_EXCEPTION);
+        return NULL;
+    }
+
+    if( addr == NULL ) {
+        addr = (*env)->GetByteArrayElements(env, array, NULL);
+        if( addr == NULL ) {
+            ASSERT_OUTOFMEM(env);
+            return NULL;
+        }
+    }
+    return addr + off;
+}
+
+static void
+releaseEngineRegion(JNIEnv *env, jbyteArray array, jbyte *region, jint off,
+    jboolean modified)
+{
+    if( array != NULL && region != NULL ) {
+        (*env)->ReleaseByteArrayElements(env, array, region - off,
+            modified ? 0 : JNI_ABORT);
+    }
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_engineCreate(JNIEnv *env, jobject self,
+    jstring host, jint port, jobject certApprovalCallback,
+    jobject clientCertSelectionCallback)
+{
+    jlong sdPtr = 0;
+    JSSL_SocketData *sockdata = NULL;
+    SECStatus status;
+    PRFileDesc *newFD = NULL;
+    PRFileDesc *tmpFD = NULL;
+
+    newFD = newEngineTransport(port);
+    if( newFD == NULL ) {
+        JSS_throw(env, OUT_OF_MEMORY_ERROR);
+        goto finish;
+    }
+
+    /* enable SSL on the transport */
+    tmpFD = SSL_ImportFD(NULL, newFD);
+    if( tmpFD == NULL ) {
+        JSSL_throwSSLSocketException(env, "SSL_ImportFD() returned NULL");
+        goto finish;
+    }
+    newFD = tmpFD;
+
+    sockdata = JSSL_CreateSocketData(env, self, newFD, NULL);
+    if( sockdata == NULL ) {
+        goto finish;
+    }
+    newFD = NULL;
+
+    if( host != NULL ) {
+        const char *chars;
+        int retval;
+        chars = (*env)->GetStringUTFChars(env, host, NULL);
+        if( chars == NULL ) goto finish;
+        retval = SSL_SetURL(sockdata->fd, chars);
+        (*env)->ReleaseStringUTFChars(env, host, chars);
+        if( retval ) {
+            JSSL_throwSSLSocketException(env,
+                "Failed to set SSL domain name");
+            goto finish;
+        }
+    }
+
+    status = SSL_OptionSet(sockdata->fd, SSL_SECURITY, PR_TRUE);
+    if( status != SECSuccess ) {
+        JSSL_throwSSLSocketException(env,
+            "Unable to enable SSL security on engine");
+        goto finish;
+    }
+
+    status = SSL_HandshakeCallback(sockdata->fd, JSSL_HandshakeCallback,
+                                    sockdata);
+    if( status != SECSuccess ) {
+        JSSL_throwSSLSocketException(env,
+            "Unable to install handshake callback");
+        goto finish;
+    }
+
+    if( certApprovalCallback != NULL ) {
+        sockdata->certApprovalCallback =
+            (*env)->NewGlobalRef(env, certApprovalCallback);
+        if( sockdata->certApprovalCallback == NULL ) goto finish;
+
+        status = SSL_AuthCertificateHook(
+            sockdata->fd, JSSL_JavaCertAuthCallback,
+            (void*) sockdata->certApprovalCallback);
+    } else {
+        status = SSL_AuthCertificateHook(
+                    sockdata->fd, JSSL_DefaultCertAuthCallback, NULL);
+    }
+    if( status != SECSuccess ) {
+        JSSL_throwSSLSocketException(env,
+            "Unable to install certificate authentication callback");
+        goto finish;
+    }
+
+    if( clientCertSelectionCallback != NULL ) {
+        sockdata->clientCertSelectionCallback =
+            (*env)->NewGlobalRef(env, clientCertSelectionCallback);
+        if(sockdata->clientCertSelectionCallback == NULL)  goto finish;
+
+        status = SSL_GetClientAuthDataHook(
+            sockdata->fd, JSSL_CallCertSelectionCallback,
+            (void*) sockdata->clientCertSelectionCallback);
+        if( status != SECSuccess ) {
+            JSSL_throwSSLSocketException(env,
+                "Unable to install client certificate selection callback");
+            goto finish;
+        }
+    }
+
+    /* pass the pointer back to Java */
+    sdPtr = JSS_ptrToLong(sockdata);
+
+finish:
+    if( (*env)->ExceptionOccurred(env) != NULL ) {
+        if( sockdata != NULL ) {
+            JSSL_DestroySocketData(env, sockdata);
+        }
+        if( newFD != NULL ) {
+            PR_Close(newFD);
+        }
+        sdPtr = 0;
+    }
+    return sdPtr;
+}
+
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_resetHandshakeNative(JNIEnv *env,
+    jobject self, jboolean asServer)
+{
+    JSSL_SocketData *sock = NULL;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return;
+
+    if( SSL_ResetHandshake(sock->fd, asServer) != SECSuccess ) {
+        JSSL_throwSSLSocketException(env, "Unable to reset handshake");
+    }
+}
+
+/*
+ * Advances the handshake as far as the buffered input allows. Returns
+ * JNI_TRUE once the handshake is complete and JNI_FALSE if more records
+ * from the peer are needed.
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_forceHandshakeNative(JNIEnv *env,
+    jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return JNI_FALSE;
+
+    if( SSL_ForceHandshake(sock->fd) == SECSuccess ) {
+        return JNI_TRUE;
+    }
+    if( PR_GetError() == PR_WOULD_BLOCK_ERROR ) {
+        return JNI_FALSE;
+    }
+    if( (*env)->ExceptionOccurred(env) == NULL ) {
+        JSSL_throwSSLSocketException(env, "SSL handshake failed");
+    }
+    return JNI_FALSE;
+}
+
+/*
+ * Encrypts len bytes of application data into the outbound queue.
+ * Returns the number of bytes consumed.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_engineSend(JNIEnv *env, jobject self,
+    jobject direct, jbyteArray array, jint off, jint len)
+{
+    JSSL_SocketData *sock = NULL;
+    jbyte *buf;
+    jint nsent = 0;
+
+    buf = getEngineRegion(env, direct, array, off, len);
+    if( buf == NULL ) goto finish;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) goto finish;
+
+    nsent = PR_Send(sock->fd, buf, len, 0, PR_INTERVAL_NO_WAIT);
+    if( nsent < 0 ) {
+        if( PR_GetError() == PR_WOULD_BLOCK_ERROR ) {
+            nsent = 0;
+        } else {
+            JSSL_throwSSLSocketException(env, "Failed to encrypt data");
+        }
+    }
+
+finish:
+    releaseEngineRegion(env, array, buf, off, JNI_FALSE);
+    return nsent;
+}
+
+/*
+ * Decrypts buffered inbound records into the given region. Returns the
+ * number of bytes produced, 0 if a complete record is not yet available,
+ * or -1 once the peer has closed the connection.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_engineRecv(JNIEnv *env, jobject self,
+    jobject direct, jbyteArray array, jint off, jint len)
+{
+    JSSL_SocketData *sock = NULL;
+    jbyte *buf;
+    jint nread = 0;
+
+    buf = getEngineRegion(env, direct, array, off, len);
+    if( buf == NULL ) goto finish;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) goto finish;
+
+    nread = PR_Recv(sock->fd, buf, len, 0, PR_INTERVAL_NO_WAIT);
+    if( nread < 0 ) {
+        if( PR_GetError() == PR_WOULD_BLOCK_ERROR ) {
+            nread = 0;
+        } else {
+            JSSL_throwSSLSocketException(env, "Failed to decrypt data");
+        }
+    } else if( nread == 0 ) {
+        nread = -1;
+    }
+
+finish:
+    releaseEngineRegion(env, array, buf, off, nread > 0);
+    return nread;
+}
+
+/*
+ * Queues len bytes of TLS records received from the peer.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_feedInbound(JNIEnv *env, jobject self,
+    jobject direct, jbyteArray array, jint off, jint len)
+{
+    JSSL_SocketData *sock = NULL;
+    EngineTransport *transport;
+    jbyte *buf;
+
+    buf = getEngineRegion(env, direct, array, off, len);
+    if( buf == NULL ) goto finish;
+
+    transport = getTransport(env, self, &sock);
+    if( transport == NULL ) goto finish;
+
+    if( engineBufferAppend(&transport->inbound, buf, len) != PR_SUCCESS ) {
+        JSS_throw(env, OUT_OF_MEMORY_ERROR);
+    }
+
+finish:
+    releaseEngineRegion(env, array, buf, off, JNI_FALSE);
+}
+
+/*
+ * Moves up to len bytes of queued TLS records into the given region.
+ * Returns the number of bytes copied.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_drainOutbound(JNIEnv *env, jobject self,
+    jobject direct, jbyteArray array, jint off, jint len)
+{
+    JSSL_SocketData *sock = NULL;
+    EngineTransport *transport;
+    jbyte *buf;
+    jint copied = 0;
+
+    buf = getEngineRegion(env, direct, array, off, len);
+    if( buf == NULL ) goto finish;
+
+    transport = getTransport(env, self, &sock);
+    if( transport == NULL ) goto finish;
+
+    copied = engineBufferTake(&transport->outbound, buf, len);
+
+finish:
+    releaseEngineRegion(env, array, buf, off, copied > 0);
+    return copied;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_outboundPending(JNIEnv *env, jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    EngineTransport *transport;
+
+    transport = getTransport(env, self, &sock);
+    return (transport == NULL) ? 0 : transport->outbound.len;
+}
+
+/*
+ * Queues a close_notify alert for the peer.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_closeOutboundNative(JNIEnv *env,
+    jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return;
+
+    if( PR_Shutdown(sock->fd, PR_SHUTDOWN_SEND) != PR_SUCCESS ) {
+        JSSL_throwSSLSocketException(env, "Failed to send close_notify");
+    }
+}
+
+/*
+ * Marks the end of the inbound stream; NSS sees EOF once the queued
+ * records are consumed.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_closeInboundNative(JNIEnv *env,
+    jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    EngineTransport *transport;
+
+    transport = getTransport(env, self, &sock);
+    if( transport != NULL ) {
+        transport->inboundClosed = PR_TRUE;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_setServerCert(JNIEnv *env, jobject self,
+    jobject certObj)
+{
+    JSSL_SocketData *sock;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS) return;
+
+    JSSL_ConfigSecureServer(env, sock, certObj);
+}
+
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_setCipherPreference(JNIEnv *env,
+    jobject self, jint cipher, jboolean enable)
+{
+    JSSL_SocketData *sock = NULL;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return;
+
+    if( SSL_CipherPrefSet(sock->fd, cipher, enable) != SECSuccess ) {
+        char buf[128];
+        PR_snprintf(buf, 128, "Failed to %s cipher 0x%lx\n",
+            (enable ? "enable" : "disable"), cipher);
+        JSSL_throwSSLSocketException(env, buf);
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_getCipherPreference(JNIEnv *env,
+    jobject self, jint cipher)
+{
+    JSSL_SocketData *sock = NULL;
+    PRBool enabled = PR_FALSE;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return JNI_FALSE;
+
+    if( SSL_CipherPrefGet(sock->fd, cipher, &enabled) != SECSuccess ) {
+        char buf[128];
+        PR_snprintf(buf, 128, "Failed to get preference for cipher 0x%lx\n",
+            cipher);
+        JSSL_throwSSLSocketException(env, buf);
+    }
+    return enabled ? JNI_TRUE : JNI_FALSE;
+}
+
+/*
+ * Returns the enabled protocol versions as NSS version numbers
+ * {min, max}.
+ */
+JNIEXPORT jintArray JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_getVersionRangeNative(JNIEnv *env,
+    jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    SSLVersionRange vrange;
+    jintArray result;
+    jint values[2];
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return NULL;
+
+    if( SSL_VersionRangeGet(sock->fd, &vrange) != SECSuccess ) {
+        JSSL_throwSSLSocketException(env, "Failed to get SSL version range");
+        return NULL;
+    }
+    values[0] = vrange.min;
+    values[1] = vrange.max;
+
+    result = (*env)->NewIntArray(env, 2);
+    if( result != NULL ) {
+        (*env)->SetIntArrayRegion(env, result, 0, 2, values);
+    }
+    return result;
+}
+
+/*
+ * Returns the negotiated {protocol version, cipher suite}, or null if no
+ * handshake has completed.
+ */
+JNIEXPORT jintArray JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_getChannelInfo(JNIEnv *env, jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    SSLChannelInfo info;
+    jintArray result;
+    jint values[2];
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) return NULL;
+
+    if( SSL_GetChannelInfo(sock->fd, &info, sizeof(info)) != SECSuccess ) {
+        JSSL_throwSSLSocketException(env, "Failed to get channel info");
+        return NULL;
+    }
+    if( info.length == 0 ) {
+        return NULL;
+    }
+    values[0] = info.protocolVersion;
+    values[1] = info.cipherSuite;
+
+    result = (*env)->NewIntArray(env, 2);
+    if( result != NULL ) {
+        (*env)->SetIntArrayRegion(env, result, 0, 2, values);
+    }
+    return result;
+}
+
+/*
+ * Returns the DER encodings of the peer's certificate chain, leaf first,
+ * or null if the peer presented no certificate.
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_org_mozilla_jss_ssl_JSSEngine_getPeerCertificatesNative(JNIEnv *env,
+    jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    CERTCertList *chain = NULL;
+    CERTCertListNode *node;
+    jobjectArray result = NULL;
+    jclass byteArrayClass;
+    int count = 0;
+    int i = 0;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) goto finish;
+
+    chain = SSL_PeerCertificateChain(sock->fd);
+    if( chain == NULL ) goto finish;
+
+    for( node = CERT_LIST_HEAD(chain); !CERT_LIST_END(node, chain);
+            node = CERT_LIST_NEXT(node) ) {
+        count++;
+    }
+
+    byteArrayClass = (*env)->FindClass(env, "[B");
+    if( byteArrayClass == NULL ) goto finish;
+
+    result = (*env)->NewObjectArray(env, count, byteArrayClass, NULL);
+    if( result == NULL ) goto finish;
+
+    for( node = CERT_LIST_HEAD(chain); !CERT_LIST_END(node, chain);
+            node = CERT_LIST_NEXT(node), i++ ) {
+        jbyteArray der = JSS_SECItemToByteArray(env, &node->cert->derCert);
+        if( der == NULL ) {
+            result = NULL;
+            goto finish;
+        }
+        (*env)->SetObjectArrayElement(env, result, i, der);
+        (*env)->DeleteLocalRef(env, der);
+    }
+
+finish:
+    if( chain != NULL ) {
+        CERT_DestroyCertList(chain);
+    }
+    return result;
+}
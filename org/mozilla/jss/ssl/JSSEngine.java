@@ -0,0 +1,983 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+package org.mozilla.jss.ssl;
+
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.net.SocketException;
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
+import java.security.Principal;
+import java.security.cert.Certificate;
+import java.security.cert.CertificateException;
+import java.security.cert.CertificateFactory;
+import java.security.cert.X509Certificate;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+import javax.net.ssl.SSLEngine;
+import javax.net.ssl.SSLEngineResult;
+import javax.net.ssl.SSLEngineResult.HandshakeStatus;
+import javax.net.ssl.SSLEngineResult.Status;
+import javax.net.ssl.SSLException;
+import javax.net.ssl.SSLPeerUnverifiedException;
+import javax.net.ssl.SSLSession;
+import javax.net.ssl.SSLSessionContext;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.NotInitializedException;
+import org.mozilla.jss.crypto.ObjectNotFoundException;
+import org.mozilla.jss.crypto.TokenException;
+
+/**
+ * An <code>SSLEngine</code> backed by NSS.
+ *
+ * <p>Unlike {@link SSLSocket}, the engine performs no I/O of its own. NSS
+ * runs on top of an in-memory transport: <code>unwrap</code> hands it the
+ * TLS records received from the peer and <code>wrap</code> collects the
+ * records it wants to send, so a single thread can drive many connections
+ * from a non-blocking event loop.
+ *
+ * <p>Server engines need a certificate, configured with
+ * {@link #setServerCertNickname} or {@link #setServerCert}, and the
+ * session ID cache configured through
+ * {@link SSLServerSocket#configServerSessionIDCache}. All cryptographic
+ * work happens inside <code>wrap</code> and <code>unwrap</code>, so
+ * {@link #getDelegatedTask} always returns <code>null</code>.
+ * Renegotiation is not supported.
+ */
+public class JSSEngine extends SSLEngine {
+
+    /* largest plaintext fragment in a TLS record */
+    static final int MAX_FRAGMENT = 16384;
+
+    /* header, explicit IV, MAC or tag, and padding of a TLS record */
+    static final int MAX_RECORD_OVERHEAD = 325;
+
+    static final int RECORD_HEADER_LENGTH = 5;
+
+    private static final String[] PROTOCOL_NAMES = {
+        "SSLv3", "TLSv1", "TLSv1.1", "TLSv1.2", "TLSv1.3"
+    };
+
+    private static final SSLVersion[] PROTOCOL_VERSIONS = {
+        SSLVersion.SSL_3_0, SSLVersion.TLS_1_0, SSLVersion.TLS_1_1,
+        SSLVersion.TLS_1_2, SSLVersion.TLS_1_3
+    };
+
+    /* NSS numbers the protocol versions consecutively from SSL 3.0 */
+    private static final int NSS_SSL_3_0 = 0x0300;
+
+    private SocketBase base = new SocketBase();
+
+    // NSS socket data; the field name is looked up by the native code.
+    private SocketProxy sockProxy;
+
+    private boolean clientMode = true;
+    private boolean needClientAuth;
+    private boolean wantClientAuth;
+    private boolean enableSessionCreation = true;
+
+    private boolean handshakeStarted;
+    private boolean handshakeComplete;
+    private boolean finishedPending;
+    private boolean inboundClosed;
+    private boolean outboundClosed;
+    private boolean peerClosed;
+
+    private EngineSession session = new EngineSession();
+
+    /**
+     * Creates an engine with no peer information. Client engines created
+     * this way cannot verify the host name in the server certificate.
+     */
+    public JSSEngine() throws SocketException {
+        this(null, -1, null, null);
+    }
+
+    /**
+     * Creates an engine for a connection with the given peer. The host
+     * name is used to verify the server's certificate.
+     *
+     * @param peerHost The host name of the peer.
+     * @param peerPort The port of the peer.
+     */
+    public JSSEngine(String peerHost, int peerPort) throws SocketException {
+        this(peerHost, peerPort, null, null);
+    }
+
+    /**
+     * Creates an engine for a connection with the given peer. Installs
+     * the given callbacks for certificate approval and client certificate
+     * selection.
+     *
+     * @param peerHost The host name of the peer.
+     * @param peerPort The port of the peer.
+     * @param certApprovalCallback A callback that can be used to override
+     *      approval of the peer's certificate.
+     * @param clientCertSelectionCallback A callback to select the client
+     *      certificate to present to the peer.
+     */
+    public JSSEngine(String peerHost, int peerPort,
+        SSLCertificateApprovalCallback certApprovalCallback,
+        SSLClientCertificateSelectionCallback clientCertSelectionCallback)
+            throws SocketException
+    {
+        super(peerHost, peerPort);
+        sockProxy = new SocketProxy(engineCreate(peerHost,
+                peerPort < 0 ? 0 : peerPort,
+                certApprovalCallback, clientCertSelectionCallback));
+        base.setProxy(sockProxy);
+    }
+
+    /**
+     * Sets the certificate to use for server authentication.
+     */
+    public void setServerCertNickname(String nick) throws SocketException {
+        try {
+            setServerCert(CryptoManager.getInstance().findCertByNickname(nick));
+        } catch (NotInitializedException nie) {
+            throw new SocketException("CryptoManager not initialized");
+        } catch (ObjectNotFoundException onfe) {
+            throw new SocketException("Object not found: " + onfe);
+        } catch (TokenException te) {
+            throw new SocketException("Token Exception: " + te);
+        }
+    }
+
+    /**
+     * Sets the certificate to use for server authentication.
+     */
+    public native void setServerCert(
+        org.mozilla.jss.crypto.X509Certificate cert)
+        throws SocketException;
+
+    /**
+     * Sets the nickname of the certificate to use for client authentication.
+     */
+    public void setClientCertNickname(String nick) throws SocketException {
+        base.setClientCertNickname(nick);
+    }
+
+    /**
+     * Sets the certificate to use for client authentication.
+     */
+    public void setClientCert(org.mozilla.jss.crypto.X509Certificate cert)
+        throws SocketException
+    {
+        base.setClientCert(cert);
+    }
+
+    @Override
+    public synchronized void beginHandshake() throws SSLException {
+        if (handshakeStarted) {
+            if (handshakeComplete) {
+                throw new SSLException("Renegotiation is not supported");
+            }
+            return;
+        }
+        if (sockProxy == null || inboundClosed || outboundClosed) {
+            throw new SSLException("Engine is closed");
+        }
+        try {
+            resetHandshakeNative(!clientMode);
+            handshakeStarted = true;
+            driveHandshake();
+        } catch (IOException e) {
+            throw toSSLException(e);
+        }
+    }
+
+    @Override
+    public synchronized SSLEngineResult wrap(ByteBuffer[] srcs, int offset,
+        int length, ByteBuffer dst) throws SSLException
+    {
+        checkBuffers(srcs, offset, length);
+        if (dst == null) {
+            throw new IllegalArgumentException("dst is null");
+        }
+        if (dst.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+
+        int consumed = 0;
+        int produced = 0;
+        Status status = Status.OK;
+
+        try {
+            if (!handshakeStarted && !outboundClosed) {
+                beginHandshake();
+            }
+            if (sockProxy != null) {
+                if (handshakeStarted && !handshakeComplete) {
+                    driveHandshake();
+                }
+
+                // records already queued by NSS go out first
+                produced = drain(dst);
+
+                if (handshakeComplete && !outboundClosed
+                        && outboundPending() == 0) {
+                    consumed = encrypt(srcs, offset, length, dst.remaining());
+                    produced += drain(dst);
+                    if (consumed == 0 && produced == 0
+                            && remaining(srcs, offset, length) > 0) {
+                        status = Status.BUFFER_OVERFLOW;
+                    }
+                } else if (produced == 0 && outboundPending() > 0) {
+                    status = Status.BUFFER_OVERFLOW;
+                }
+            }
+        } catch (IOException e) {
+            throw toSSLException(e);
+        }
+
+        if (isOutboundDone()) {
+            status = Status.CLOSED;
+            releaseIfDone();
+        }
+        return result(status, consumed, produced);
+    }
+
+    @Override
+    public synchronized SSLEngineResult unwrap(ByteBuffer src,
+        ByteBuffer[] dsts, int offset, int length) throws SSLException
+    {
+        if (src == null) {
+            throw new IllegalArgumentException("src is null");
+        }
+        checkBuffers(dsts, offset, length);
+        for (int i = offset; i < offset + length; i++) {
+            if (dsts[i].isReadOnly()) {
+                throw new ReadOnlyBufferException();
+            }
+        }
+
+        int consumed = 0;
+        int produced = 0;
+        Status status = Status.OK;
+
+        try {
+            if (!handshakeStarted && !inboundClosed) {
+                beginHandshake();
+            }
+            if (sockProxy == null || inboundClosed) {
+                return result(Status.CLOSED, 0, 0);
+            }
+
+            if (!handshakeComplete) {
+                // Feed one record at a time so that application data
+                // following the peer's last handshake message is left
+                // in src for the next call.
+                while (!handshakeComplete && outboundPending() == 0) {
+                    int record = recordLength(src);
+                    if (record < 0) {
+                        if (consumed == 0) {
+                            status = Status.BUFFER_UNDERFLOW;
+                        }
+                        break;
+                    }
+                    feed(src, record);
+                    consumed += record;
+                    driveHandshake();
+                }
+                return result(status, consumed, 0);
+            }
+
+            int room = remaining(dsts, offset, length);
+            while (true) {
+                int record = recordLength(src);
+                if (record < 0) {
+                    if (consumed == 0) {
+                        status = Status.BUFFER_UNDERFLOW;
+                    }
+                    break;
+                }
+                int maxPlaintext = Math.min(record - RECORD_HEADER_LENGTH,
+                        MAX_FRAGMENT);
+                if (room < maxPlaintext) {
+                    if (consumed == 0) {
+                        status = Status.BUFFER_OVERFLOW;
+                    }
+                    break;
+                }
+
+                feed(src, record);
+                consumed += record;
+
+                int n = recv(dsts, offset, length);
+                if (n < 0) {
+                    peerClosed = true;
+                    inboundClosed = true;
+                    closeOutbound();
+                    status = Status.CLOSED;
+                    break;
+                }
+                produced += n;
+                room -= n;
+
+                if (outboundPending() > 0) {
+                    // NSS has something to tell the peer, e.g. an alert
+                    break;
+                }
+            }
+        } catch (IOException e) {
+            throw toSSLException(e);
+        }
+        return result(status, consumed, produced);
+    }
+
+    @Override
+    public Runnable getDelegatedTask() {
+        return null;
+    }
+
+    @Override
+    public synchronized void closeInbound() throws SSLException {
+        if (inboundClosed) {
+            return;
+        }
+        inboundClosed = true;
+        if (sockProxy != null) {
+            try {
+                closeInboundNative();
+            } catch (SocketException e) {
+                // the engine is being torn down anyway
+            }
+        }
+        releaseIfDone();
+        if (handshakeStarted && !peerClosed) {
+            throw new SSLException(
+                "Inbound closed before receiving close_notify from the peer");
+        }
+    }
+
+    @Override
+    public synchronized boolean isInboundDone() {
+        return inboundClosed;
+    }
+
+    @Override
+    public synchronized void closeOutbound() {
+        if (outboundClosed) {
+            return;
+        }
+        outboundClosed = true;
+        if (sockProxy != null && handshakeStarted) {
+            try {
+                closeOutboundNative();
+            } catch (SocketException e) {
+                // nothing more can be sent to the peer
+            }
+        }
+        releaseIfDone();
+    }
+
+    @Override
+    public synchronized boolean isOutboundDone() {
+        return outboundClosed && pendingOutbound() == 0;
+    }
+
+    @Override
+    public String[] getSupportedCipherSuites() {
+        List<String> names = new ArrayList<>();
+        for (int id : SSLSocket.getImplementedCipherSuites()) {
+            SSLCipher cipher = SSLCipher.valueOf(id);
+            if (cipher != null) {
+                names.add(cipher.name());
+            }
+        }
+        return names.toArray(new String[names.size()]);
+    }
+
+    @Override
+    public synchronized String[] getEnabledCipherSuites() {
+        List<String> names = new ArrayList<>();
+        for (int id : SSLSocket.getImplementedCipherSuites()) {
+            SSLCipher cipher = SSLCipher.valueOf(id);
+            try {
+                if (cipher != null && getCipherPreference(id)) {
+                    names.add(cipher.name());
+                }
+            } catch (SocketException e) {
+                throw new IllegalStateException(e.getMessage(), e);
+            }
+        }
+        return names.toArray(new String[names.size()]);
+    }
+
+    @Override
+    public synchronized void setEnabledCipherSuites(String[] suites) {
+        if (suites == null) {
+            throw new IllegalArgumentException("suites is null");
+        }
+        Set<Integer> enabled = new HashSet<>();
+        for (String suite : suites) {
+            enabled.add(SSLCipher.valueOf(suite).getID());
+        }
+        try {
+            for (int id : SSLSocket.getImplementedCipherSuites()) {
+                setCipherPreference(id, enabled.contains(id));
+            }
+        } catch (SocketException e) {
+            throw new IllegalArgumentException(e.getMessage(), e);
+        }
+    }
+
+    @Override
+    public String[] getSupportedProtocols() {
+        return PROTOCOL_NAMES.clone();
+    }
+
+    @Override
+    public synchronized String[] getEnabledProtocols() {
+        int[] range;
+        try {
+            range = getVersionRangeNative();
+        } catch (SocketException e) {
+            throw new IllegalStateException(e.getMessage(), e);
+        }
+        List<String> names = new ArrayList<>();
+        for (int i = 0; i < PROTOCOL_NAMES.length; i++) {
+            int version = NSS_SSL_3_0 + i;
+            if (version >= range[0] && version <= range[1]) {
+                names.add(PROTOCOL_NAMES[i]);
+            }
+        }
+        return names.toArray(new String[names.size()]);
+    }
+
+    /**
+     * Enables the given protocols. NSS only supports a contiguous range of
+     * versions, so every version between the oldest and the newest listed
+     * protocol ends up enabled.
+     */
+    @Override
+    public synchronized void setEnabledProtocols(String[] protocols) {
+        if (protocols == null || protocols.length == 0) {
+            throw new IllegalArgumentException("No protocols given");
+        }
+        int min = PROTOCOL_NAMES.length;
+        int max = -1;
+        for (String protocol : protocols) {
+            int index = protocolIndex(protocol);
+            min = Math.min(min, index);
+            max = Math.max(max, index);
+        }
+        try {
+            base.setSSLVersionRange(PROTOCOL_VERSIONS[min].value(),
+                    PROTOCOL_VERSIONS[max].value());
+        } catch (SocketException e) {
+            throw new IllegalArgumentException(e.getMessage(), e);
+        }
+    }
+
+    @Override
+    public SSLSession getSession() {
+        return session;
+    }
+
+    @Override
+    public synchronized HandshakeStatus getHandshakeStatus() {
+        if (sockProxy == null) {
+            return HandshakeStatus.NOT_HANDSHAKING;
+        }
+        if (pendingOutbound() > 0) {
+            return HandshakeStatus.NEED_WRAP;
+        }
+        if (handshakeStarted && !handshakeComplete
+                && !inboundClosed && !outboundClosed) {
+            return HandshakeStatus.NEED_UNWRAP;
+        }
+        return HandshakeStatus.NOT_HANDSHAKING;
+    }
+
+    @Override
+    public synchronized void setUseClientMode(boolean mode) {
+        if (handshakeStarted) {
+            throw new IllegalArgumentException(
+                "Mode cannot be changed after the handshake has begun");
+        }
+        clientMode = mode;
+    }
+
+    @Override
+    public synchronized boolean getUseClientMode() {
+        return clientMode;
+    }
+
+    @Override
+    public synchronized void setNeedClientAuth(boolean need) {
+        needClientAuth = need;
+        wantClientAuth = false;
+        configureClientAuth(need, need);
+    }
+
+    @Override
+    public synchronized boolean getNeedClientAuth() {
+        return needClientAuth;
+    }
+
+    @Override
+    public synchronized void setWantClientAuth(boolean want) {
+        wantClientAuth = want;
+        needClientAuth = false;
+        configureClientAuth(want, false);
+    }
+
+    @Override
+    public synchronized boolean getWantClientAuth() {
+        return wantClientAuth;
+    }
+
+    @Override
+    public synchronized void setEnableSessionCreation(boolean flag) {
+        enableSessionCreation = flag;
+        try {
+            base.useCache(flag);
+        } catch (SocketException e) {
+            throw new IllegalStateException(e.getMessage(), e);
+        }
+    }
+
+    @Override
+    public synchronized boolean getEnableSessionCreation() {
+        return enableSessionCreation;
+    }
+
+    /**
+     * @deprecated finalize() in Object has been deprecated
+     */
+    @Deprecated
+    protected void finalize() throws Throwable {
+        release(); /* in case the engine was never closed */
+    }
+
+    /**
+     * Called by the native handshake callback.
+     */
+    private void notifyAllHandshakeListeners() {
+        handshakeComplete = true;
+        finishedPending = true;
+    }
+
+    private void driveHandshake() throws IOException {
+        if (!handshakeComplete && forceHandshakeNative()) {
+            handshakeComplete = true;
+            finishedPending = true;
+        }
+        if (handshakeComplete && !session.established) {
+            session.establish();
+        }
+    }
+
+    private SSLEngineResult result(Status status, int consumed, int produced) {
+        HandshakeStatus hs = getHandshakeStatus();
+        if (hs == HandshakeStatus.NOT_HANDSHAKING && finishedPending) {
+            finishedPending = false;
+            hs = HandshakeStatus.FINISHED;
+        }
+        return new SSLEngineResult(status, hs, consumed, produced);
+    }
+
+    /**
+     * Encrypts application data from srcs into whole records, stopping
+     * before the records would no longer fit in room bytes.
+     */
+    private int encrypt(ByteBuffer[] srcs, int offset, int length, int room)
+        throws IOException
+    {
+        int consumed = 0;
+        for (int i = offset; i < offset + length; i++) {
+            ByteBuffer src = srcs[i];
+            while (src.hasRemaining()) {
+                int n = Math.min(Math.min(src.remaining(), MAX_FRAGMENT),
+                        room - MAX_RECORD_OVERHEAD);
+                if (n <= 0) {
+                    return consumed;
+                }
+                int sent = send(src, n);
+                if (sent <= 0) {
+                    return consumed;
+                }
+                consumed += sent;
+                room -= sent + MAX_RECORD_OVERHEAD;
+            }
+        }
+        return consumed;
+    }
+
+    /**
+     * Decrypts the queued records into dsts. Returns the number of bytes
+     * produced, or -1 if the peer closed the connection.
+     */
+    private int recv(ByteBuffer[] dsts, int offset, int length)
+        throws IOException
+    {
+        int produced = 0;
+        for (int i = offset; i < offset + length; i++) {
+            ByteBuffer dst = dsts[i];
+            while (dst.hasRemaining()) {
+                int n;
+                int pos = dst.position();
+                if (dst.isDirect()) {
+                    n = engineRecv(dst, null, pos, dst.remaining());
+                } else {
+                    n = engineRecv(null, dst.array(), dst.arrayOffset() + pos,
+                            dst.remaining());
+                }
+                if (n < 0) {
+                    return (produced > 0) ? produced : -1;
+                }
+                if (n == 0) {
+                    return produced;
+                }
+                dst.position(pos + n);
+                produced += n;
+            }
+        }
+        return produced;
+    }
+
+    private int send(ByteBuffer src, int len) throws IOException {
+        int n;
+        int pos = src.position();
+        if (src.isDirect()) {
+            n = engineSend(src, null, pos, len);
+        } else if (src.hasArray()) {
+            n = engineSend(null, src.array(), src.arrayOffset() + pos, len);
+        } else {
+            byte[] copy = new byte[len];
+            src.duplicate().get(copy);
+            n = engineSend(null, copy, 0, len);
+        }
+        src.position(pos + n);
+        return n;
+    }
+
+    private void feed(ByteBuffer src, int len) throws IOException {
+        int pos = src.position();
+        if (src.isDirect()) {
+            feedInbound(src, null, pos, len);
+        } else if (src.hasArray()) {
+            feedInbound(null, src.array(), src.arrayOffset() + pos, len);
+        } else {
+            byte[] copy = new byte[len];
+            src.duplicate().get(copy);
+            feedInbound(null, copy, 0, len);
+        }
+        src.position(pos + len);
+    }
+
+    private int drain(ByteBuffer dst) throws IOException {
+        int len = Math.min(dst.remaining(), outboundPending());
+        if (len == 0) {
+            return 0;
+        }
+        int n;
+        int pos = dst.position();
+        if (dst.isDirect()) {
+            n = drainOutbound(dst, null, pos, len);
+        } else {
+            n = drainOutbound(null, dst.array(), dst.arrayOffset() + pos, len);
+        }
+        dst.position(pos + n);
+        return n;
+    }
+
+    /**
+     * Returns the length of the complete TLS record at the start of src,
+     * or -1 if src does not yet hold a whole record.
+     */
+    private static int recordLength(ByteBuffer src) {
+        if (src.remaining() < RECORD_HEADER_LENGTH) {
+            return -1;
+        }
+        int pos = src.position();
+        int length = RECORD_HEADER_LENGTH
+                + (((src.get(pos + 3) & 0xff) << 8) | (src.get(pos + 4) & 0xff));
+        return (src.remaining() < length) ? -1 : length;
+    }
+
+    private static int remaining(ByteBuffer[] bufs, int offset, int length) {
+        int total = 0;
+        for (int i = offset; i < offset + length; i++) {
+            total += bufs[i].remaining();
+        }
+        return total;
+    }
+
+    private static void checkBuffers(ByteBuffer[] bufs, int offset,
+        int length)
+    {
+        if (bufs == null) {
+            throw new IllegalArgumentException("Buffer array is null");
+        }
+        if (offset < 0 || length < 0 || offset > bufs.length - length) {
+            throw new IndexOutOfBoundsException();
+        }
+        for (int i = offset; i < offset + length; i++) {
+            if (bufs[i] == null) {
+                throw new IllegalArgumentException("Buffer " + i + " is null");
+            }
+        }
+    }
+
+    private static int protocolIndex(String protocol) {
+        for (int i = 0; i < PROTOCOL_NAMES.length; i++) {
+            if (PROTOCOL_NAMES[i].equals(protocol)) {
+                return i;
+            }
+        }
+        throw new IllegalArgumentException("Unsupported protocol: " + protocol);
+    }
+
+    private void configureClientAuth(boolean request, boolean require) {
+        try {
+            base.setSSLOptionMode(SocketBase.SSL_REQUIRE_CERTIFICATE,
+                    require ? SocketBase.SSL_REQUIRE_ALWAYS
+                            : SocketBase.SSL_REQUIRE_NEVER);
+            base.requestClientAuth(request);
+        } catch (SocketException e) {
+            throw new IllegalStateException(e.getMessage(), e);
+        }
+    }
+
+    private int pendingOutbound() {
+        if (sockProxy == null) {
+            return 0;
+        }
+        try {
+            return outboundPending();
+        } catch (SocketException e) {
+            return 0;
+        }
+    }
+
+    private static SSLException toSSLException(IOException e) {
+        if (e instanceof SSLException) {
+            return (SSLException) e;
+        }
+        return new SSLException(e.getMessage(), e);
+    }
+
+    /**
+     * Frees the NSS socket once both directions are closed and every
+     * queued record has been handed to the caller.
+     */
+    private void releaseIfDone() {
+        if (inboundClosed && outboundClosed && pendingOutbound() == 0) {
+            release();
+        }
+    }
+
+    private synchronized void release() {
+        if (sockProxy == null) {
+            return;
+        }
+        try {
+            base.close();
+        } catch (IOException e) {
+            // nothing useful can be done about it here
+        }
+        sockProxy = null;
+        base.setProxy(null);
+    }
+
+    private native long engineCreate(String host, int port,
+        SSLCertificateApprovalCallback certApprovalCallback,
+        SSLClientCertificateSelectionCallback clientCertSelectionCallback)
+        throws SocketException;
+
+    private native void resetHandshakeNative(boolean asServer)
+        throws SocketException;
+
+    private native boolean forceHandshakeNative() throws SocketException;
+
+    private native int engineSend(ByteBuffer direct, byte[] array, int off,
+        int len) throws SocketException;
+
+    private native int engineRecv(ByteBuffer direct, byte[] array, int off,
+        int len) throws SocketException;
+
+    private native void feedInbound(ByteBuffer direct, byte[] array, int off,
+        int len) throws SocketException;
+
+    private native int drainOutbound(ByteBuffer direct, byte[] array, int off,
+        int len) throws SocketException;
+
+    private native int outboundPending() throws SocketException;
+
+    private native void closeOutboundNative() throws SocketException;
+
+    private native void closeInboundNative() throws SocketException;
+
+    private native void setCipherPreference(int cipher, boolean enable)
+        throws SocketException;
+
+    private native boolean getCipherPreference(int cipher)
+        throws SocketException;
+
+    private native int[] getVersionRangeNative() throws SocketException;
+
+    private native int[] getChannelInfo() throws SocketException;
+
+    private native byte[][] getPeerCertificatesNative() throws SocketException;
+
+    /**
+     * The session negotiated by the engine. Its contents are captured when
+     * the handshake completes so that they remain available after the
+     * engine has been closed.
+     */
+    private class EngineSession implements SSLSession {
+
+        private final long creationTime = System.currentTimeMillis();
+        private final Map<String, Object> values = new HashMap<>();
+        private boolean established;
+        private boolean valid = true;
+        private String protocol = "NONE";
+        private String cipherSuite = "SSL_NULL_WITH_NULL_NULL";
+        private Certificate[] peerCertificates;
+
+        void establish() throws SocketException {
+            established = true;
+
+            int[] info = getChannelInfo();
+            if (info != null) {
+                int index = info[0] - NSS_SSL_3_0;
+                if (index >= 0 && index < PROTOCOL_NAMES.length) {
+                    protocol = PROTOCOL_NAMES[index];
+                }
+                SSLCipher cipher = SSLCipher.valueOf(info[1]);
+                if (cipher != null) {
+                    cipherSuite = cipher.name();
+                }
+            }
+
+            byte[][] chain = getPeerCertificatesNative();
+            if (chain != null) {
+                try {
+                    CertificateFactory cf = CertificateFactory.getInstance("X.509");
+                    Certificate[] certs = new Certificate[chain.length];
+                    for (int i = 0; i < chain.length; i++) {
+                        certs[i] = cf.generateCertificate(
+                                new ByteArrayInputStream(chain[i]));
+                    }
+                    peerCertificates = certs;
+                } catch (CertificateException e) {
+                    throw new SocketException(
+                        "Unable to decode peer certificate: " + e.getMessage());
+                }
+            }
+        }
+
+        public byte[] getId() {
+            return new byte[0];
+        }
+
+        public SSLSessionContext getSessionContext() {
+            return null;
+        }
+
+        public long getCreationTime() {
+            return creationTime;
+        }
+
+        public long getLastAccessedTime() {
+            return creationTime;
+        }
+
+        public void invalidate() {
+            valid = false;
+        }
+
+        public boolean isValid() {
+            return valid && established;
+        }
+
+        public synchronized void putValue(String name, Object value) {
+            values.put(name, value);
+        }
+
+        public synchronized Object getValue(String name) {
+            return values.get(name);
+        }
+
+        public synchronized void removeValue(String name) {
+            values.remove(name);
+        }
+
+        public synchronized String[] getValueNames() {
+            return values.keySet().toArray(new String[values.size()]);
+        }
+
+        public Certificate[] getPeerCertificates()
+            throws SSLPeerUnverifiedException
+        {
+            if (peerCertificates == null) {
+                throw new SSLPeerUnverifiedException("Peer not authenticated");
+            }
+            return peerCertificates.clone();
+        }
+
+        public Certificate[] getLocalCertificates() {
+            return null;
+        }
+
+        public javax.security.cert.X509Certificate[] getPeerCertificateChain()
+            throws SSLPeerUnverifiedException
+        {
+            Certificate[] certs = getPeerCertificates();
+            javax.security.cert.X509Certificate[] chain =
+                new javax.security.cert.X509Certificate[certs.length];
+            try {
+                for (int i = 0; i < certs.length; i++) {
+                    chain[i] = javax.security.cert.X509Certificate.getInstance(
+                            certs[i].getEncoded());
+                }
+            } catch (Exception e) {
+                throw new SSLPeerUnverifiedException(e.getMessage());
+            }
+            return chain;
+        }
+
+        public Principal getPeerPrincipal() throws SSLPeerUnverifiedException {
+            return ((X509Certificate) getPeerCertificates()[0])
+                    .getSubjectX500Principal();
+        }
+
+        public Principal getLocalPrincipal() {
+            return null;
+        }
+
+        public String getCipherSuite() {
+            return cipherSuite;
+        }
+
+        public String getProtocol() {
+            return protocol;
+        }
+
+        public String getPeerHost() {
+            return JSSEngine.this.getPeerHost();
+        }
+
+        public int getPeerPort() {
+            return JSSEngine.this.getPeerPort();
+        }
+
+        public int getPacketBufferSize() {
+            return MAX_FRAGMENT + MAX_RECORD_OVERHEAD;
+        }
+
+        public int getApplicationBufferSize() {
+            return MAX_FRAGMENT;
+        }
+    }
+}
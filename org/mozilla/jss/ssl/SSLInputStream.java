@@ -5,6 +5,7 @@
 package org.mozilla.jss.ssl;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
 
 class SSLInputStream extends java.io.InputStream {
 
@@ -38,6 +39,14 @@ class SSLInputStream extends java.io.InputStream {
         return sock.read(b, off, len);
     }
 
+    /**
+     * Reads into a ByteBuffer. Direct buffers are filled without an
+     * intermediate copy through the Java heap.
+     */
+    public int read(ByteBuffer dst) throws IOException {
+        return sock.read(dst);
+    }
+
     public long skip(long n) throws IOException {
         long numSkipped = 0;
 
@@ -5,6 +5,7 @@
 package org.mozilla.jss.ssl;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
 
 class SSLOutputStream extends java.io.OutputStream {
 
@@ -24,6 +25,14 @@ class SSLOutputStream extends java.io.OutputStream {
         sock.write(b, off, len);
     }       
 
+    /**
+     * Writes the remaining bytes of a ByteBuffer. Direct buffers are sent
+     * without an intermediate copy through the Java heap.
+     */
+    public void write(ByteBuffer src) throws IOException {
+        sock.write(src);
+    }
+
     public void close() throws IOException {
         sock.close();
     }
@@ -37,7 +37,7 @@ finish:
     return;
 }
 
-JNIEXPORT jbyteArray JNICALL
+JNIEXPORT jlong JNICALL
 Java_org_mozilla_jss_ssl_SSLServerSocket_socketAccept
     (JNIEnv *env, jobject self, jobject newSock, jint timeout,
         jboolean handshakeAsClient)
@@ -47,7 +47,7 @@ Java_org_mozilla_jss_ssl_SSLServerSocket_socketAccept
     PRFileDesc *newFD=NULL;
     PRIntervalTime ivtimeout;
     JSSL_SocketData *newSD=NULL;
-    jbyteArray sdArray = NULL;
+    jlong sdPtr = 0;
     SECStatus status;
     PRThread *me;
 
@@ -122,11 +122,7 @@ Java_org_mozilla_jss_ssl_SSLServerSocket_socketAccept
     }
 
     /* pass the pointer back to Java */
-    sdArray = JSS_ptrToByteArray(env, (void*) newSD);
-    if( sdArray == NULL ) {
-        /* exception was thrown */
-        goto finish;
-    }
+    sdPtr = JSS_ptrToLong(newSD);
 
 finish:
     if( (*env)->ExceptionOccurred(env) != NULL ) {
@@ -136,8 +132,9 @@ finish:
         if( newFD != NULL ) {
             PR_Close(newFD);
         }
+        sdPtr = 0;
     }
-    return sdArray;
+    return sdPtr;
 }
 
 JNIEXPORT void JNICALL
@@ -217,46 +214,10 @@ Java_org_mozilla_jss_ssl_SSLServerSocket_setServerCert(
     JNIEnv *env, jobject self, jobject certObj)
 {
     JSSL_SocketData *sock;
-    CERTCertificate* cert=NULL;
-    PK11SlotInfo* slot=NULL;
-    SECKEYPrivateKey* privKey=NULL;
-    SSLKEAType certKEA;
-    SECStatus status;
-
-    if( certObj == NULL ) {
-        JSS_throw(env, NULL_POINTER_EXCEPTION);
-        goto finish;
-    }
-
-    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS) goto finish;
-
-    if( JSS_PK11_getCertPtr(env, certObj, &cert) != PR_SUCCESS ) {
-        goto finish;
-    }
-    PR_ASSERT(cert!=NULL); /* shouldn't happen */
-    if( JSS_PK11_getCertSlotPtr(env, certObj, &slot) != PR_SUCCESS ) {
-        goto finish;
-    }
-    PR_ASSERT(slot!=NULL); /* shouldn't happen */
 
-    privKey = PK11_FindPrivateKeyFromCert(slot, cert, NULL);
-    if (privKey != NULL) {
-        certKEA = NSS_FindCertKEAType(cert);
-        status = SSL_ConfigSecureServer(sock->fd, cert, privKey, certKEA); 
-        if( status != SECSuccess) {
-            JSSL_throwSSLSocketException(env,
-                "Failed to configure secure server certificate and key");
-            goto finish;
-        }
-    } else {
-        JSSL_throwSSLSocketException(env, "Failed to locate private key");
-        goto finish;
-    }
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS) return;
 
-finish:
-    if(privKey!=NULL) {
-        SECKEY_DestroyPrivateKey(privKey);
-    }
+    JSSL_ConfigSecureServer(env, sock, certObj);
 }
 
 JNIEXPORT void JNICALL
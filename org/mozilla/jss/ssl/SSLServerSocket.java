@@ -9,6 +9,7 @@ import java.io.IOException;
 import java.net.Socket;
 import java.net.SocketException;
 import java.net.SocketTimeoutException;
+import java.util.concurrent.Executor;
 import org.mozilla.jss.CryptoManager;
 import org.mozilla.jss.NotInitializedException;
 import org.mozilla.jss.crypto.ObjectNotFoundException;
@@ -162,7 +163,7 @@ public class SSLServerSocket extends java.net.ServerSocket {
                  * So first get a socket pointer, and if successful
                  * create the SocketProxy.
                  */
-                byte[] socketPointer = null;
+                long socketPointer;
                 socketPointer = socketAccept(s, base.getTimeout(),
                     handshakeAsClient);
                 SocketProxy sp = new SocketProxy(socketPointer);
@@ -172,10 +173,42 @@ public class SSLServerSocket extends java.net.ServerSocket {
                     inAccept=false;
                 }
             }
+            Executor executor = handshakeExecutor;
+            if (executor != null) {
+                s.startHandshakeAsync(executor);
+            }
             return s;
         }
     }
 
+    /**
+     * Sets an executor on which the handshakes of accepted sockets are
+     * driven. When one is set, <code>accept</code> starts each socket's
+     * handshake on it and returns at once, so the accept loop never waits
+     * on private key operations; the socket's
+     * <code>getHandshakeFuture</code> reports the outcome. The executor
+     * should be bounded (for example a fixed-size thread pool) so that a
+     * burst of new connections cannot exhaust the process. A handshake
+     * the executor rejects fails its future rather than blocking accept.
+     *
+     * @param executor The handshake executor, or <code>null</code> to
+     *      leave handshakes to the first read, write or
+     *      <code>forceHandshake</code> (the default).
+     */
+    public void setHandshakeExecutor(Executor executor) {
+        handshakeExecutor = executor;
+    }
+
+    /**
+     * Returns the executor set with <code>setHandshakeExecutor</code>,
+     * or <code>null</code>.
+     */
+    public Executor getHandshakeExecutor() {
+        return handshakeExecutor;
+    }
+
+    private volatile Executor handshakeExecutor;
+
     /**
      * Sets the SO_TIMEOUT socket option.
      * @param timeout The timeout time in milliseconds.
@@ -195,7 +228,7 @@ public class SSLServerSocket extends java.net.ServerSocket {
     public native void setReuseAddress(boolean reuse) throws SocketException;
     public native boolean getReuseAddress() throws SocketException;
     private native void abortAccept() throws SocketException;
-    private native byte[] socketAccept(SSLSocket s, int timeout,
+    private native long socketAccept(SSLSocket s, int timeout,
         boolean handshakeAsClient)
         throws SocketException, SocketTimeoutException;
 
@@ -928,49 +928,36 @@ finish:
     return enabled;
 }
 
-JNIEXPORT jint JNICALL 
-Java_org_mozilla_jss_ssl_SSLSocket_socketRead(JNIEnv *env, jobject self, 
-    jbyteArray bufBA, jint off, jint len, jint timeout)
+/*
+ * Receives up to len bytes from the socket into buf. The calling thread is
+ * registered as the socket's reader for the duration of the call so that
+ * abortReadWrite can interrupt it. Returns the number of bytes read, or -1
+ * on EOF or error; in the error case an exception has been thrown.
+ */
+static jint
+recvFromSocket(JNIEnv *env, JSSL_SocketData *sock, void *buf, jint len,
+    jint timeout)
 {
-    JSSL_SocketData *sock = NULL;
-    jbyte *buf = NULL;
-    jint size;
     PRIntervalTime ivtimeout;
     PRThread *me;
-    jint nread = -1;
-    
-    size = (*env)->GetArrayLength(env, bufBA);
-    if( off < 0 || len < 0 || (off+len) > size) {
-        JSS_throw(env, INDEX_OUT_OF_BOUNDS_EXCEPTION);
-        goto finish;
-    }
-
-    buf = (*env)->GetByteArrayElements(env, bufBA, NULL);
-    if( buf == NULL ) {
-        goto finish;
-    }
+    jint nread;
 
     ivtimeout = (timeout > 0) ? PR_MillisecondsToInterval(timeout)
                               : PR_INTERVAL_NO_TIMEOUT;
 
-    /* get the socket */
-    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
-        goto finish;
-    }
-
     /* set the current thread doing the read */
     me = PR_GetCurrentThread();
     PR_Lock(sock->lock);
     if ( sock->closePending ) {
        PR_Unlock(sock->lock);
        JSSL_throwSSLSocketException(env, "Read operation interrupted");
-       goto finish;
+       return -1;
     }
     PR_ASSERT(sock->reader == NULL);
     sock->reader = me;
     PR_Unlock(sock->lock);
 
-    nread = PR_Recv(sock->fd, buf+off, len, 0 /*flags*/, ivtimeout);
+    nread = PR_Recv(sock->fd, buf, len, 0 /*flags*/, ivtimeout);
 
     PR_Lock(sock->lock);
     PR_ASSERT(sock->reader == me);
@@ -1000,21 +987,345 @@ Java_org_mozilla_jss_ssl_SSLSocket_socketRead(JNIEnv *env, jobject self,
         } else {
             JSSL_throwSSLSocketException(env, "Error reading from socket");
         }
-        goto finish;
+        return -1;
     }
 
     if( nread == 0 ) {
         /* EOF in Java is -1 */
         nread = -1;
     }
+    return nread;
+}
+
+/*
+ * Sends the iov_size buffers described by iov over the socket. A single
+ * buffer goes through PR_Send; several go through PR_Writev, which lets
+ * the SSL layer coalesce them into full-sized records. The calling thread
+ * is registered as the socket's writer for the duration of the call so
+ * that abortReadWrite can interrupt it. Returns PR_FAILURE if an exception
+ * was thrown.
+ */
+static PRStatus
+sendToSocket(JNIEnv *env, JSSL_SocketData *sock, const PRIOVec *iov,
+    PRInt32 iov_size, jint timeout)
+{
+    PRIntervalTime ivtimeout;
+    PRThread *me;
+    PRInt32 numwrit;
+    PRInt32 len = 0;
+    int i;
+
+    PR_ASSERT(iov_size > 0 && iov_size <= PR_MAX_IOVECTOR_SIZE);
+    for( i = 0; i < iov_size; ++i ) {
+        if( iov[i].iov_len > PR_INT32_MAX - len ) {
+            JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+                "Total length of buffers exceeds 2^31-1 bytes");
+            return PR_FAILURE;
+        }
+        len += iov[i].iov_len;
+    }
+
+    ivtimeout = (timeout > 0) ? PR_MillisecondsToInterval(timeout)
+                              : PR_INTERVAL_NO_TIMEOUT;
+
+    /* set the current thread doing the write */
+    me = PR_GetCurrentThread();
+    PR_Lock(sock->lock);
+    if ( sock->closePending ) {
+       PR_Unlock(sock->lock);
+       JSSL_throwSSLSocketException(env, "Write operation interrupted");
+       return PR_FAILURE;
+    }
+    PR_ASSERT(sock->writer == NULL);
+    sock->writer = me;
+    PR_Unlock(sock->lock);
+
+    if( iov_size == 1 ) {
+        numwrit = PR_Send(sock->fd, iov[0].iov_base, iov[0].iov_len,
+            0 /*flags*/, ivtimeout);
+    } else {
+        numwrit = PR_Writev(sock->fd, iov, iov_size, ivtimeout);
+    }
+
+    PR_Lock(sock->lock);
+    PR_ASSERT(sock->writer == me);
+    sock->writer = NULL;
+    PR_Unlock(sock->lock);
+
+    if( numwrit < 0 ) {
+        PRErrorCode err = PR_GetError();
+        if( err == PR_PENDING_INTERRUPT_ERROR ) {
+#ifdef WINNT
+            /* clean up after PR_Interrupt called by abortReadWrite. */
+            PR_NT_CancelIo(sock->fd);
+#endif 
+            JSSL_throwSSLSocketException(env, "Write operation interrupted");
+        } else if( err == PR_IO_TIMEOUT_ERROR ) {
+#ifdef WINNT
+            /*
+             * if timeout was set, and the PR_Send() timed out,
+             * then cancel the I/O on the socket, otherwise PR_Send()
+             * will always return PR_IO_PENDING_ERROR on subsequent
+             * calls
+             */
+            PR_NT_CancelIo(sock->fd);
+#endif 
+            JSSL_throwSSLSocketException(env, "Operation timed out");
+        } else {
+            JSSL_throwSSLSocketException(env, "Failed to write to socket");
+        }
+        return PR_FAILURE;
+    }
+    /* PR_Send and PR_Writev are supposed to block until they send everything */
+    PR_ASSERT(numwrit == len);
+    return PR_SUCCESS;
+}
+
+/*
+ * Returns the native memory backing a direct java.nio.ByteBuffer after
+ * checking that [off, off+len) lies within it, or NULL if an exception
+ * was thrown.
+ */
+static jbyte *
+getDirectBufferRegion(JNIEnv *env, jobject buffer, jint off, jint len)
+{
+    jbyte *addr;
+    jlong capacity;
+
+    if( buffer == NULL ) {
+        JSS_throw(env, NULL_POINTER_EXCEPTION);
+        return NULL;
+    }
+
+    addr = (*env)->GetDirectBufferAddress(env, buffer);
+    capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if( addr == NULL || capacity < 0 ) {
+        JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+            "Buffer is not a direct buffer");
+        return NULL;
+    }
+    if( off < 0 || len < 0 || ((jlong)off + len) > capacity ) {
+        JSS_throw(env, INDEX_OUT_OF_BOUNDS_EXCEPTION);
+        return NULL;
+    }
+    return addr + off;
+}
+
+/*
+ * When the socket has a native read buffer, makes sure it holds some
+ * plaintext, decrypting the next record into it if it is empty. This
+ * blocks, so callers return early for zero-length reads. Returns
+ * the number of buffered bytes, or -1 on EOF or error. The caller must
+ * hold the SSLSocket read lock.
+ */
+static jint
+fillReadBuffer(JNIEnv *env, JSSL_SocketData *sock, jint timeout)
+{
+    jint nread;
+
+    if( sock->readBufLen > 0 ) {
+        return sock->readBufLen;
+    }
+    nread = recvFromSocket(env, sock, sock->readBuf, sock->readBufSize,
+        timeout);
+    if( nread > 0 ) {
+        sock->readBufStart = 0;
+        sock->readBufLen = nread;
+    }
+    return nread;
+}
+
+/*
+ * Removes up to len bytes from the front of the native read buffer and
+ * returns how many were taken. The bytes start at sock->readBuf + *start.
+ */
+static jint
+takeFromReadBuffer(JSSL_SocketData *sock, jint len, PRInt32 *start)
+{
+    jint n = (len < sock->readBufLen) ? len : sock->readBufLen;
+
+    *start = sock->readBufStart;
+    sock->readBufStart += n;
+    sock->readBufLen -= n;
+    return n;
+}
+
+JNIEXPORT jint JNICALL 
+Java_org_mozilla_jss_ssl_SSLSocket_socketRead(JNIEnv *env, jobject self, 
+    jbyteArray bufBA, jint off, jint len, jint timeout)
+{
+    JSSL_SocketData *sock = NULL;
+    jbyte *buf = NULL;
+    jint size;
+    jint nread = -1;
+    
+    size = (*env)->GetArrayLength(env, bufBA);
+    if( off < 0 || len < 0 || (off+len) > size) {
+        JSS_throw(env, INDEX_OUT_OF_BOUNDS_EXCEPTION);
+        goto finish;
+    }
+
+    /* get the socket */
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+
+    if( sock->readBuf != NULL ) {
+        PRInt32 start;
+
+        /* copy out of the native buffer rather than pinning bufBA */
+        if( len == 0 ) {
+            nread = 0;
+            goto finish;
+        }
+        nread = fillReadBuffer(env, sock, timeout);
+        if( nread > 0 ) {
+            nread = takeFromReadBuffer(sock, len, &start);
+            (*env)->SetByteArrayRegion(env, bufBA, off, nread,
+                (jbyte*) sock->readBuf + start);
+        }
+        goto finish;
+    }
+
+    buf = (*env)->GetByteArrayElements(env, bufBA, NULL);
+    if( buf == NULL ) {
+        goto finish;
+    }
+
+    nread = recvFromSocket(env, sock, buf+off, len, timeout);
 
 finish:
     EXCEPTION_CHECK(env, sock)
-    (*env)->ReleaseByteArrayElements(env, bufBA, buf,
-        (nread>0) ? 0 /*copy and free*/ : JNI_ABORT /*free, no copy*/);
+    if( buf != NULL ) {
+        (*env)->ReleaseByteArrayElements(env, bufBA, buf,
+            (nread>0) ? 0 /*copy and free*/ : JNI_ABORT /*free, no copy*/);
+    }
     return nread;
 }
 
+/*
+ * Reads directly into the native memory of a direct ByteBuffer, so the
+ * plaintext NSS produces never passes through a Java heap array.
+ */
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_socketReadDirect(JNIEnv *env, jobject self,
+    jobject buffer, jint off, jint len, jint timeout)
+{
+    JSSL_SocketData *sock = NULL;
+    jbyte *buf;
+    jint nread = -1;
+
+    buf = getDirectBufferRegion(env, buffer, off, len);
+    if( buf == NULL ) {
+        goto finish;
+    }
+
+    /* get the socket */
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+
+    if( sock->readBuf != NULL ) {
+        PRInt32 start;
+
+        if( len == 0 ) {
+            nread = 0;
+            goto finish;
+        }
+        nread = fillReadBuffer(env, sock, timeout);
+        if( nread > 0 ) {
+            nread = takeFromReadBuffer(sock, len, &start);
+            memcpy(buf, sock->readBuf + start, nread);
+        }
+        goto finish;
+    }
+
+    nread = recvFromSocket(env, sock, buf, len, timeout);
+
+finish:
+    EXCEPTION_CHECK(env, sock)
+    return nread;
+}
+
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_setNativeReadBufferSizeNative(
+    JNIEnv *env, jobject self, jint size)
+{
+    JSSL_SocketData *sock = NULL;
+    char *newBuf = NULL;
+
+    if( size < 0 ) {
+        JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+            "Read buffer size must not be negative");
+        goto finish;
+    }
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+
+    if( sock->readBufLen > size ) {
+        JSSL_throwSSLSocketException(env,
+            "Read buffer holds more unread data than the requested size");
+        goto finish;
+    }
+
+    if( size > 0 ) {
+        newBuf = PR_Malloc(size);
+        if( newBuf == NULL ) {
+            JSS_throw(env, OUT_OF_MEMORY_ERROR);
+            goto finish;
+        }
+        if( sock->readBufLen > 0 ) {
+            memcpy(newBuf, sock->readBuf + sock->readBufStart,
+                sock->readBufLen);
+        }
+    }
+    if( sock->readBuf != NULL ) {
+        PR_Free(sock->readBuf);
+    }
+    sock->readBuf = newBuf;
+    sock->readBufSize = size;
+    sock->readBufStart = 0;
+
+finish:
+    EXCEPTION_CHECK(env, sock)
+    return;
+}
+
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_setAlertEventsEnabled(
+    JNIEnv *env, jobject self, jboolean enabled)
+{
+    JSSL_SocketData *sock = NULL;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+    sock->alertListeners = enabled ? PR_TRUE : PR_FALSE;
+
+finish:
+    EXCEPTION_CHECK(env, sock)
+    return;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_getNativeReadBufferSize(
+    JNIEnv *env, jobject self)
+{
+    JSSL_SocketData *sock = NULL;
+    jint size = 0;
+
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+    size = sock->readBufSize;
+
+finish:
+    EXCEPTION_CHECK(env, sock)
+    return size;
+}
+
 JNIEXPORT jint JNICALL
 Java_org_mozilla_jss_ssl_SSLSocket_socketAvailable(
     JNIEnv *env, jobject self)
@@ -1026,7 +1337,7 @@ Java_org_mozilla_jss_ssl_SSLSocket_socketAvailable(
         goto finish;
     }
 
-    available = SSL_DataPending(sock->fd);
+    available = SSL_DataPending(sock->fd) + sock->readBufLen;
     PR_ASSERT(available >= 0);
 
 finish:
@@ -1041,9 +1352,7 @@ Java_org_mozilla_jss_ssl_SSLSocket_socketWrite(JNIEnv *env, jobject self,
     JSSL_SocketData *sock = NULL;
     jbyte *buf = NULL;
     jint size;
-    PRIntervalTime ivtimeout;
-    PRThread *me;
-    PRInt32 numwrit;
+    PRIOVec iov;
 
     if( bufBA == NULL ) {
         JSS_throw(env, NULL_POINTER_EXCEPTION);
@@ -1061,62 +1370,138 @@ Java_org_mozilla_jss_ssl_SSLSocket_socketWrite(JNIEnv *env, jobject self,
         goto finish;
     }
 
-    ivtimeout = (timeout > 0) ? PR_MillisecondsToInterval(timeout)
-                              : PR_INTERVAL_NO_TIMEOUT;
+    /* get the socket */
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
+        goto finish;
+    }
+
+    iov.iov_base = (char*) buf + off;
+    iov.iov_len = len;
+    sendToSocket(env, sock, &iov, 1, timeout);
+
+finish:
+    if( buf != NULL ) {
+        (*env)->ReleaseByteArrayElements(env, bufBA, buf, JNI_ABORT);
+    }
+    EXCEPTION_CHECK(env, sock)
+}
+
+/*
+ * Writes directly from the native memory of a direct ByteBuffer.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_socketWriteDirect(JNIEnv *env, jobject self,
+    jobject buffer, jint off, jint len, jint timeout)
+{
+    JSSL_SocketData *sock = NULL;
+    jbyte *buf;
+    PRIOVec iov;
+
+    buf = getDirectBufferRegion(env, buffer, off, len);
+    if( buf == NULL ) {
+        goto finish;
+    }
 
     /* get the socket */
     if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
         goto finish;
     }
-    /* set the current thread doing the write */
-    me = PR_GetCurrentThread();
-    PR_Lock(sock->lock);
-    if ( sock->closePending ) {
-       PR_Unlock(sock->lock);
-       JSSL_throwSSLSocketException(env, "Write operation interrupted");
-       goto finish;
+
+    iov.iov_base = (char*) buf;
+    iov.iov_len = len;
+    sendToSocket(env, sock, &iov, 1, timeout);
+
+finish:
+    EXCEPTION_CHECK(env, sock)
+}
+
+/*
+ * Gathering write. Each element of bufs is either a direct ByteBuffer or
+ * the byte[] backing a heap buffer; offs and lens give the region of each
+ * to send. All of them go to NSS in a single PR_Writev call, so that the
+ * data is packed into as few TLS records as possible.
+ */
+JNIEXPORT void JNICALL
+Java_org_mozilla_jss_ssl_SSLSocket_socketWritev(JNIEnv *env, jobject self,
+    jobjectArray bufs, jintArray offsArray, jintArray lensArray, jint timeout)
+{
+    JSSL_SocketData *sock = NULL;
+    PRIOVec iov[PR_MAX_IOVECTOR_SIZE];
+    jbyteArray arrays[PR_MAX_IOVECTOR_SIZE];
+    jbyte *elems[PR_MAX_IOVECTOR_SIZE];
+    jint offs[PR_MAX_IOVECTOR_SIZE];
+    jint lens[PR_MAX_IOVECTOR_SIZE];
+    jint count = 0;
+    int i;
+
+    memset(arrays, 0, sizeof(arrays));
+    memset(elems, 0, sizeof(elems));
+
+    if( bufs == NULL || offsArray == NULL || lensArray == NULL ) {
+        JSS_throw(env, NULL_POINTER_EXCEPTION);
+        goto finish;
     }
-    PR_ASSERT(sock->writer == NULL);
-    sock->writer = me;
-    PR_Unlock(sock->lock);
 
-    numwrit = PR_Send(sock->fd, buf+off, len, 0 /*flags*/, ivtimeout);
+    count = (*env)->GetArrayLength(env, bufs);
+    if( count < 1 || count > PR_MAX_IOVECTOR_SIZE ||
+        (*env)->GetArrayLength(env, offsArray) != count ||
+        (*env)->GetArrayLength(env, lensArray) != count )
+    {
+        count = 0;
+        JSS_throw(env, ILLEGAL_ARGUMENT_EXCEPTION);
+        goto finish;
+    }
+    (*env)->GetIntArrayRegion(env, offsArray, 0, count, offs);
+    (*env)->GetIntArrayRegion(env, lensArray, 0, count, lens);
+    if( (*env)->ExceptionOccurred(env) ) {
+        goto finish;
+    }
 
-    PR_Lock(sock->lock);
-    PR_ASSERT(sock->writer == me);
-    sock->writer = NULL;
-    PR_Unlock(sock->lock);
+    for( i = 0; i < count; ++i ) {
+        jobject buf = (*env)->GetObjectArrayElement(env, bufs, i);
+        jbyte *addr;
 
-    if( numwrit < 0 ) {
-        PRErrorCode err = PR_GetError();
-        if( err == PR_PENDING_INTERRUPT_ERROR ) {
-#ifdef WINNT
-            /* clean up after PR_Interrupt called by abortReadWrite. */
-            PR_NT_CancelIo(sock->fd);
-#endif 
-            JSSL_throwSSLSocketException(env, "Write operation interrupted");
-        } else if( err == PR_IO_TIMEOUT_ERROR ) {
-#ifdef WINNT
-            /*
-             * if timeout was set, and the PR_Send() timed out,
-             * then cancel the I/O on the socket, otherwise PR_Send()
-             * will always return PR_IO_PENDING_ERROR on subsequent
-             * calls
-             */
-            PR_NT_CancelIo(sock->fd);
-#endif 
-            JSSL_throwSSLSocketException(env, "Operation timed out");
+        if( buf == NULL ) {
+            JSS_throw(env, NULL_POINTER_EXCEPTION);
+            goto finish;
+        }
+        addr = (*env)->GetDirectBufferAddress(env, buf);
+        if( addr != NULL ) {
+            addr = getDirectBufferRegion(env, buf, offs[i], lens[i]);
+            if( addr == NULL ) {
+                goto finish;
+            }
         } else {
-            JSSL_throwSSLSocketException(env, "Failed to write to socket");
+            /* not a direct buffer, so it must be a byte array */
+            jint size = (*env)->GetArrayLength(env, buf);
+            if( offs[i] < 0 || lens[i] < 0 || ((jlong)offs[i]+lens[i]) > size ) {
+                JSS_throw(env, INDEX_OUT_OF_BOUNDS_EXCEPTION);
+                goto finish;
+            }
+            arrays[i] = buf;
+            elems[i] = (*env)->GetByteArrayElements(env, buf, NULL);
+            if( elems[i] == NULL ) {
+                goto finish;
+            }
+            addr = elems[i] + offs[i];
         }
+        iov[i].iov_base = (char*) addr;
+        iov[i].iov_len = lens[i];
+    }
+
+    /* get the socket */
+    if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS ) {
         goto finish;
     }
-    /* PR_Send is supposed to block until it sends everything */
-    PR_ASSERT(numwrit == len);
+
+    sendToSocket(env, sock, iov, count, timeout);
 
 finish:
-    if( buf != NULL ) {
-        (*env)->ReleaseByteArrayElements(env, bufBA, buf, JNI_ABORT);
+    for( i = 0; i < count; ++i ) {
+        if( elems[i] != NULL ) {
+            (*env)->ReleaseByteArrayElements(env, arrays[i], elems[i],
+                JNI_ABORT);
+        }
     }
     EXCEPTION_CHECK(env, sock)
 }
@@ -11,8 +11,12 @@ import java.net.InetAddress;
 import java.net.SocketException;
 import java.net.SocketTimeoutException;
 import java.net.UnknownHostException;
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 import java.util.ArrayList;
 import java.util.Collection;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.Executor;
 
 /**
  * SSL client socket.
@@ -407,6 +411,7 @@ public class SSLSocket extends java.net.Socket {
     void setSockProxy(SocketProxy sp) {
         sockProxy = sp;
         base.setProxy(sp);
+        updateAlertEvents();
     }
 
     /**
@@ -753,6 +758,34 @@ public class SSLSocket extends java.net.Socket {
      */
     public native int getReceiveBufferSize() throws SocketException;
 
+    /**
+     * Sets the size (in bytes) of a native buffer that incoming TLS records
+     * are decrypted into. When it is enabled, each read from this socket
+     * first drains buffered plaintext, so a protocol issuing many small
+     * reads crosses into NSS once per record instead of once per read,
+     * and never pins the caller's array. A size of 0 (the default) turns
+     * buffering off. A size of at least 16384, the largest TLS record,
+     * lets every record be decrypted in one call.
+     *
+     * @param size The buffer size in bytes, or 0 to disable buffering.
+     * @exception SocketException If the buffer holds more unread data
+     *      than the new size.
+     */
+    public void setNativeReadBufferSize(int size) throws SocketException {
+        synchronized (readLock) {
+            setNativeReadBufferSizeNative(size);
+        }
+    }
+
+    private native void setNativeReadBufferSizeNative(int size)
+        throws SocketException;
+
+    /**
+     * Returns the size (in bytes) of the native read buffer, or 0 if
+     * reads are not buffered.
+     */
+    public native int getNativeReadBufferSize() throws SocketException;
+
     /**
      * Closes this socket.
      */
@@ -799,13 +832,27 @@ public class SSLSocket extends java.net.Socket {
     public void addSocketListener(SSLSocketListener listener) {
         socketListeners.add(listener);
         addHandshakeCompletedListener(listener);
+        updateAlertEvents();
     }
 
     public void removeSocketListener(SSLSocketListener listener) {
         socketListeners.remove(listener);
         removeHandshakeCompletedListener(listener);
+        updateAlertEvents();
+    }
+
+    /**
+     * Tells the native alert callbacks whether to build SSLAlertEvents at
+     * all. With no socket listener registered they return immediately.
+     */
+    private void updateAlertEvents() {
+        if (sockProxy != null) {
+            setAlertEventsEnabled(!socketListeners.isEmpty());
+        }
     }
 
+    private native void setAlertEventsEnabled(boolean enabled);
+
     private void fireAlertReceivedEvent(SSLAlertEvent event) {
         for (SSLSocketListener listener : socketListeners) {
             listener.alertReceived(event);
@@ -1276,6 +1323,52 @@ public class SSLSocket extends java.net.Socket {
      */
     public native void forceHandshake() throws SocketException;
 
+    /**
+     * Runs the SSL handshake on the given executor instead of the calling
+     * thread. The private key operations and any certificate approval
+     * callback then happen on an executor thread, so a caller such as an
+     * accept loop is never held up by them.
+     *
+     * <p>The returned future completes with a handshake event once the
+     * handshake has finished, or exceptionally if it fails or the executor
+     * rejects the task. Handshake listeners are notified as usual.
+     *
+     * @param executor The executor that drives the handshake.
+     * @return A future for the completed handshake.
+     */
+    public CompletableFuture<SSLHandshakeCompletedEvent>
+    startHandshakeAsync(Executor executor) {
+        CompletableFuture<SSLHandshakeCompletedEvent> future =
+            new CompletableFuture<>();
+        handshakeFuture = future;
+        try {
+            executor.execute(() -> {
+                try {
+                    forceHandshake();
+                    future.complete(new SSLHandshakeCompletedEvent(this));
+                } catch (Throwable t) {
+                    future.completeExceptionally(t);
+                }
+            });
+        } catch (RuntimeException e) {
+            future.completeExceptionally(e);
+        }
+        return future;
+    }
+
+    /**
+     * Returns the future for the most recent handshake started with
+     * <code>startHandshakeAsync</code>, or <code>null</code> if none was.
+     * Sockets accepted by an <code>SSLServerSocket</code> with a handshake
+     * executor already have one.
+     */
+    public CompletableFuture<SSLHandshakeCompletedEvent> getHandshakeFuture() {
+        return handshakeFuture;
+    }
+
+    private volatile CompletableFuture<SSLHandshakeCompletedEvent>
+        handshakeFuture;
+
     /**
      * Determines whether this end of the socket is the client or the server
      *  for purposes of the SSL protocol. By default, it is the client.
@@ -1527,12 +1620,265 @@ public class SSLSocket extends java.net.Socket {
         }
     }
 
+    /**
+     * Reads up to <code>dst.remaining()</code> bytes from this socket into
+     * the given buffer, advancing its position by the number of bytes read.
+     * When <code>dst</code> is a direct buffer, NSS decrypts straight into
+     * its native memory and no Java heap array is involved.
+     *
+     * @param dst The buffer into which bytes are to be transferred.
+     * @return The number of bytes read, or -1 on end of stream.
+     */
+    public int read(ByteBuffer dst)
+        throws IOException, SocketTimeoutException {
+        if (dst.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        int pos = dst.position();
+        int len = dst.remaining();
+        int iRet;
+
+        if (!dst.isDirect()) {
+            iRet = read(dst.array(), dst.arrayOffset() + pos, len);
+            if (iRet > 0) {
+                dst.position(pos + iRet);
+            }
+            return iRet;
+        }
+
+        synchronized (readLock) {
+            synchronized (this) {
+                if ( isClosed ) { /* abort read if socket is closed */
+                    throw new IOException(
+                        "Socket has been closed, and cannot be reused.");
+                }
+                inRead = true;
+            }
+            try {
+                iRet = socketReadDirect(dst, pos, len, base.getTimeout());
+            } catch (SocketTimeoutException ste) {
+                throw new SocketTimeoutException(
+                    "SocketTimeoutException cannot read on socket");
+            } catch (IOException ioe) {
+                throw new IOException(
+                    "SocketException cannot read on socket");
+            } finally {
+                synchronized (this) {
+                    inRead = false;
+                }
+            }
+        }
+        if (iRet > 0) {
+            dst.position(pos + iRet);
+        }
+        return iRet;
+    }
+
+    /**
+     * Writes all of the remaining bytes of the given buffer to this socket,
+     * advancing its position to its limit. When <code>src</code> is a
+     * direct buffer, NSS encrypts straight from its native memory.
+     *
+     * @param src The buffer from which bytes are to be retrieved.
+     * @return The number of bytes written.
+     */
+    public int write(ByteBuffer src)
+        throws IOException, SocketTimeoutException {
+        int pos = src.position();
+        int len = src.remaining();
+
+        if (!src.isDirect()) {
+            if (src.hasArray()) {
+                write(src.array(), src.arrayOffset() + pos, len);
+            } else {
+                /* read-only heap buffer; we can't get at its array */
+                byte[] b = new byte[len];
+                src.duplicate().get(b);
+                write(b, 0, len);
+            }
+            src.position(pos + len);
+            return len;
+        }
+
+        synchronized (writeLock) {
+            synchronized (this) {
+                if ( isClosed ) { /* abort write if socket is closed */
+                    throw new IOException(
+                        "Socket has been closed, and cannot be reused.");
+                }
+                inWrite = true;
+            }
+            try {
+                socketWriteDirect(src, pos, len, base.getTimeout());
+            } catch (SocketTimeoutException ste) {
+                throw new SocketTimeoutException(
+                    "SocketTimeoutException cannot write on socket");
+            } catch (IOException ioe) {
+                throw new IOException(
+                    "SocketException cannot write on socket");
+            } finally {
+                synchronized (this) {
+                    inWrite = false;
+                }
+            }
+        }
+        src.position(pos + len);
+        return len;
+    }
+
+    /**
+     * Reads a sequence of bytes from this socket into the given buffers.
+     * The first buffer with space remaining is filled with a blocking read;
+     * later buffers are filled only with data NSS has already decrypted,
+     * so this call never blocks once some data has been read.
+     *
+     * @param dsts The buffers into which bytes are to be transferred.
+     * @return The number of bytes read, or -1 on end of stream.
+     */
+    public long read(ByteBuffer[] dsts)
+        throws IOException, SocketTimeoutException {
+        return read(dsts, 0, dsts.length);
+    }
+
+    /**
+     * Reads a sequence of bytes from this socket into a subsequence of
+     * the given buffers.
+     *
+     * @see #read(ByteBuffer[])
+     */
+    public long read(ByteBuffer[] dsts, int offset, int length)
+        throws IOException, SocketTimeoutException {
+        if (offset < 0 || length < 0 || offset > dsts.length - length) {
+            throw new IndexOutOfBoundsException();
+        }
+        long total = 0;
+        for (int i = offset; i < offset + length; i++) {
+            ByteBuffer dst = dsts[i];
+            if (!dst.hasRemaining()) {
+                continue;
+            }
+            if (total > 0 && socketAvailable() <= 0) {
+                break;
+            }
+            int nread = read(dst);
+            if (nread < 0) {
+                return (total > 0) ? total : -1;
+            }
+            total += nread;
+            if (dst.hasRemaining()) {
+                break;
+            }
+        }
+        return total;
+    }
+
+    /**
+     * Writes the remaining bytes of each of the given buffers to this
+     * socket. The buffers are passed to NSS together with a single call
+     * to <code>PR_Writev</code>, so NSS packs them into full-size TLS
+     * records rather than sending one record per buffer.
+     *
+     * @param srcs The buffers from which bytes are to be retrieved.
+     * @return The number of bytes written.
+     */
+    public long write(ByteBuffer[] srcs)
+        throws IOException, SocketTimeoutException {
+        return write(srcs, 0, srcs.length);
+    }
+
+    /**
+     * Writes the remaining bytes of a subsequence of the given buffers
+     * to this socket.
+     *
+     * @see #write(ByteBuffer[])
+     */
+    public long write(ByteBuffer[] srcs, int offset, int length)
+        throws IOException, SocketTimeoutException {
+        if (offset < 0 || length < 0 || offset > srcs.length - length) {
+            throw new IndexOutOfBoundsException();
+        }
+        long total = 0;
+        int i = offset;
+        while (i < offset + length) {
+            int count = Math.min(MAX_IOVECS, offset + length - i);
+            Object[] bufs = new Object[count];
+            int[] offs = new int[count];
+            int[] lens = new int[count];
+            for (int j = 0; j < count; j++) {
+                ByteBuffer src = srcs[i + j];
+                offs[j] = src.position();
+                lens[j] = src.remaining();
+                if (src.isDirect()) {
+                    bufs[j] = src;
+                } else if (src.hasArray()) {
+                    bufs[j] = src.array();
+                    offs[j] += src.arrayOffset();
+                } else {
+                    /* read-only heap buffer; we can't get at its array */
+                    byte[] b = new byte[lens[j]];
+                    src.duplicate().get(b);
+                    bufs[j] = b;
+                    offs[j] = 0;
+                }
+            }
+            writev(bufs, offs, lens);
+            for (int j = 0; j < count; j++) {
+                ByteBuffer src = srcs[i + j];
+                src.position(src.limit());
+                total += lens[j];
+            }
+            i += count;
+        }
+        return total;
+    }
+
+    private void writev(Object[] bufs, int[] offs, int[] lens)
+        throws IOException, SocketTimeoutException {
+        synchronized (writeLock) {
+            synchronized (this) {
+                if ( isClosed ) { /* abort write if socket is closed */
+                    throw new IOException(
+                        "Socket has been closed, and cannot be reused.");
+                }
+                inWrite = true;
+            }
+            try {
+                socketWritev(bufs, offs, lens, base.getTimeout());
+            } catch (SocketTimeoutException ste) {
+                throw new SocketTimeoutException(
+                    "SocketTimeoutException cannot write on socket");
+            } catch (IOException ioe) {
+                throw new IOException(
+                    "SocketException cannot write on socket");
+            } finally {
+                synchronized (this) {
+                    inWrite = false;
+                }
+            }
+        }
+    }
+
+    /**
+     * The largest number of buffers NSPR accepts in one PR_Writev call
+     * (PR_MAX_IOVECTOR_SIZE).
+     */
+    private static final int MAX_IOVECS = 16;
+
     private native int socketRead(byte[] b, int off, int len, int timeout)
         throws IOException;
 
     private native void socketWrite(byte[] b, int off, int len, int timeout)
         throws IOException;
 
+    private native int socketReadDirect(ByteBuffer b, int off, int len,
+        int timeout) throws IOException;
+
+    private native void socketWriteDirect(ByteBuffer b, int off, int len,
+        int timeout) throws IOException;
+
+    private native void socketWritev(Object[] bufs, int[] offs, int[] lens,
+        int timeout) throws IOException;
+
     /**
      * Removes the current session from the session cache.
      */
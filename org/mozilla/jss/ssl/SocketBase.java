@@ -39,7 +39,7 @@ class SocketBase {
         this.sockProxy = sockProxy;
     }
 
-    native byte[] socketCreate(Object socketObject,
+    native long socketCreate(Object socketObject,
             SSLCertificateApprovalCallback certApprovalCallback,
             SSLClientCertificateSelectionCallback clientCertSelectionCallback,
             java.net.Socket javaSock, String host, int family)
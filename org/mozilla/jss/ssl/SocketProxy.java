@@ -6,7 +6,7 @@ package org.mozilla.jss.ssl;
 
 class SocketProxy extends org.mozilla.jss.util.NativeProxy {
 
-    public SocketProxy(byte[] pointer) {
+    public SocketProxy(long pointer) {
         super(pointer);
     }
 
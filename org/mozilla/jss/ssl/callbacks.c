@@ -6,6 +6,7 @@
 
 #include <nspr.h>
 #include <java_ids.h>
+#include <jss_ids.h>
 #include <jss_exceptions.h>
 #include <secitem.h>
 #include <jssutil.h>
@@ -267,167 +268,138 @@ JSSL_CallCertSelectionCallback(    void * arg,
     return rv;
 }
 
-void
-JSSL_AlertReceivedCallback(const PRFileDesc *fd, void *arg, const SSLAlert *alert)
+/*
+ * Returns the JNIEnv of the current thread. NSS calls back on the thread
+ * that entered it through JNI, so the thread is normally attached
+ * already; only a foreign thread is attached here, and *attached is set
+ * so that the caller detaches it again with releaseCallbackEnv.
+ */
+static JNIEnv *
+getCallbackEnv(PRBool *attached)
 {
-    JSSL_SocketData *socket = (JSSL_SocketData*) arg;
-
+    JNIEnv *env = NULL;
     jint rc;
-    JNIEnv *env;
-    jclass socketClass, eventClass;
-    jmethodID eventConstructor, eventSetLevel, eventSetDescription;
-    jobject event;
-    jmethodID fireEvent;
 
-    PR_ASSERT(socket != NULL);
-    PR_ASSERT(socket->socketObject != NULL);
-
-    rc = (*JSS_javaVM)->AttachCurrentThread(JSS_javaVM, (void**)&env, NULL);
+    *attached = PR_FALSE;
+    rc = (*JSS_javaVM)->GetEnv(JSS_javaVM, (void**)&env, JNI_VERSION_1_2);
+    if( rc == JNI_EDETACHED ) {
+        rc = (*JSS_javaVM)->AttachCurrentThread(JSS_javaVM, (void**)&env,
+            NULL);
+        *attached = (rc == JNI_OK);
+    }
     PR_ASSERT(rc == JNI_OK);
-    PR_ASSERT(env != NULL);
+    return (rc == JNI_OK) ? env : NULL;
+}
 
-    /* Fast return when assumptions are incorrect. */
-    if (socket != NULL || socket->socketObject != NULL ||
-            rc != JNI_OK || env != NULL) {
+/*
+ * Detaches the current thread if getCallbackEnv attached it. Anything
+ * the callback left pending is cleared first, since it has no Java
+ * caller to propagate to.
+ */
+static void
+releaseCallbackEnv(JNIEnv *env, PRBool attached)
+{
+    if( !attached ) {
         return;
     }
-
-    /* SSLAlertEvent event = new SSLAlertEvent(socket); */
-
-    socketClass = (*env)->FindClass(env, SSLSOCKET_CLASS);
-    PR_ASSERT(socketClass != NULL);
-
-    eventClass = (*env)->FindClass(env, SSL_ALERT_EVENT_CLASS);
-    PR_ASSERT(eventClass != NULL);
-
-    eventConstructor = (*env)->GetMethodID(env, eventClass, "<init>", "(L" SSLSOCKET_CLASS ";)V");
-    PR_ASSERT(eventConstructor != NULL);
-
-    event = (*env)->NewObject(env, eventClass, eventConstructor, socket->socketObject);
-    PR_ASSERT(event != NULL);
-
-    /* event.setLevel(level); */
-
-    eventSetLevel = (*env)->GetMethodID(env, eventClass, "setLevel", "(I)V");
-    PR_ASSERT(eventSetLevel != NULL);
-
-    (*env)->CallVoidMethod(env, event, eventSetLevel, (int)alert->level);
-
-    /* event.setDescription(description); */
-
-    eventSetDescription = (*env)->GetMethodID(env, eventClass, "setDescription", "(I)V");
-    PR_ASSERT(eventSetDescription != NULL);
-
-    (*env)->CallVoidMethod(env, event, eventSetDescription, alert->description);
-
-    /* socket.fireAlertReceivedEvent(event); */
-
-    fireEvent = (*env)->GetMethodID(env,
-        socketClass,
-        "fireAlertReceivedEvent",
-        "(L" SSL_ALERT_EVENT_CLASS ";)V");
-    PR_ASSERT(fireEvent != NULL);
-
-    (*env)->CallVoidMethod(env, socket->socketObject, fireEvent, event);
-
+    if( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+    }
     (*JSS_javaVM)->DetachCurrentThread(JSS_javaVM);
 }
 
-void
-JSSL_AlertSentCallback(const PRFileDesc *fd, void *arg, const SSLAlert *alert)
+/*
+ * Builds an SSLAlertEvent for alert and passes it to the given
+ * fireAlert*Event method of the socket.
+ */
+static void
+fireAlertEvent(JSSL_SocketData *socket, const SSLAlert *alert,
+    jmethodID fireEvent)
 {
-    JSSL_SocketData *socket = (JSSL_SocketData*) arg;
-
-    jint rc;
     JNIEnv *env;
-    jclass socketClass, eventClass;
-    jmethodID eventConstructor, eventSetLevel, eventSetDescription;
+    PRBool attached;
     jobject event;
-    jmethodID fireEvent;
 
     PR_ASSERT(socket != NULL);
-    PR_ASSERT(socket->socketObject != NULL);
 
-    rc = (*JSS_javaVM)->AttachCurrentThread(JSS_javaVM, (void**)&env, NULL);
-    PR_ASSERT(rc == JNI_OK);
-    PR_ASSERT(env != NULL);
+    /* Nobody is listening (and JSSEngine never listens): skip the event */
+    if( socket == NULL || !socket->alertListeners ||
+        socket->socketObject == NULL )
+    {
+        return;
+    }
 
-    /* Fast return when assumptions are incorrect. */
-    if (socket != NULL || socket->socketObject != NULL ||
-            rc != JNI_OK || env != NULL) {
+    env = getCallbackEnv(&attached);
+    if( env == NULL ) {
         return;
     }
 
     /* SSLAlertEvent event = new SSLAlertEvent(socket); */
-
-    socketClass = (*env)->FindClass(env, SSLSOCKET_CLASS);
-    PR_ASSERT(socketClass != NULL);
-
-    eventClass = (*env)->FindClass(env, SSL_ALERT_EVENT_CLASS);
-    PR_ASSERT(eventClass != NULL);
-
-    eventConstructor = (*env)->GetMethodID(env, eventClass, "<init>", "(L" SSLSOCKET_CLASS ";)V");
-    PR_ASSERT(eventConstructor != NULL);
-
-    event = (*env)->NewObject(env, eventClass, eventConstructor, socket->socketObject);
-    PR_ASSERT(event != NULL);
+    event = (*env)->NewObject(env, JSS_CLASS(SSLAlertEvent),
+        JSS_METHOD(SSLAlertEvent, init), socket->socketObject);
+    if( event == NULL ) {
+        goto finish;
+    }
 
     /* event.setLevel(level); */
-
-    eventSetLevel = (*env)->GetMethodID(env, eventClass, "setLevel", "(I)V");
-    PR_ASSERT(eventSetLevel != NULL);
-
-    (*env)->CallVoidMethod(env, event, eventSetLevel, (int)alert->level);
+    (*env)->CallVoidMethod(env, event, JSS_METHOD(SSLAlertEvent, setLevel),
+        (jint)alert->level);
 
     /* event.setDescription(description); */
+    (*env)->CallVoidMethod(env, event,
+        JSS_METHOD(SSLAlertEvent, setDescription), (jint)alert->description);
 
-    eventSetDescription = (*env)->GetMethodID(env, eventClass, "setDescription", "(I)V");
-    PR_ASSERT(eventSetDescription != NULL);
-
-    (*env)->CallVoidMethod(env, event, eventSetDescription, alert->description);
+    /* socket.fireAlert*Event(event); */
+    (*env)->CallVoidMethod(env, socket->socketObject, fireEvent, event);
 
-    /* socket.fireAlertSentEvent(event); */
+    (*env)->DeleteLocalRef(env, event);
 
-    fireEvent = (*env)->GetMethodID(env,
-        socketClass,
-        "fireAlertSentEvent",
-        "(L" SSL_ALERT_EVENT_CLASS ";)V");
-    PR_ASSERT(fireEvent != NULL);
+finish:
+    releaseCallbackEnv(env, attached);
+}
 
-    (*env)->CallVoidMethod(env, socket->socketObject, fireEvent, event);
+void
+JSSL_AlertReceivedCallback(const PRFileDesc *fd, void *arg, const SSLAlert *alert)
+{
+    fireAlertEvent((JSSL_SocketData*) arg, alert,
+        JSS_METHOD(SSLSocket, fireAlertReceived));
+}
 
-    (*JSS_javaVM)->DetachCurrentThread(JSS_javaVM);
+void
+JSSL_AlertSentCallback(const PRFileDesc *fd, void *arg, const SSLAlert *alert)
+{
+    fireAlertEvent((JSSL_SocketData*) arg, alert,
+        JSS_METHOD(SSLSocket, fireAlertSent));
 }
 
 void
 JSSL_HandshakeCallback(PRFileDesc *fd, void *arg)
 {
     JSSL_SocketData *sock = (JSSL_SocketData*) arg;
-    jclass sockClass;
     jmethodID notifierID;
     JNIEnv *env;
+    PRBool attached;
 
     PR_ASSERT(sock!=NULL);
 
     /* get the JNI environment */
-    if((*JSS_javaVM)->AttachCurrentThread(JSS_javaVM, (void**)&env, NULL) != 0){
-        PR_ASSERT(PR_FALSE);
-        goto finish;
+    env = getCallbackEnv(&attached);
+    if( env == NULL ) {
+        return;
     }
-    PR_ASSERT(env != NULL);
 
-    /* get the handshake notification method ID */
+    /* SSLSocket and JSSEngine both have a notifyAllHandshakeListeners */
     PR_ASSERT(sock->socketObject!=NULL);
-    sockClass = (*env)->GetObjectClass(env, sock->socketObject);
-    notifierID = (*env)->GetMethodID(env, sockClass,
-        SSLSOCKET_HANDSHAKE_NOTIFIER_NAME, SSLSOCKET_HANDSHAKE_NOTIFIER_SIG);
-    if(notifierID == NULL) goto finish;
+    if( (*env)->IsInstanceOf(env, sock->socketObject, JSS_CLASS(SSLSocket)) ) {
+        notifierID = JSS_METHOD(SSLSocket, notifyHandshake);
+    } else {
+        notifierID = JSS_METHOD(JSSEngine, notifyHandshake);
+    }
 
     /* call the handshake notification method */
     (*env)->CallVoidMethod(env, sock->socketObject, notifierID);
 
-finish:
-    return;
+    releaseCallbackEnv(env, attached);
 }
 
 /*
@@ -12,6 +12,7 @@
 #include <jssutil.h>
 #include <jss_exceptions.h>
 #include <java_ids.h>
+#include <jss_ids.h>
 #include <pk11util.h>
 #include "_jni/org_mozilla_jss_ssl_SSLSocket.h"
 #include "jssl.h"
@@ -111,12 +112,12 @@ finish:
  * This is done for regular sockets that we connect() and server sockets,
  * but not for sockets that come from accept.
  */
-JNIEXPORT jbyteArray JNICALL
+JNIEXPORT jlong JNICALL
 Java_org_mozilla_jss_ssl_SocketBase_socketCreate(JNIEnv *env, jobject self,
     jobject sockObj, jobject certApprovalCallback,
     jobject clientCertSelectionCallback, jobject javaSock, jstring host,jint family)
 {
-    jbyteArray sdArray = NULL;
+    jlong sdPtr = 0;
     JSSL_SocketData *sockdata = NULL;
     SECStatus status;
     PRFileDesc *newFD = NULL;
@@ -237,11 +238,7 @@ Java_org_mozilla_jss_ssl_SocketBase_socketCreate(JNIEnv *env, jobject self,
     }
 
     /* pass the pointer back to Java */
-    sdArray = JSS_ptrToByteArray(env, (void*) sockdata);   
-    if( sdArray == NULL ) {
-        /* exception was thrown */
-        goto finish;
-    }
+    sdPtr = JSS_ptrToLong(sockdata);
 
 finish:
     if( (*env)->ExceptionOccurred(env) != NULL ) {
@@ -251,10 +248,11 @@ finish:
         if( newFD != NULL ) {
             PR_Close(newFD);
         }
+        sdPtr = 0;
     } else {
-        PR_ASSERT( sdArray != NULL );
+        PR_ASSERT( sdPtr != 0 );
     }
-    return sdArray;
+    return sdPtr;
 }
 
 JSSL_SocketData*
@@ -282,6 +280,11 @@ JSSL_CreateSocketData(JNIEnv *env, jobject sockObj, PRFileDesc* newFD,
     sockdata->writer = NULL;
     sockdata->accepter = NULL;
     sockdata->closePending = PR_FALSE;
+    sockdata->readBuf = NULL;
+    sockdata->readBufSize = 0;
+    sockdata->readBufStart = 0;
+    sockdata->readBufLen = 0;
+    sockdata->alertListeners = PR_FALSE;
 
     sockdata->lock = PR_NewLock();
     if( sockdata->lock == NULL ) {
@@ -339,6 +342,35 @@ Java_org_mozilla_jss_ssl_SocketProxy_releaseNativeResources
     /* therefore must be implemented by SocketProxy */
 }
 
+PRStatus
+JSSL_getSockData(JNIEnv *env, jobject sockObject, JSSL_SocketData **sdptr)
+{
+    jfieldID proxyField;
+    jobject proxyObject;
+
+    PR_ASSERT(env!=NULL && sockObject!=NULL && sdptr!=NULL);
+
+    if( (*env)->IsInstanceOf(env, sockObject, JSS_CLASS(SSLSocket)) ) {
+        proxyField = JSS_FIELD(SSLSocket, sockProxy);
+    } else if( (*env)->IsInstanceOf(env, sockObject, JSS_CLASS(SocketBase)) ) {
+        proxyField = JSS_FIELD(SocketBase, sockProxy);
+    } else if( (*env)->IsInstanceOf(env, sockObject,
+                    JSS_CLASS(SSLServerSocket)) ) {
+        proxyField = JSS_FIELD(SSLServerSocket, sockProxy);
+    } else if( (*env)->IsInstanceOf(env, sockObject, JSS_CLASS(JSSEngine)) ) {
+        proxyField = JSS_FIELD(JSSEngine, sockProxy);
+    } else {
+        JSS_throwMsg(env, ILLEGAL_ARGUMENT_EXCEPTION,
+            "Object does not hold an SSL socket");
+        return PR_FAILURE;
+    }
+
+    proxyObject = (*env)->GetObjectField(env, sockObject, proxyField);
+    PR_ASSERT(proxyObject != NULL);
+
+    return JSS_getPtrFromProxy(env, proxyObject, (void**)sdptr);
+}
+
 void
 JSSL_DestroySocketData(JNIEnv *env, JSSL_SocketData *sd)
 {
@@ -364,6 +396,9 @@ JSSL_DestroySocketData(JNIEnv *env, JSSL_SocketData *sd)
     if( sd->lock != NULL ) {
         PR_DestroyLock(sd->lock);
     }
+    if( sd->readBuf != NULL ) {
+        PR_Free(sd->readBuf);
+    }
     PR_Free(sd);
 }
 
@@ -423,8 +458,6 @@ Java_org_mozilla_jss_ssl_SocketBase_socketBind
     int addrBALen = 0;
     PRStatus status;
 
-    jmethodID supportsIPV6ID;
-    jclass socketBaseClass;
     jboolean supportsIPV6 = 0;
 
     if( JSSL_getSockData(env, self, &sock) != PR_SUCCESS) {
@@ -440,21 +473,8 @@ Java_org_mozilla_jss_ssl_SocketBase_socketBind
      * Do we support IPV6?
      */
 
-    socketBaseClass = (*env)->FindClass(env, SOCKET_BASE_NAME);
-    if( socketBaseClass == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-    supportsIPV6ID = (*env)->GetStaticMethodID(env, socketBaseClass,
-        SUPPORTS_IPV6_NAME, SUPPORTS_IPV6_SIG);
-
-    if( supportsIPV6ID == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
-    supportsIPV6 = (*env)->CallStaticBooleanMethod(env, socketBaseClass,
-         supportsIPV6ID);
+    supportsIPV6 = (*env)->CallStaticBooleanMethod(env, JSS_CLASS(SocketBase),
+         JSS_METHOD(SocketBase, supportsIPV6));
 
     memset( &addr, 0, sizeof( PRNetAddr ));
 
@@ -799,6 +819,53 @@ Java_org_mozilla_jss_ssl_SocketBase_setClientCertNicknameNative(
     JSS_throwMsg(env, SOCKET_EXCEPTION, "JSS JAR/DLL mismatch");
 }
 
+/*
+ * Configures the certificate and matching private key the socket presents
+ * when acting as a server. Throws an exception on failure.
+ */
+void
+JSSL_ConfigSecureServer(JNIEnv *env, JSSL_SocketData *sock, jobject certObj)
+{
+    CERTCertificate* cert=NULL;
+    PK11SlotInfo* slot=NULL;
+    SECKEYPrivateKey* privKey=NULL;
+    SSLKEAType certKEA;
+    SECStatus status;
+
+    if( certObj == NULL ) {
+        JSS_throw(env, NULL_POINTER_EXCEPTION);
+        goto finish;
+    }
+
+    if( JSS_PK11_getCertPtr(env, certObj, &cert) != PR_SUCCESS ) {
+        goto finish;
+    }
+    PR_ASSERT(cert!=NULL); /* shouldn't happen */
+    if( JSS_PK11_getCertSlotPtr(env, certObj, &slot) != PR_SUCCESS ) {
+        goto finish;
+    }
+    PR_ASSERT(slot!=NULL); /* shouldn't happen */
+
+    privKey = PK11_FindPrivateKeyFromCert(slot, cert, NULL);
+    if (privKey != NULL) {
+        certKEA = NSS_FindCertKEAType(cert);
+        status = SSL_ConfigSecureServer(sock->fd, cert, privKey, certKEA); 
+        if( status != SECSuccess) {
+            JSSL_throwSSLSocketException(env,
+                "Failed to configure secure server certificate and key");
+            goto finish;
+        }
+    } else {
+        JSSL_throwSSLSocketException(env, "Failed to locate private key");
+        goto finish;
+    }
+
+finish:
+    if(privKey!=NULL) {
+        SECKEY_DestroyPrivateKey(privKey);
+    }
+}
+
 JNIEXPORT void JNICALL
 Java_org_mozilla_jss_ssl_SocketBase_setClientCert(
     JNIEnv *env, jobject self, jobject certObj)
@@ -861,24 +928,11 @@ JSS_SSL_processExceptions(JNIEnv *env, PRFilePrivate *priv)
     (*env)->ExceptionClear(env);
 
     if( currentExcep != NULL ) {
-        jmethodID processExcepsID;
-        jclass socketBaseClass;
         jthrowable newException;
 
-        socketBaseClass = (*env)->FindClass(env, SOCKET_BASE_NAME);
-        if( socketBaseClass == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-        processExcepsID = (*env)->GetStaticMethodID(env, socketBaseClass,
-            PROCESS_EXCEPTIONS_NAME, PROCESS_EXCEPTIONS_SIG);
-        if( processExcepsID == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        newException = (*env)->CallStaticObjectMethod(env, socketBaseClass,
-            processExcepsID, currentExcep, JSS_SSL_getException(priv));
+        newException = (*env)->CallStaticObjectMethod(env,
+            JSS_CLASS(SocketBase), JSS_METHOD(SocketBase, processExceptions),
+            currentExcep, JSS_SSL_getException(priv));
 
         if( newException == NULL ) {
             ASSERT_OUTOFMEM(env);
@@ -14,6 +14,7 @@
 
 #include <jssutil.h>
 #include <java_ids.h>
+#include <jss_ids.h>
 
 static PRIntn
 invalidInt()
@@ -25,6 +26,10 @@ invalidInt()
 struct PRFilePrivate {
     JavaVM *javaVM;
     jobject sockGlobalRef;
+    jobject inputStream;    /* global ref, fetched on first read */
+    jobject outputStream;   /* global ref, fetched on first write */
+    jbyteArray readBuffer;  /* global ref, reused across reads */
+    jbyteArray writeBuffer; /* global ref, reused across writes */
     jthrowable exception;
     PRIntervalTime timeout;
 };
@@ -54,73 +59,101 @@ JSS_SSL_getException(PRFilePrivate *priv)
 #define GET_ENV(vm, env) \
     ( ((*(vm))->AttachCurrentThread((vm), (void**)&(env), NULL) == 0) ? 0 : 1 )
 
-static PRInt32 
-writebuf(JNIEnv *env, PRFileDesc *fd, jobject sockObj, jbyteArray byteArray)
+/*
+ * Returns the stream held in *slot, fetching it from the socket with the
+ * given getter and caching a global ref the first time.
+ */
+static jobject
+getStream(JNIEnv *env, PRFilePrivate *priv, jobject *slot, jmethodID getter)
 {
-    jmethodID getOutputStream, writeMethod;
-    jclass sockClass, osClass;
-    jobject outputStream;
-    jint arrayLen=-1;
-    PRInt32 retval;
+    jobject stream;
 
-    if( env == NULL ) {
-        goto finish;
+    if( *slot != NULL ) {
+        return *slot;
+    }
+    stream = (*env)->CallObjectMethod(env, priv->sockGlobalRef, getter);
+    if( stream == NULL ) {
+        ASSERT_OUTOFMEM(env);
+        return NULL;
     }
+    *slot = (*env)->NewGlobalRef(env, stream);
+    (*env)->DeleteLocalRef(env, stream);
+    return *slot;
+}
 
-    /*
-     * get the OutputStream
-     */
-    sockClass = (*env)->GetObjectClass(env, sockObj);
-    PR_ASSERT(sockClass != NULL);
-    getOutputStream = (*env)->GetMethodID(env, sockClass, 
-        SOCKET_GET_OUTPUT_STREAM_NAME,
-        SOCKET_GET_OUTPUT_STREAM_SIG);
-    if(getOutputStream == NULL) {
+/*
+ * Returns the transfer array held in *slot, replacing it with a larger
+ * one if it holds fewer than len bytes.
+ */
+static jbyteArray
+getTransferBuffer(JNIEnv *env, jbyteArray *slot, jint len)
+{
+    jbyteArray array;
+
+    if( *slot != NULL && (*env)->GetArrayLength(env, *slot) >= len ) {
+        return *slot;
+    }
+    array = (*env)->NewByteArray(env, len);
+    if( array == NULL ) {
         ASSERT_OUTOFMEM(env);
-        goto finish;
+        return NULL;
+    }
+    if( *slot != NULL ) {
+        (*env)->DeleteGlobalRef(env, *slot);
     }
-    outputStream = (*env)->CallObjectMethod(env, sockObj, getOutputStream);
+    *slot = (*env)->NewGlobalRef(env, array);
+    (*env)->DeleteLocalRef(env, array);
+    return *slot;
+}
+
+/*
+ * Writes the iov_size buffers described by iov to the socket's
+ * OutputStream, staging them in the socket's transfer array.
+ */
+static PRInt32
+writebuf(JNIEnv *env, PRFileDesc *fd, const PRIOVec *iov, PRInt32 iov_size)
+{
+    PRFilePrivate *priv = fd->secret;
+    jobject outputStream;
+    jbyteArray byteArray;
+    jint len = 0;
+    int iovi;
+    PRInt32 retval;
+
+    outputStream = getStream(env, priv, &priv->outputStream,
+        JSS_METHOD(Socket, getOutputStream));
     if( outputStream == NULL ) {
-        ASSERT_OUTOFMEM(env);
         goto finish;
     }
-    
-    /*
-     * get OutputStream.write
-     */
-    osClass = (*env)->GetObjectClass(env, outputStream);
-    writeMethod = (*env)->GetMethodID(env, osClass,
-        OSTREAM_WRITE_NAME,
-        OSTREAM_WRITE_SIG);
-    if( writeMethod == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
+
+    for( iovi = 0; iovi < iov_size; ++iovi ) {
+        len += iov[iovi].iov_len;
     }
+    PR_ASSERT(len >= 0);
 
-    arrayLen = (*env)->GetArrayLength(env, byteArray);
+    byteArray = getTransferBuffer(env, &priv->writeBuffer, len);
+    if( byteArray == NULL ) {
+        goto finish;
+    }
+    for( iovi = 0, len = 0; iovi < iov_size; ++iovi ) {
+        (*env)->SetByteArrayRegion(env, byteArray, len, iov[iovi].iov_len,
+            (jbyte*) iov[iovi].iov_base);
+        len += iov[iovi].iov_len;
+    }
 
     /*
      * Write bytes
      */
-    (*env)->CallVoidMethod(env, outputStream, writeMethod, byteArray,
-        0, arrayLen);
+    (*env)->CallVoidMethod(env, outputStream, JSS_METHOD(OutputStream, write),
+        byteArray, 0, len);
 
     /* this may have thrown an IO Exception */
 
 finish:
-    if( env != NULL ) {
-        jthrowable excep = (*env)->ExceptionOccurred(env);
-        if( excep != NULL ) {
-            setException(env, fd->secret, (*env)->NewGlobalRef(env, excep));
-            (*env)->ExceptionClear(env);
-            retval = -1;
-            PR_SetError(PR_IO_ERROR, 0);
-        } else {
-            retval = arrayLen;
-        }
-    } else {
+    if( (*env)->ExceptionOccurred(env) != NULL ) {
         retval = -1;
-        PR_SetError(PR_IO_ERROR, 0);
+    } else {
+        retval = len;
     }
     return retval;
 }
@@ -130,8 +163,6 @@ static PRStatus
 processTimeout(JNIEnv *env, PRFileDesc *fd, jobject sockObj,
         PRIntervalTime timeout)
 {
-    jclass socketClass;
-    jmethodID setSoTimeoutMethod;
     jint javaTimeout;
 
     if( timeout == fd->secret->timeout ) {
@@ -139,21 +170,6 @@ processTimeout(JNIEnv *env, PRFileDesc *fd, jobject sockObj,
         goto finish;
     }
 
-    /*
-     * Call setSoTimeout on the Java socket
-     */
-    socketClass = (*env)->GetObjectClass(env, sockObj);
-    if( socketClass == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-    setSoTimeoutMethod = (*env)->GetMethodID(env, socketClass,
-        SET_SO_TIMEOUT_NAME, SET_SO_TIMEOUT_SIG);
-    if( setSoTimeoutMethod == NULL ) {
-        ASSERT_OUTOFMEM(env);
-        goto finish;
-    }
-
     if( timeout == PR_INTERVAL_NO_TIMEOUT ) {
         javaTimeout = 0; /* 0 means no timeout in Java */
     } else if( timeout == PR_INTERVAL_NO_WAIT ) {
@@ -163,7 +179,11 @@ processTimeout(JNIEnv *env, PRFileDesc *fd, jobject sockObj,
         javaTimeout = PR_IntervalToMilliseconds(timeout);
     }
 
-    (*env)->CallVoidMethod(env, sockObj, setSoTimeoutMethod, javaTimeout);
+    /*
+     * Call setSoTimeout on the Java socket
+     */
+    (*env)->CallVoidMethod(env, sockObj, JSS_METHOD(Socket, setSoTimeout),
+        javaTimeout);
     /* This may have thrown an exception */
 
     fd->secret->timeout = timeout;
@@ -182,7 +202,6 @@ jsock_write(PRFileDesc *fd, const PRIOVec *iov, PRInt32 iov_size,
 {
     jobject sockObj;
     JNIEnv *env;
-    jbyteArray outbufArray;
     PRInt32 retval=-1;
 
     if( GET_ENV(fd->secret->javaVM, env) ) goto finish;
@@ -195,40 +214,10 @@ jsock_write(PRFileDesc *fd, const PRIOVec *iov, PRInt32 iov_size,
 
     if( processTimeout(env, fd, sockObj, timeout) != PR_SUCCESS ) goto finish;
 
-    /*
-     * convert iov to java byte array
-     */   
-    {
-        int iovi;
-        jbyte *bytes;
-        int outbufLen;
-
-        for( iovi = 0, outbufLen = 0; iovi < iov_size; ++iovi) {
-            outbufLen += iov[iovi].iov_len;
-        }
-        PR_ASSERT(outbufLen >= 0);
-        outbufArray = (*env)->NewByteArray(env, outbufLen);
-        if( outbufArray == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-        bytes = (*env)->GetByteArrayElements(env, outbufArray, NULL);
-        if( bytes == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-        for( iovi = 0, outbufLen = 0; iovi < iov_size; ++iovi) {
-            memcpy(bytes+outbufLen,iov[iovi].iov_base, iov[iovi].iov_len);
-            outbufLen += iov[iovi].iov_len;
-        }
-        PR_ASSERT(outbufLen == (*env)->GetArrayLength(env, outbufArray));
-        (*env)->ReleaseByteArrayElements(env, outbufArray, bytes, 0);
-    }
-
     /*
      * Write bytes
      */
-    retval = writebuf(env, fd, sockObj, outbufArray);
+    retval = writebuf(env, fd, iov, iov_size);
 
 finish:
     /* nothing to free, nothing to return */
@@ -414,8 +403,8 @@ jsock_send(PRFileDesc *fd, const void *buf, PRInt32 amount,
 {
     JNIEnv *env;
     jobject sockObj;
-    jbyteArray byteArray;
-    PRInt32 retval = -1;;
+    PRIOVec iov;
+    PRInt32 retval = -1;
 
     if( GET_ENV(fd->secret->javaVM, env) ) goto finish;
 
@@ -427,30 +416,9 @@ jsock_send(PRFileDesc *fd, const void *buf, PRInt32 amount,
 
     if( processTimeout(env, fd, sockObj, timeout) != PR_SUCCESS ) goto finish;
 
-    /*
-     * Turn buf into byte array
-     */
-    {
-        jbyte *bytes;
-
-        byteArray = (*env)->NewByteArray(env, amount);
-        if( byteArray == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        bytes = (*env)->GetByteArrayElements(env, byteArray, NULL);
-        if( bytes == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        memcpy(bytes, buf, amount);
-
-        (*env)->ReleaseByteArrayElements(env, byteArray, bytes, 0);
-    }
-
-    retval = writebuf(env, fd, sockObj, byteArray);
+    iov.iov_base = (char*) buf;
+    iov.iov_len = amount;
+    retval = writebuf(env, fd, &iov, 1);
 
 finish:
     if( env != NULL ) {
@@ -488,93 +456,48 @@ jsock_recv(PRFileDesc *fd, void *buf, PRInt32 amount,
 
     if( processTimeout(env, fd, sockObj, timeout) != PR_SUCCESS ) goto finish;
 
-    /*
-     * get InputStream
-     */
-    {
-        jclass sockClass = (*env)->GetObjectClass(env, sockObj);
-        jmethodID getInputStreamMethod;
-
-        if( sockClass == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        getInputStreamMethod = (*env)->GetMethodID(env, sockClass,
-            SOCKET_GET_INPUT_STREAM_NAME, SOCKET_GET_INPUT_STREAM_SIG);
-        if( getInputStreamMethod == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        inputStream = (*env)->CallObjectMethod(env, sockObj,
-            getInputStreamMethod);
-        if( inputStream == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
+    inputStream = getStream(env, fd->secret, &fd->secret->inputStream,
+        JSS_METHOD(Socket, getInputStream));
+    if( inputStream == NULL ) {
+        goto finish;
     }
 
-    /* create new, empty byte array */
-    byteArray = (*env)->NewByteArray(env, amount);
+    byteArray = getTransferBuffer(env, &fd->secret->readBuffer, amount);
     if( byteArray == NULL ) {
-        ASSERT_OUTOFMEM(env);
         goto finish;
     }
 
     /*
      * call read()
      */
-    {
-        jclass isClass = (*env)->GetObjectClass(env, inputStream);
-        jmethodID readMethod;
-
-        if( isClass == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-        readMethod = (*env)->GetMethodID(env, isClass,
-            ISTREAM_READ_NAME, ISTREAM_READ_SIG);
-        if( readMethod == NULL ) {
-            ASSERT_OUTOFMEM(env);
-            goto finish;
-        }
-
-        retval = (*env)->CallIntMethod(env, inputStream, readMethod, byteArray);
+    retval = (*env)->CallIntMethod(env, inputStream,
+        JSS_METHOD(InputStream, read), byteArray, 0, amount);
 
-        if( (*env)->ExceptionOccurred(env) ) {
-            goto finish;
-        } else if( retval == -1 ) {
-            /* Java EOF == -1, NSPR EOF == 0 */
-            retval = 0;
-        } else if( retval == 0 ) {
-            /* timeout */
-            PR_ASSERT( fd->secret->timeout != PR_INTERVAL_NO_TIMEOUT );
-            PR_SetError(PR_IO_TIMEOUT_ERROR, 0);
-            retval = -1;
-        }
-        PR_ASSERT(retval <= amount);
+    if( (*env)->ExceptionOccurred(env) ) {
+        goto finish;
+    } else if( retval == -1 ) {
+        /* Java EOF == -1, NSPR EOF == 0 */
+        retval = 0;
+    } else if( retval == 0 ) {
+        /* timeout */
+        PR_ASSERT( fd->secret->timeout != PR_INTERVAL_NO_TIMEOUT );
+        PR_SetError(PR_IO_TIMEOUT_ERROR, 0);
+        retval = -1;
     }
-
+    PR_ASSERT(retval <= amount);
 
     /*
      * copy byte array to buf
      */
     if( retval > 0 ) {
-        jbyte *bytes;
-
-        bytes = (*env)->GetByteArrayElements(env, byteArray, NULL);
-
-        memcpy(buf, bytes, retval);
-
-        (*env)->ReleaseByteArrayElements(env, byteArray, bytes, JNI_ABORT);
+        (*env)->GetByteArrayRegion(env, byteArray, 0, retval, (jbyte*) buf);
     }
 
 finish:
     if( env ) {
         jthrowable excep = (*env)->ExceptionOccurred(env);
         if( excep != NULL ) {
-            setException(env, fd->secret, excep);
+            setException(env, fd->secret, (*env)->NewGlobalRef(env, excep));
             (*env)->ExceptionClear(env);
             retval = -1;
             PR_SetError(PR_IO_ERROR, 0);
@@ -858,6 +781,18 @@ jsock_close(PRFileDesc *fd)
      * Free the PRFilePrivate
      */
     (*env)->DeleteGlobalRef(env, fd->secret->sockGlobalRef);
+    if( fd->secret->inputStream != NULL ) {
+        (*env)->DeleteGlobalRef(env, fd->secret->inputStream);
+    }
+    if( fd->secret->outputStream != NULL ) {
+        (*env)->DeleteGlobalRef(env, fd->secret->outputStream);
+    }
+    if( fd->secret->readBuffer != NULL ) {
+        (*env)->DeleteGlobalRef(env, fd->secret->readBuffer);
+    }
+    if( fd->secret->writeBuffer != NULL ) {
+        (*env)->DeleteGlobalRef(env, fd->secret->writeBuffer);
+    }
     if( (excep = JSS_SSL_getException(fd->secret)) != NULL ) {
         (*env)->DeleteGlobalRef(env, excep);
     }
@@ -995,6 +930,10 @@ JSS_SSL_javasockToPRFD(JNIEnv *env, jobject sockObj)
         fd->secret = PR_NEW(PRFilePrivate);
         fd->secret->sockGlobalRef = (*env)->NewGlobalRef(env, sockObj);
         fd->secret->javaVM = vm;
+        fd->secret->inputStream = NULL;
+        fd->secret->outputStream = NULL;
+        fd->secret->readBuffer = NULL;
+        fd->secret->writeBuffer = NULL;
         fd->secret->exception = NULL;
         fd->secret->timeout = PR_INTERVAL_NO_TIMEOUT;
         fd->lower = fd->higher = NULL;
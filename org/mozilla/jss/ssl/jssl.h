@@ -20,6 +20,11 @@ struct JSSL_SocketData {
     PRThread *writer;
     PRThread *accepter;
     PRBool closePending;
+    char *readBuf;         /* optional plaintext buffer, owned by reader */
+    PRInt32 readBufSize;
+    PRInt32 readBufStart;
+    PRInt32 readBufLen;
+    PRBool alertListeners; /* whether to fire SSLAlertEvents */
 };
 typedef struct JSSL_SocketData JSSL_SocketData;
 
@@ -77,9 +82,13 @@ JSSL_GetClientAuthData( void * arg,
 
 #endif
 
-#define JSSL_getSockData(env, sockObject, sdptr) \
-    JSS_getPtrFromProxyOwner(env, sockObject, SSLSOCKET_PROXY_FIELD, \
-        SSLSOCKET_PROXY_SIG, (void**)sdptr)
+/*
+ * Extracts the JSSL_SocketData from the SocketProxy held by an SSLSocket,
+ * SSLServerSocket, SocketBase, or JSSEngine.
+ * Returns PR_FAILURE, with an exception thrown, if it cannot.
+ */
+PRStatus
+JSSL_getSockData(JNIEnv *env, jobject sockObject, JSSL_SocketData **sdptr);
 
 
 void
@@ -120,4 +129,7 @@ JSS_SSL_processExceptions(JNIEnv *env, PRFilePrivate *priv);
 
 void JSSL_throwSSLSocketException(JNIEnv *env, char *message);
 
+void
+JSSL_ConfigSecureServer(JNIEnv *env, JSSL_SocketData *sock, jobject certObj);
+
 #endif
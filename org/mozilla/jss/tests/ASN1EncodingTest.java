@@ -0,0 +1,362 @@
+package org.mozilla.jss.tests;
+
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.Date;
+import java.util.List;
+import java.util.Random;
+
+import org.mozilla.jss.asn1.*;
+import org.mozilla.jss.pkcs7.ContentInfo;
+import org.mozilla.jss.pkcs7.SignedData;
+import org.mozilla.jss.pkix.cert.Certificate;
+import org.mozilla.jss.pkix.cert.CertificateInfo;
+import org.mozilla.jss.pkix.primitive.AlgorithmIdentifier;
+import org.mozilla.jss.pkix.primitive.Name;
+import org.mozilla.jss.pkix.primitive.SubjectPublicKeyInfo;
+
+public class ASN1EncodingTest {
+    public static void assert_f(boolean expr, String location) {
+        if (!expr) {
+            System.err.println("Assertion: " + location);
+            throw new AssertionError(location);
+        }
+    }
+
+    public static void checkLength(ASN1Value value, String location)
+        throws Exception
+    {
+        byte[] encoded = ASN1Util.encode(value);
+        long length = value.getEncodedLength();
+        assert_f(length == encoded.length, location + ": getEncodedLength=" +
+                 length + ", encoded " + encoded.length + " bytes");
+    }
+
+    public static void testPrimitives() throws Exception {
+        checkLength(new INTEGER(0), "INTEGER 0");
+        checkLength(new INTEGER(-129), "INTEGER -129");
+        checkLength(new BOOLEAN(true), "BOOLEAN");
+        checkLength(new NULL(), "NULL");
+        checkLength(new OBJECT_IDENTIFIER("1.2.840.113549.1.1.11"), "OID");
+        checkLength(new OCTET_STRING(new byte[200]), "OCTET STRING 200");
+        checkLength(new OCTET_STRING(new byte[70000]), "OCTET STRING 70000");
+        checkLength(new PrintableString("jss"), "PrintableString");
+        checkLength(new UTCTime(new Date()), "UTCTime");
+        checkLength(new GeneralizedTime(new Date()), "GeneralizedTime");
+        checkLength(new BIT_STRING(new byte[] {1, 2, 3}, 0), "BIT STRING");
+    }
+
+    public static void testHeaderLengths() throws Exception {
+        long[] tagNums = {0, 30, 31, 127, 128, 16383, 16384};
+        long[] contentLengths = {0, 127, 128, 255, 256, 65535, 65536};
+
+        for (long tagNum : tagNums) {
+            for (long contentLength : contentLengths) {
+                Tag tag = new Tag(Tag.Class.CONTEXT_SPECIFIC, tagNum);
+                ASN1Header head = new ASN1Header(tag, Form.PRIMITIVE,
+                    contentLength);
+                assert_f(ASN1Header.getEncodedLength(tag, contentLength) ==
+                         head.encode().length,
+                         "header tag=" + tagNum + " length=" + contentLength);
+            }
+        }
+    }
+
+    public static void testNested() throws Exception {
+        // a CRL-like list of entries, each wrapped a few levels deep
+        SEQUENCE entries = new SEQUENCE();
+        for (int i = 0; i < 1000; i++) {
+            SEQUENCE entry = new SEQUENCE();
+            entry.addElement(new INTEGER(i * 7919L));
+            entry.addElement(new UTCTime(new Date()));
+            SEQUENCE ext = new SEQUENCE();
+            ext.addElement(new OBJECT_IDENTIFIER("2.5.29.21"));
+            ext.addElement(new OCTET_STRING(new byte[] {0x0a, 0x01, 0x01}));
+            entry.addElement(new EXPLICIT(new Tag(0), ext));
+            entry.addElement(new Tag(1), new OCTET_STRING(new byte[i % 40]));
+            entries.addElement(entry);
+        }
+        SEQUENCE outer = new SEQUENCE();
+        outer.addElement(new INTEGER(1));
+        outer.addElement(new EXPLICIT(new Tag(40), entries));
+        outer.addElement(null);
+
+        checkLength(entries, "entries");
+        checkLength(outer, "outer");
+
+        SET set = new SET();
+        set.addElement(outer);
+        set.addElement(new INTEGER(5));
+        checkLength(set, "SET");
+    }
+
+    public static void testStreamedEncoding() throws Exception {
+        SEQUENCE seq = new SEQUENCE();
+        seq.addElement(new INTEGER(5));
+        seq.addElement(new EXPLICIT(new Tag(2), new BOOLEAN(true)));
+        seq.addElement(new Tag(3), new OCTET_STRING(new byte[] {1, 2}));
+
+        byte[] expected = {0x30, 0x0c,
+                           0x02, 0x01, 0x05,
+                           (byte) 0xa2, 0x03, 0x01, 0x01, (byte) 0xff,
+                           (byte) 0x83, 0x02, 0x01, 0x02};
+        byte[] actual = ASN1Util.encode(seq);
+        assert_f(Arrays.equals(actual, expected), "streamed SEQUENCE");
+    }
+
+    // Encodes as its content and counts how often it is encoded. Like the
+    // pkix types, it only learns its length by encoding itself.
+    public static class CountingValue implements ASN1Value {
+        private final ASN1Value content;
+        public int encodes = 0;
+
+        public CountingValue(ASN1Value content) {
+            this.content = content;
+        }
+
+        public Tag getTag() {
+            return content.getTag();
+        }
+
+        public void encode(OutputStream ostream) throws IOException {
+            encode(getTag(), ostream);
+        }
+
+        public void encode(Tag implicitTag, OutputStream ostream)
+            throws IOException
+        {
+            encodes++;
+            content.encode(implicitTag, ostream);
+        }
+    }
+
+    public static Certificate makeCertificate() throws Exception {
+        AlgorithmIdentifier sigAlg = new AlgorithmIdentifier(
+            new OBJECT_IDENTIFIER("1.2.840.113549.1.1.11"), new NULL());
+        Name issuer = new Name();
+        issuer.addCountryName("US");
+        issuer.addOrganizationName("Mozilla");
+        issuer.addCommonName("ASN1EncodingTest CA");
+        Name subject = new Name();
+        subject.addCommonName("ASN1EncodingTest");
+        SubjectPublicKeyInfo spki = new SubjectPublicKeyInfo(
+            new AlgorithmIdentifier(
+                new OBJECT_IDENTIFIER("1.2.840.113549.1.1.1"), new NULL()),
+            new BIT_STRING(new byte[140], 0));
+        Date notBefore = new Date(1600000000000L);
+        Date notAfter = new Date(1700000000000L);
+        CertificateInfo info = new CertificateInfo(CertificateInfo.v3,
+            new INTEGER(1001), sigAlg, issuer, notBefore, notAfter, subject,
+            spki);
+
+        // Certificate can only be signed with a token key, so decode one
+        SEQUENCE seq = new SEQUENCE();
+        seq.addElement(info);
+        seq.addElement(sigAlg);
+        seq.addElement(new BIT_STRING(new byte[256], 0));
+        byte[] encoded = ASN1Util.encode(seq);
+        Certificate cert = (Certificate)
+            ASN1Util.decode(Certificate.getTemplate(), encoded);
+        assert_f(Arrays.equals(ASN1Util.encode(cert), encoded),
+                 "Certificate round trip");
+        return cert;
+    }
+
+    public static void testNestedPkix() throws Exception {
+        // SignedData inside ContentInfo inside SignedData..., each level
+        // carrying a Certificate. These types build a SEQUENCE when they
+        // are encoded, so their length is found by encoding them.
+        final int DEPTH = 10;
+        Certificate cert = makeCertificate();
+        byte[] certEncoding = ASN1Util.encode(cert);
+        byte[] data = "nested content".getBytes("UTF-8");
+        CountingValue leaf = new CountingValue(new OCTET_STRING(data));
+
+        SET digestAlgs = new SET();
+        digestAlgs.addElement(new AlgorithmIdentifier(
+            new OBJECT_IDENTIFIER("2.16.840.1.101.3.4.2.1"), new NULL()));
+        ContentInfo ci = new ContentInfo(ContentInfo.DATA, leaf);
+        for (int i = 0; i < DEPTH; i++) {
+            SET certs = new SET();
+            certs.addElement(cert);
+            ci = new ContentInfo(new SignedData(digestAlgs, ci, certs, null,
+                                                null));
+        }
+
+        // the constructors encode their content; count only from here
+        leaf.encodes = 0;
+        byte[] encoded = ASN1Util.encode(ci);
+
+        // Each enclosing SignedData and ContentInfo measures the leaf once
+        // by encoding it, plus the leaf's own measurement and the final
+        // write. Measuring again at every level would take 2^(2*DEPTH).
+        assert_f(leaf.encodes <= 2 * DEPTH + 2,
+                 "nested pkix encoded the leaf " + leaf.encodes + " times");
+        checkLength(ci, "nested pkix");
+
+        ContentInfo decoded = (ContentInfo)
+            ASN1Util.decode(ContentInfo.getTemplate(), encoded);
+        assert_f(Arrays.equals(ASN1Util.encode(decoded), encoded),
+                 "nested pkix round trip");
+        for (int i = 0; i < DEPTH; i++) {
+            SignedData sd = (SignedData) decoded.getInterpretedContent();
+            SET certs = sd.getCertificates();
+            assert_f(certs.size() == 1, "certificates at level " + i);
+            assert_f(Arrays.equals(ASN1Util.encode(certs.elementAt(0)),
+                     certEncoding), "certificate at level " + i);
+            decoded = sd.getContentInfo();
+        }
+        OCTET_STRING content = (OCTET_STRING) decoded.getInterpretedContent();
+        assert_f(Arrays.equals(content.toByteArray(), data),
+                 "nested pkix content");
+    }
+
+    public static void testSetOfOrdering() throws Exception {
+        Random random = new Random(22);
+        SET set = new SET();
+        List<byte[]> expected = new ArrayList<>();
+        for (int i = 0; i < 20000; i++) {
+            byte[] data = new byte[random.nextInt(200)];
+            random.nextBytes(data);
+            set.addElement(new OCTET_STRING(data));
+            expected.add(ASN1Util.encode(new OCTET_STRING(data)));
+        }
+        set.addElement(null);
+
+        Collections.sort(expected, new Comparator<byte[]>() {
+            public int compare(byte[] left, byte[] right) {
+                int min = Math.min(left.length, right.length);
+                for (int i = 0; i < min; i++) {
+                    int diff = (left[i] & 0xff) - (right[i] & 0xff);
+                    if (diff != 0) {
+                        return diff;
+                    }
+                }
+                return left.length - right.length;
+            }
+        });
+
+        byte[] actual = ASN1Util.encode(set);
+        int offset = actual.length;
+        for (byte[] enc : expected) {
+            offset -= enc.length;
+        }
+        for (byte[] enc : expected) {
+            assert_f(Arrays.equals(enc, Arrays.copyOfRange(actual, offset,
+                     offset + enc.length)), "SET OF order at " + offset);
+            offset += enc.length;
+        }
+        assert_f(offset == actual.length, "SET OF length");
+    }
+
+    public static void testSetEncodesOnce() throws Exception {
+        SET set = new SET();
+        CountingValue[] values = new CountingValue[100];
+        for (int i = 0; i < values.length; i++) {
+            values[i] = new CountingValue(new INTEGER(values.length - i));
+            set.addElement(values[i]);
+        }
+        ASN1Util.encode(set);
+        for (int i = 0; i < values.length; i++) {
+            assert_f(values[i].encodes == 1, "SET element " + i +
+                     " encoded " + values[i].encodes + " times");
+        }
+    }
+
+    public static void testSetTagOrdering() throws Exception {
+        SET set = new SET();
+        set.addElement(new Tag(3), new INTEGER(3));
+        set.addElement(new INTEGER(2));
+        set.addElement(new Tag(40), new NULL());
+        set.addElement(new BOOLEAN(true));
+
+        byte[] expected = {0x31, 0x0c,
+                           0x01, 0x01, (byte) 0xff,
+                           0x02, 0x01, 0x02,
+                           (byte) 0x83, 0x01, 0x03,
+                           (byte) 0x9f, 0x28, 0x00};
+        byte[] actual = ASN1Util.encode(set);
+        assert_f(Arrays.equals(actual, expected), "SET tag order");
+    }
+
+    public static void testSetTagOrderingWithNull() throws Exception {
+        // Two 16-byte encodings fill the 32-byte initial buffer exactly,
+        // and the null entry leaves the last offset unused.
+        SET set = new SET();
+        set.addElement(new Tag(1), new OCTET_STRING(new byte[14]));
+        set.addElement(null);
+        set.addElement(new OCTET_STRING(new byte[14]));
+
+        byte[] actual = ASN1Util.encode(set);
+        assert_f(actual.length == 34, "SET with null length");
+        assert_f(actual[2] == 0x04 && actual[18] == (byte) 0x81,
+                 "SET with null tag order");
+    }
+
+    public static void testSliceDecoding() throws Exception {
+        byte[] octets = {1, 2, 3, 4, 5};
+        byte[] bits = {(byte) 0xf0, 0x0f};
+        SEQUENCE seq = new SEQUENCE();
+        seq.addElement(new OCTET_STRING(octets));
+        seq.addElement(new BIT_STRING(bits, 0));
+        seq.addElement(new INTEGER(77));
+        seq.addElement(new EXPLICIT(new Tag(0), new OCTET_STRING(octets)));
+        byte[] encoded = ASN1Util.encode(seq);
+
+        // surround the encoding with other data
+        byte[] source = new byte[encoded.length + 10];
+        System.arraycopy(encoded, 0, source, 3, encoded.length);
+        ByteBuffer buffer = ByteBuffer.wrap(source, 3, encoded.length + 2);
+
+        SEQUENCE.Template template = new SEQUENCE.Template();
+        template.addElement(OCTET_STRING.getTemplate());
+        template.addElement(BIT_STRING.getTemplate());
+        template.addElement(ANY.getTemplate());
+        template.addElement(new EXPLICIT.Template(new Tag(0),
+            OCTET_STRING.getTemplate()));
+        SEQUENCE decoded = (SEQUENCE) ASN1Util.decode(template, buffer);
+
+        assert_f(buffer.position() == 3 + encoded.length, "buffer position");
+        assert_f(buffer.remaining() == 2, "buffer remaining");
+        assert_f(Arrays.equals(ASN1Util.encode(decoded), encoded),
+                 "re-encoded slice");
+
+        OCTET_STRING os = (OCTET_STRING) decoded.elementAt(0);
+        BIT_STRING bs = (BIT_STRING) decoded.elementAt(1);
+        ANY any = (ANY) decoded.elementAt(2);
+        OCTET_STRING inner = (OCTET_STRING)
+            ((EXPLICIT) decoded.elementAt(3)).getContent();
+        assert_f(os.toByteBuffer().equals(ByteBuffer.wrap(octets)),
+                 "OCTET STRING view");
+        assert_f(bs.toByteBuffer().equals(ByteBuffer.wrap(bits)),
+                 "BIT STRING view");
+        assert_f(((INTEGER) any.decodeWith(INTEGER.getTemplate()))
+                 .intValue() == 77, "ANY view");
+        assert_f(Arrays.equals(inner.toByteArray(), octets), "EXPLICIT view");
+
+        // the views refer to the source array, not copies of it
+        // after the SEQUENCE and OCTET STRING headers
+        int first = 3 + 2 + 2;
+        assert_f(source[first] == 1, "OCTET STRING offset");
+        source[first] = 9;
+        assert_f(os.toByteBuffer().get(0) == 9, "OCTET STRING is a view");
+    }
+
+    public static void main(String[] args) throws Exception {
+        testPrimitives();
+        testHeaderLengths();
+        testNested();
+        testStreamedEncoding();
+        testNestedPkix();
+        testSetOfOrdering();
+        testSetEncodesOnce();
+        testSetTagOrdering();
+        testSetTagOrderingWithNull();
+        testSliceDecoding();
+    }
+}
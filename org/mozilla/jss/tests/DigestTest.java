@@ -4,11 +4,16 @@
 package org.mozilla.jss.tests;
 
 import java.io.FileInputStream;
+import java.nio.ByteBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
 import java.security.MessageDigest;
 import java.security.Provider;
 import java.security.Security;
 
 import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.crypto.DigestAlgorithm;
+import org.mozilla.jss.crypto.JSSMessageDigest;
 
 public class DigestTest {
 
@@ -24,6 +29,14 @@ public class DigestTest {
     static final String JSS_Digest_Algs[] = { "MD2", "MD5", "SHA-1",
                                             "SHA-256", "SHA-384","SHA-512"};
 
+    /**
+     * The same algorithms, for the one-shot JSSMessageDigest API.
+     */
+    static final DigestAlgorithm JSS_Digest_Alg_Objs[] = {
+        DigestAlgorithm.MD2, DigestAlgorithm.MD5, DigestAlgorithm.SHA1,
+        DigestAlgorithm.SHA256, DigestAlgorithm.SHA384,
+        DigestAlgorithm.SHA512};
+
     public static boolean messageDigestCompare(String alg, byte[] toBeDigested)
     throws Exception {
         byte[] otherDigestOut;
@@ -89,6 +102,90 @@ public class DigestTest {
         return true;
     }
 
+    /**
+     * Checks that single-byte and small updates, which JSS gathers before
+     * passing them to NSS, and a memory-mapped (direct) buffer, which JSS
+     * digests in place, all give the same result as one large update.
+     */
+    public static void testUpdatePaths(String alg, byte[] toBeDigested,
+            String file) throws Exception {
+        MessageDigest md = MessageDigest.getInstance(alg, MOZ_PROVIDER_NAME);
+        byte[] expected = md.digest(toBeDigested);
+
+        for (byte b : toBeDigested) {
+            md.update(b);
+        }
+        if (!MessageDigest.isEqual(expected, md.digest())) {
+            throw new Exception("ERROR: single-byte " + alg +
+                                " updates give a different digest");
+        }
+
+        for (int off = 0; off < toBeDigested.length; off += 7) {
+            md.update(toBeDigested, off,
+                      Math.min(7, toBeDigested.length - off));
+        }
+        if (!MessageDigest.isEqual(expected, md.digest())) {
+            throw new Exception("ERROR: small " + alg +
+                                " updates give a different digest");
+        }
+
+        try (FileInputStream fis = new FileInputStream(file);
+             FileChannel channel = fis.getChannel()) {
+            MappedByteBuffer mapped = channel.map(
+                    FileChannel.MapMode.READ_ONLY, 0, toBeDigested.length);
+            md.update(mapped);
+        }
+        if (!MessageDigest.isEqual(expected, md.digest())) {
+            throw new Exception("ERROR: memory-mapped " + alg +
+                                " update gives a different digest");
+        }
+        System.out.println(alg + " update paths give the same digest");
+    }
+
+    /**
+     * Checks that a cloned digest continues from the state it was
+     * cloned in, independently of the original.
+     */
+    public static void testClone(String alg, byte[] toBeDigested)
+            throws Exception {
+        MessageDigest md = MessageDigest.getInstance(alg, MOZ_PROVIDER_NAME);
+        byte[] expected = md.digest(toBeDigested);
+
+        int half = toBeDigested.length / 2;
+        md.update(toBeDigested, 0, half);
+        MessageDigest copy = (MessageDigest) md.clone();
+        md.update(toBeDigested, half, toBeDigested.length - half);
+        copy.update(toBeDigested, half, toBeDigested.length - half);
+        if (!MessageDigest.isEqual(expected, md.digest()) ||
+            !MessageDigest.isEqual(expected, copy.digest())) {
+            throw new Exception("ERROR: cloned " + alg +
+                                " gives a different digest");
+        }
+        System.out.println(alg + " clone matches");
+    }
+
+    /**
+     * Checks the one-shot digest against the streaming one.
+     */
+    public static void testOneShot(String alg, DigestAlgorithm jssAlg,
+            byte[] toBeDigested) throws Exception {
+        MessageDigest md = MessageDigest.getInstance(alg, MOZ_PROVIDER_NAME);
+        byte[] expected = md.digest(toBeDigested);
+
+        if (!MessageDigest.isEqual(expected,
+                JSSMessageDigest.digest(jssAlg, toBeDigested))) {
+            throw new Exception("ERROR: one-shot " + alg +
+                                " gives a different digest");
+        }
+        ByteBuffer direct = ByteBuffer.allocateDirect(toBeDigested.length);
+        direct.put(toBeDigested).flip();
+        if (!MessageDigest.isEqual(expected,
+                JSSMessageDigest.digest(jssAlg, direct))) {
+            throw new Exception("ERROR: one-shot " + alg +
+                                " of a direct buffer gives a different digest");
+        }
+        System.out.println(alg + " one-shot digest matches");
+    }
 
     public static void main(String []argv) {
 
@@ -127,6 +224,10 @@ public class DigestTest {
                     // no provider to compare results with
                     testJSSDigest(JSS_Digest_Algs[i], toBeDigested);
                 }
+                testUpdatePaths(JSS_Digest_Algs[i], toBeDigested, argv[1]);
+                testOneShot(JSS_Digest_Algs[i], JSS_Digest_Alg_Objs[i],
+                            toBeDigested);
+                testClone(JSS_Digest_Algs[i], toBeDigested);
             }
 
             //HMAC examples in org.mozilla.jss.tests.HMACTest
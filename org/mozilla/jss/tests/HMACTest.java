@@ -10,6 +10,8 @@ import java.security.Provider;
 import javax.crypto.*;
 import javax.crypto.spec.*;
 import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.crypto.HMACAlgorithm;
+import org.mozilla.jss.crypto.JSSMessageDigest;
 import org.mozilla.jss.crypto.SecretKeyFacade;
 import org.mozilla.jss.util.PasswordCallback;
 
@@ -33,6 +35,12 @@ public class HMACTest {
     static final String JSS_HMAC_Algs[] = {"HmacSHA1", "HmacSHA256",
         "HmacSHA384", "HmacSHA512"
     };
+    /**
+     * The same algorithms, for the one-shot JSSMessageDigest API.
+     */
+    static final HMACAlgorithm JSS_HMAC_Alg_Objs[] = {HMACAlgorithm.SHA1,
+        HMACAlgorithm.SHA256, HMACAlgorithm.SHA384, HMACAlgorithm.SHA512
+    };
 
     public HMACTest(String[] argv) throws Exception {
         if (argv.length < 1) {
@@ -116,6 +124,41 @@ public class HMACTest {
         }
     }
 
+    /**
+     * Checks the one-shot HMAC against the Mac interface.
+     */
+    public void oneShotHMAC(String alg, HMACAlgorithm jssAlg,
+            SecretKeyFacade sk, String clearText) throws Exception {
+        Mac mozillaHmac = Mac.getInstance(alg, MOZ_PROVIDER_NAME);
+        mozillaHmac.init(sk);
+        byte[] expected = mozillaHmac.doFinal(clearText.getBytes());
+
+        byte[] oneShot = JSSMessageDigest.hmac(sk.key, jssAlg,
+                clearText.getBytes());
+        if (!MessageDigest.isEqual(expected, oneShot)) {
+            throw new Exception("ERROR: one-shot " + alg +
+                    " differs from " + MOZ_PROVIDER_NAME + " Mac");
+        }
+
+        // a keyed Mac cloned per message, as a server would
+        Mac keyed = Mac.getInstance(alg, MOZ_PROVIDER_NAME);
+        keyed.init(sk);
+        Mac perMessage;
+        try {
+            perMessage = (Mac) keyed.clone();
+        } catch (CloneNotSupportedException e) {
+            System.out.println(alg + " contexts cannot be cloned here");
+            return;
+        }
+        if (!MessageDigest.isEqual(expected,
+                perMessage.doFinal(clearText.getBytes())) ||
+            !MessageDigest.isEqual(expected,
+                keyed.doFinal(clearText.getBytes()))) {
+            throw new Exception("ERROR: cloned " + alg +
+                    " differs from " + MOZ_PROVIDER_NAME + " Mac");
+        }
+    }
+
     public boolean fipsMode() {
         return cm.FIPSEnabled();
     }
@@ -164,6 +207,8 @@ public class HMACTest {
                     //https://bugzilla.mozilla.org/show_bug.cgi?id=436907
                     if (!JSS_HMAC_Algs[i].equals("HmacSHA512")) {
                         hmacTest.doHMAC(JSS_HMAC_Algs[i], sk, clearText);
+                        hmacTest.oneShotHMAC(JSS_HMAC_Algs[i],
+                                JSS_HMAC_Alg_Objs[i], sk, clearText);
                     }
                 } else {
                     // compare MOZ_PROVIDER_NAME implementation with all
@@ -173,6 +218,8 @@ public class HMACTest {
                         // no provider to compare results with so just test JSS
                         hmacTest.doHMAC(JSS_HMAC_Algs[i], sk, clearText);
                     }
+                    hmacTest.oneShotHMAC(JSS_HMAC_Algs[i],
+                            JSS_HMAC_Alg_Objs[i], sk, clearText);
                 }
             }
 
@@ -5,6 +5,7 @@
 package org.mozilla.jss.tests;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import java.security.AlgorithmParameters;
 import java.security.GeneralSecurityException;
 import java.security.InvalidKeyException;
@@ -14,11 +15,13 @@ import java.security.Provider;
 import java.security.SecureRandom;
 import java.security.Security;
 import java.security.spec.AlgorithmParameterSpec;
+import java.util.Arrays;
 
 import javax.crypto.Cipher;
 import javax.crypto.KeyGenerator;
 import javax.crypto.SecretKey;
 import javax.crypto.SecretKeyFactory;
+import javax.crypto.ShortBufferException;
 import javax.crypto.spec.PBEKeySpec;
 import javax.crypto.spec.RC2ParameterSpec;
 
@@ -392,6 +395,97 @@ public class JCASymKeyGen {
         }
     }
 
+    /**
+     * Encrypts and decrypts through direct ByteBuffers, which the
+     * Mozilla provider processes in place.
+     */
+    public void testByteBufferCipher(javax.crypto.SecretKey sKey,
+            String algType) throws Exception {
+        if (algType.startsWith("RC2")) {
+            // needs explicit parameters; covered by testCipher
+            return;
+        }
+        byte[] plaintext = plainText;
+        if (algType.endsWith("PKCS5Padding")) {
+            plaintext = plainTextPad;
+        }
+
+        Cipher cipher = Cipher.getInstance(algType, MOZ_PROVIDER_NAME);
+        cipher.init(Cipher.ENCRYPT_MODE, sKey);
+        AlgorithmParameters ap = cipher.getParameters();
+
+        ByteBuffer in = ByteBuffer.allocateDirect(plaintext.length);
+        in.put(plaintext).flip();
+        ByteBuffer ciphertext = ByteBuffer.allocateDirect(
+                cipher.getOutputSize(plaintext.length));
+        cipher.doFinal(in, ciphertext);
+        ciphertext.flip();
+
+        cipher = Cipher.getInstance(algType, MOZ_PROVIDER_NAME);
+        if (ap == null) {
+            cipher.init(Cipher.DECRYPT_MODE, sKey);
+        } else {
+            cipher.init(Cipher.DECRYPT_MODE, sKey, ap);
+        }
+        ByteBuffer recovered = ByteBuffer.allocateDirect(
+                cipher.getOutputSize(ciphertext.remaining()));
+        cipher.doFinal(ciphertext, recovered);
+        recovered.flip();
+
+        byte[] result = new byte[recovered.remaining()];
+        recovered.get(result);
+        if (!Arrays.equals(plaintext, result)) {
+            throw new Exception("ERROR: direct ByteBuffer round trip failed "
+                    + "for " + algType);
+        }
+    }
+
+    /**
+     * Runs a padded multipart encryption whose final call has to emit
+     * the held-back partial block plus a whole padding block, first into
+     * an output buffer one byte past the input block and then into one
+     * sized exactly.
+     */
+    public void testTightOutputBuffer(javax.crypto.SecretKey sKey,
+            String algType) throws Exception {
+        if (!algType.endsWith("PKCS5Padding") || algType.startsWith("RC2")) {
+            return;
+        }
+
+        Cipher cipher = Cipher.getInstance(algType, MOZ_PROVIDER_NAME);
+        cipher.init(Cipher.ENCRYPT_MODE, sKey);
+        AlgorithmParameters ap = cipher.getParameters();
+        int blockSize = cipher.getBlockSize();
+        byte[] input = Arrays.copyOf(plainTextPad, blockSize);
+
+        // blockSize - 1 bytes are held back, then the last byte and a
+        // padding block make the final output two blocks long
+        byte[] output = new byte[blockSize + 1];
+        int written = cipher.update(input, 0, blockSize - 1, output, 0);
+        try {
+            cipher.doFinal(input, blockSize - 1, 1, output, written);
+            throw new Exception("ERROR: doFinal into " + output.length +
+                    " bytes did not throw ShortBufferException for " +
+                    algType);
+        } catch (ShortBufferException e) {
+            // expected
+        }
+
+        Cipher oneShot = Cipher.getInstance(algType, MOZ_PROVIDER_NAME);
+        oneShot.init(Cipher.ENCRYPT_MODE, sKey, ap);
+        byte[] expected = oneShot.doFinal(input);
+
+        cipher = Cipher.getInstance(algType, MOZ_PROVIDER_NAME);
+        cipher.init(Cipher.ENCRYPT_MODE, sKey, ap);
+        output = new byte[expected.length];
+        written = cipher.update(input, 0, blockSize - 1, output, 0);
+        written += cipher.doFinal(input, blockSize - 1, 1, output, written);
+        if (written != expected.length || !Arrays.equals(output, expected)) {
+            throw new Exception("ERROR: multipart encryption into an " +
+                    "exactly sized buffer failed for " + algType);
+        }
+    }
+
     public static void main(String args[]) {
 
         String certDbLoc             = ".";
@@ -478,6 +572,8 @@ public class JCASymKeyGen {
                     skg.testMultiPartCipher(mozKey, symKeyTable[i][0],
                         symKeyTable[i][a],
                         MOZ_PROVIDER_NAME, MOZ_PROVIDER_NAME);
+                    skg.testByteBufferCipher(mozKey, symKeyTable[i][a]);
+                    skg.testTightOutputBuffer(mozKey, symKeyTable[i][a]);
 
                     try {
                         //check to see if the otherProvider we are testing
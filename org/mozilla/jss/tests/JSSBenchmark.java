@@ -0,0 +1,626 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+package org.mozilla.jss.tests;
+
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.io.RandomAccessFile;
+import java.math.BigInteger;
+import java.nio.ByteBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.file.StandardOpenOption;
+import java.security.KeyPair;
+import java.security.MessageDigest;
+import java.security.SecureRandom;
+import java.util.ArrayList;
+import java.util.Date;
+import java.util.List;
+import java.util.concurrent.Callable;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import java.util.stream.IntStream;
+
+import javax.crypto.Mac;
+import javax.crypto.SecretKeyFactory;
+import javax.crypto.spec.IvParameterSpec;
+import javax.crypto.spec.PBEKeySpec;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.asn1.ASN1Template;
+import org.mozilla.jss.asn1.ASN1Util;
+import org.mozilla.jss.asn1.INTEGER;
+import org.mozilla.jss.asn1.OCTET_STRING;
+import org.mozilla.jss.asn1.SEQUENCE;
+import org.mozilla.jss.asn1.SET;
+import org.mozilla.jss.crypto.AeadCipher;
+import org.mozilla.jss.crypto.BatchVerifier;
+import org.mozilla.jss.crypto.BulkCipher;
+import org.mozilla.jss.crypto.Cipher;
+import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.crypto.DigestAlgorithm;
+import org.mozilla.jss.crypto.EncryptionAlgorithm;
+import org.mozilla.jss.crypto.HMACAlgorithm;
+import org.mozilla.jss.crypto.IVParameterSpec;
+import org.mozilla.jss.crypto.JSSMessageDigest;
+import org.mozilla.jss.crypto.KeyGenAlgorithm;
+import org.mozilla.jss.crypto.KeyGenerator;
+import org.mozilla.jss.crypto.KeyPairAlgorithm;
+import org.mozilla.jss.crypto.KeyPairGenerator;
+import org.mozilla.jss.crypto.PrivateKey;
+import org.mozilla.jss.crypto.SecretKeyFacade;
+import org.mozilla.jss.crypto.Signature;
+import org.mozilla.jss.crypto.SignatureAlgorithm;
+import org.mozilla.jss.crypto.SymmetricKey;
+import org.mozilla.jss.netscape.security.x509.RevokedCertImpl;
+import org.mozilla.jss.netscape.security.x509.RevokedCertificate;
+import org.mozilla.jss.netscape.security.x509.X500Name;
+import org.mozilla.jss.netscape.security.x509.X509CRLImpl;
+import org.mozilla.jss.netscape.security.x509.X509CRLWriter;
+import org.mozilla.jss.pkcs7.ContentInfo;
+import org.mozilla.jss.pkix.cert.Certificate;
+import org.mozilla.jss.ssl.SSLServerSocket;
+import org.mozilla.jss.ssl.SSLSocket;
+
+/**
+ * Times JSS operations and prints the calls per second of each. Each
+ * case runs for a warm-up period and then for the given number of
+ * milliseconds; the numbers are only comparable between runs on the
+ * same machine.
+ *
+ * <p>This is not part of the test suite. The <code>benchmark</code>
+ * make target runs it against the database the tests set up.
+ */
+public class JSSBenchmark {
+
+    interface Case {
+        void run() throws Exception;
+    }
+
+    static long millis;
+
+    static void time(String name, Case c) throws Exception {
+        long end = System.nanoTime() + millis * 250000L;
+        while (System.nanoTime() < end) {
+            c.run();
+        }
+
+        long start = System.nanoTime();
+        end = start + millis * 1000000L;
+        long now;
+        long calls = 0;
+        do {
+            c.run();
+            calls++;
+            now = System.nanoTime();
+        } while (now < end);
+
+        System.out.println(String.format("%-48s %12.0f /s", name,
+                calls * 1e9 / (now - start)));
+    }
+
+    /*
+     * Writes 16 KiB at a time over a loopback connection, while the
+     * server reads with the same kind of buffer.
+     */
+    static void sslSocket(int port) throws Exception {
+        SSLSocket.enableSSL2Default(false);
+        SSLSocket.enableSSL3Default(false);
+        SSLServerSocket.configServerSessionIDCache(10, 100, 100, null);
+
+        SSLServerSocket server = new SSLServerSocket(port, 5, null, null,
+                true);
+        server.setServerCertNickname("Server_RSA");
+        try {
+            sslThroughput(server, port, false);
+            sslThroughput(server, port, true);
+        } finally {
+            server.close();
+        }
+    }
+
+    static void sslThroughput(SSLServerSocket server, int port,
+                              boolean direct)
+        throws Exception
+    {
+        CompletableFuture<Void> drained = CompletableFuture.runAsync(() -> {
+            try (SSLSocket sock = (SSLSocket) server.accept()) {
+                drain(sock, direct);
+            } catch (IOException e) {
+                throw new RuntimeException(e);
+            }
+        });
+
+        SSLSocket sock = new SSLSocket("localhost", port);
+        sock.forceHandshake();
+        if (direct) {
+            ByteBuffer buf = ByteBuffer.allocateDirect(16384);
+            time("SSLSocket write 16 KiB, direct ByteBuffer", () -> {
+                buf.clear();
+                sock.write(buf);
+            });
+        } else {
+            byte[] buf = new byte[16384];
+            OutputStream os = sock.getOutputStream();
+            time("SSLSocket write 16 KiB, byte[]", () -> os.write(buf));
+        }
+        sock.close();
+        drained.get(60, TimeUnit.SECONDS);
+    }
+
+    static void drain(SSLSocket sock, boolean direct) throws IOException {
+        if (direct) {
+            ByteBuffer buf = ByteBuffer.allocateDirect(16384);
+            do {
+                buf.clear();
+            } while (sock.read(buf) >= 0);
+        } else {
+            byte[] buf = new byte[16384];
+            InputStream is = sock.getInputStream();
+            while (is.read(buf) >= 0) {
+                // discard
+            }
+        }
+    }
+
+    /*
+     * Hashes a 16 MiB file through a memory mapping and through a byte[],
+     * then times single-byte updates, which are gathered before they
+     * reach NSS.
+     */
+    static void mappedDigest() throws Exception {
+        File file = File.createTempFile("JSSBenchmark", ".dat");
+        file.deleteOnExit();
+        try (RandomAccessFile raf = new RandomAccessFile(file, "rw")) {
+            raf.setLength(16 << 20);
+        }
+        MessageDigest md = MessageDigest.getInstance("SHA-256", "Mozilla-JSS");
+
+        try (FileChannel channel = FileChannel.open(file.toPath(),
+                StandardOpenOption.READ)) {
+            MappedByteBuffer mapped = channel.map(
+                FileChannel.MapMode.READ_ONLY, 0, channel.size());
+            time("SHA-256 16 MiB file, mapped ByteBuffer", () -> {
+                md.update(mapped.duplicate());
+                md.digest();
+            });
+        }
+
+        byte[] buf = new byte[65536];
+        time("SHA-256 16 MiB file, read into byte[]", () -> {
+            try (FileInputStream in = new FileInputStream(file)) {
+                int n;
+                while ((n = in.read(buf)) > 0) {
+                    md.update(buf, 0, n);
+                }
+            }
+            md.digest();
+        });
+        file.delete();
+
+        time("SHA-256 1024 single-byte updates", () -> {
+            for (int i = 0; i < 1024; i++) {
+                md.update((byte) i);
+            }
+            md.digest();
+        });
+    }
+
+    /*
+     * Hashes and authenticates 256-byte messages one at a time, through
+     * the JCA and through the one-shot calls that skip the digest
+     * context.
+     */
+    static void oneShotDigest() throws Exception {
+        byte[] data = new byte[256];
+        MessageDigest md = MessageDigest.getInstance("SHA-256", "Mozilla-JSS");
+
+        time("SHA-256 256 bytes, MessageDigest", () -> md.digest(data));
+        time("SHA-256 256 bytes, JSSMessageDigest.digest", () ->
+            JSSMessageDigest.digest(DigestAlgorithm.SHA256, data));
+
+        SecretKeyFacade sk = hmacKey();
+        Mac mac = Mac.getInstance("HmacSHA256", "Mozilla-JSS");
+        mac.init(sk);
+
+        time("HMAC-SHA256 256 bytes, Mac", () -> mac.doFinal(data));
+        time("HMAC-SHA256 256 bytes, JSSMessageDigest.hmac", () ->
+            JSSMessageDigest.hmac(sk.key, HMACAlgorithm.SHA256, data));
+    }
+
+    static SecretKeyFacade hmacKey() throws Exception {
+        SecretKeyFactory keyFac = SecretKeyFactory.getInstance(
+            "PBEWithSHA1AndDES3", "Mozilla-JSS");
+        return (SecretKeyFacade) keyFac.generateSecret(
+            new PBEKeySpec("password".toCharArray(), new byte[8], 1));
+    }
+
+    /*
+     * Draws 16-byte nonces from 8 threads at once, straight from the
+     * token and through the per-thread pools.
+     */
+    static void random() throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(8);
+        try {
+            for (String alg : new String[] {"pkcs11prng", "pkcs11prng-pooled"}) {
+                SecureRandom rng = SecureRandom.getInstance(alg, "Mozilla-JSS");
+                List<Callable<Void>> tasks = new ArrayList<>();
+                for (int t = 0; t < 8; t++) {
+                    tasks.add(() -> {
+                        byte[] nonce = new byte[16];
+                        for (int i = 0; i < 1000; i++) {
+                            rng.nextBytes(nonce);
+                        }
+                        return null;
+                    });
+                }
+                time("SecureRandom " + alg + ", 8 threads x 1000 x 16 bytes",
+                    () -> {
+                        for (Future<Void> f : pool.invokeAll(tasks)) {
+                            f.get();
+                        }
+                    });
+            }
+        } finally {
+            pool.shutdown();
+        }
+    }
+
+    /*
+     * Signs 100 messages of 256 bytes each, one signing context at a
+     * time and as a batch.
+     */
+    static void batchSign(CryptoToken tok) throws Exception {
+        KeyPairGenerator rsa = tok.getKeyPairGenerator(KeyPairAlgorithm.RSA);
+        rsa.initialize(2048);
+        batchSign(tok, "RSA-2048", rsa.genKeyPair(),
+            SignatureAlgorithm.RSASignatureWithSHA256Digest);
+
+        KeyPairGenerator ec = tok.getKeyPairGenerator(KeyPairAlgorithm.EC);
+        ec.initialize(256);
+        batchSign(tok, "P-256", ec.genKeyPair(),
+            SignatureAlgorithm.ECSignatureWithSHA256Digest);
+    }
+
+    static void batchSign(CryptoToken tok, String name, KeyPair keyPair,
+                          SignatureAlgorithm alg)
+        throws Exception
+    {
+        PrivateKey key = (PrivateKey) keyPair.getPrivate();
+        byte[] data = new byte[256];
+        List<ByteBuffer> messages = new ArrayList<>();
+        for (int i = 0; i < 100; i++) {
+            messages.add(ByteBuffer.wrap(data));
+        }
+
+        Signature signer = tok.getSignatureContext(alg);
+        time(name + " sign 100 x 256 bytes, one at a time", () -> {
+            for (int i = 0; i < 100; i++) {
+                signer.initSign(key);
+                signer.update(data);
+                signer.sign();
+            }
+        });
+
+        byte[] out = new byte[signer.getMaxSignatureLength() * 100];
+        int[] sigLengths = new int[100];
+        signer.initSign(key);
+        time(name + " sign 100 x 256 bytes, signAll", () -> {
+            for (ByteBuffer m : messages) {
+                m.rewind();
+            }
+            signer.signAll(messages, out, 0, sigLengths);
+        });
+    }
+
+    /*
+     * Verifies 200 RSA-2048 signatures given by SPKI, one after another
+     * on this thread and through a BatchVerifier on every processor.
+     */
+    static void batchVerify(CryptoToken tok) throws Exception {
+        KeyPairGenerator rsa = tok.getKeyPairGenerator(KeyPairAlgorithm.RSA);
+        rsa.initialize(2048);
+        KeyPair keyPair = rsa.genKeyPair();
+        SignatureAlgorithm alg =
+            SignatureAlgorithm.RSASignatureWithSHA256Digest;
+        byte[] spki = keyPair.getPublic().getEncoded();
+
+        Signature signer = tok.getSignatureContext(alg);
+        signer.initSign((PrivateKey) keyPair.getPrivate());
+        List<BatchVerifier.Item> items = new ArrayList<>();
+        for (int i = 0; i < 200; i++) {
+            byte[] data = new byte[256];
+            data[0] = (byte) i;
+            signer.update(data);
+            items.add(new BatchVerifier.Item(spki, alg, data, signer.sign()));
+            signer.initSign((PrivateKey) keyPair.getPrivate());
+        }
+
+        try (BatchVerifier sequential = new BatchVerifier(tok, 1)) {
+            time("RSA-2048 verify 200 by SPKI, 1 thread", () ->
+                sequential.verify(items));
+        }
+        int threads = Runtime.getRuntime().availableProcessors();
+        try (BatchVerifier parallel = new BatchVerifier(tok, threads)) {
+            time("RSA-2048 verify 200 by SPKI, " + threads + " threads", () ->
+                parallel.verify(items));
+        }
+    }
+
+    /*
+     * Creates, initializes and uses a short-lived HMAC or cipher context
+     * for each 64-byte message, so the time goes into looking up the
+     * algorithm's mechanism and setting up the context.
+     */
+    static void contextInit(CryptoToken tok) throws Exception {
+        byte[] data = new byte[64];
+        SymmetricKey hmacKey = hmacKey().key;
+        time("HMAC-SHA256 64 bytes, new context each", () -> {
+            JSSMessageDigest md = tok.getDigestContext(HMACAlgorithm.SHA256);
+            md.initHMAC(hmacKey);
+            md.update(data, 0, data.length);
+            md.digest();
+        });
+
+        KeyGenerator kg = tok.getKeyGenerator(KeyGenAlgorithm.AES);
+        kg.initialize(128);
+        SymmetricKey aesKey = kg.generate();
+        IVParameterSpec iv = new IVParameterSpec(new byte[16]);
+        time("AES-128-CBC 64 bytes, new context each", () -> {
+            Cipher cipher = tok.getCipherContext(
+                EncryptionAlgorithm.AES_128_CBC_PAD);
+            cipher.initEncrypt(aesKey, iv);
+            cipher.doFinal(data);
+        });
+    }
+
+    /*
+     * Seals 1 KiB records with AES-GCM from heap and from direct buffers.
+     * The JCA provider has no GCM, so AES-CBC through javax.crypto.Cipher
+     * stands in for the JCA path.
+     */
+    static void aead(CryptoToken tok) throws Exception {
+        KeyGenerator kg = tok.getKeyGenerator(KeyGenAlgorithm.AES);
+        kg.initialize(128);
+        SymmetricKey key = kg.generate();
+        AeadCipher aead = AeadCipher.AES_GCM;
+        int tagLen = aead.getTagLength();
+        byte[] nonce = new byte[12];
+        byte[] aad = new byte[13];
+
+        ByteBuffer heapIn = ByteBuffer.allocate(1024);
+        ByteBuffer heapOut = ByteBuffer.allocate(1024 + tagLen);
+        ByteBuffer directIn = ByteBuffer.allocateDirect(1024);
+        ByteBuffer directOut = ByteBuffer.allocateDirect(1024 + tagLen);
+
+        // never reuse a nonce, even here
+        time("AES-GCM seal 1 KiB, heap buffers", () -> {
+            nextNonce(nonce);
+            heapIn.clear();
+            heapOut.clear();
+            aead.seal(key, nonce, aad, heapIn, heapOut);
+        });
+        time("AES-GCM seal 1 KiB, direct buffers", () -> {
+            nextNonce(nonce);
+            directIn.clear();
+            directOut.clear();
+            aead.seal(key, nonce, aad, directIn, directOut);
+        });
+
+        javax.crypto.Cipher cbc = javax.crypto.Cipher.getInstance(
+            "AES/CBC/PKCS5Padding", "Mozilla-JSS");
+        SecretKeyFacade sk = new SecretKeyFacade(key);
+        IvParameterSpec iv = new IvParameterSpec(new byte[16]);
+        byte[] plaintext = new byte[1024];
+        time("AES-CBC encrypt 1 KiB, javax.crypto.Cipher", () -> {
+            cbc.init(javax.crypto.Cipher.ENCRYPT_MODE, sk, iv);
+            cbc.doFinal(plaintext);
+        });
+    }
+
+    static void nextNonce(byte[] nonce) {
+        int i = nonce.length - 1;
+        while (i >= 0 && ++nonce[i] == 0) {
+            i--;
+        }
+    }
+
+    /*
+     * Encrypts 1000 records of 4 KiB with AES-128-CBC, each IV different,
+     * through one Cipher re-initialized per record and through a
+     * BulkCipher on every processor.
+     */
+    static void bulkCipher(CryptoToken tok) throws Exception {
+        KeyGenerator kg = tok.getKeyGenerator(KeyGenAlgorithm.AES);
+        kg.initialize(128);
+        SymmetricKey key = kg.generate();
+        EncryptionAlgorithm alg = EncryptionAlgorithm.AES_128_CBC_PAD;
+        byte[][] ivs = new byte[1000][];
+        byte[] record = new byte[4096];
+        for (int i = 0; i < ivs.length; i++) {
+            ivs[i] = new byte[16];
+            ivs[i][0] = (byte) i;
+            ivs[i][1] = (byte) (i >> 8);
+        }
+
+        Cipher cipher = tok.getCipherContext(alg);
+        time("AES-128-CBC 1000 x 4 KiB, Cipher per record", () -> {
+            for (byte[] iv : ivs) {
+                cipher.initEncrypt(key, new IVParameterSpec(iv));
+                cipher.doFinal(record);
+            }
+        });
+
+        int threads = Runtime.getRuntime().availableProcessors();
+        try (BulkCipher bulk = new BulkCipher(key, alg, true, threads, 64,
+                1024)) {
+            List<CompletableFuture<byte[]>> results = new ArrayList<>();
+            time("AES-128-CBC 1000 x 4 KiB, BulkCipher " + threads +
+                    " threads", () -> {
+                results.clear();
+                for (byte[] iv : ivs) {
+                    results.add(bulk.submit(iv, record));
+                }
+                for (CompletableFuture<byte[]> result : results) {
+                    result.get();
+                }
+            });
+            System.out.println(String.format("%-48s %12.1f MB/s",
+                    "  BulkCipher counters", bulk.getMegabytesPerSecond()));
+        }
+    }
+
+    /*
+     * Encodes a SEQUENCE nested 16 deep around a 64 KiB OCTET STRING,
+     * which the streaming encoder writes without copying it per level.
+     */
+    static void nestedEncode() throws Exception {
+        SEQUENCE nested = new SEQUENCE();
+        nested.addElement(new OCTET_STRING(new byte[65536]));
+        for (int i = 0; i < 16; i++) {
+            SEQUENCE outer = new SEQUENCE();
+            outer.addElement(new INTEGER(i));
+            outer.addElement(nested);
+            nested = outer;
+        }
+        SEQUENCE deep = nested;
+
+        time("DER encode SEQUENCE 16 deep, 64 KiB", () ->
+            ASN1Util.encode(deep));
+    }
+
+    /*
+     * Encodes SET OFs of 10000 and 100000 INTEGERs given in reverse
+     * order, so DER has to sort every element.
+     */
+    static void setOfEncode() throws Exception {
+        for (int n : new int[] {10000, 100000}) {
+            SET set = new SET();
+            for (int i = 0; i < n; i++) {
+                set.addElement(new INTEGER(n - i));
+            }
+            time("DER encode SET OF " + n + " INTEGERs", () ->
+                ASN1Util.encode(set));
+        }
+    }
+
+    /*
+     * Decodes a certificate and a ContentInfo holding 4 MiB of data, from
+     * a byte[] through an InputStream and as views over a ByteBuffer.
+     */
+    static void sliceDecode(CryptoManager cm) throws Exception {
+        byte[] cert = cm.findCertByNickname("Server_RSA").getEncoded();
+        sliceDecode("certificate", Certificate.getTemplate(), cert);
+
+        byte[] cms = ASN1Util.encode(new ContentInfo(new byte[4 << 20]));
+        sliceDecode("ContentInfo 4 MiB", ContentInfo.getTemplate(), cms);
+    }
+
+    static void sliceDecode(String name, ASN1Template template, byte[] der)
+        throws Exception
+    {
+        time("BER decode " + name + ", byte[]", () ->
+            ASN1Util.decode(template, der));
+        time("BER decode " + name + ", ByteBuffer slice", () ->
+            ASN1Util.decode(template, ByteBuffer.wrap(der)));
+    }
+
+    /*
+     * Opens CRLs of 100000 and 1000000 entries decoded and indexed, and
+     * reports the heap each keeps and how fast each answers isRevoked.
+     */
+    static void crl() throws Exception {
+        java.security.KeyPairGenerator generator =
+            java.security.KeyPairGenerator.getInstance("RSA", "Mozilla-JSS");
+        generator.initialize(2048);
+        KeyPair keyPair = generator.generateKeyPair();
+        Date now = new Date();
+
+        for (int n : new int[] {100000, 1000000}) {
+            Iterable<RevokedCertificate> entries = () ->
+                IntStream.range(0, n).mapToObj(i -> (RevokedCertificate)
+                    new RevokedCertImpl(BigInteger.valueOf(3L * i), now))
+                .iterator();
+            X509CRLWriter writer = new X509CRLWriter(
+                new X500Name("CN=Bench CRL"), now,
+                new Date(now.getTime() + 86400000L), entries, null);
+            ByteArrayOutputStream out = new ByteArrayOutputStream();
+            writer.sign(keyPair.getPrivate(), "SHA256withRSA", "Mozilla-JSS",
+                out);
+            byte[] der = out.toByteArray();
+
+            crlCase("CRL " + n + " entries, decoded", n, () ->
+                new X509CRLImpl(der));
+            crlCase("CRL " + n + " entries, indexed", n, () ->
+                new X509CRLImpl(der, true, true));
+        }
+    }
+
+    interface CRLSource {
+        X509CRLImpl open() throws Exception;
+    }
+
+    static void crlCase(String name, int n, CRLSource source)
+        throws Exception
+    {
+        long before = usedHeap();
+        X509CRLImpl crl = source.open();
+        long after = usedHeap();
+        System.out.println(String.format("%-48s %12.1f MiB",
+                name + ", heap", (after - before) / 1048576.0));
+
+        time(name + ", open", () -> source.open());
+
+        int[] next = {0};
+        time(name + ", isRevoked", () -> {
+            int i = next[0]++ % (3 * n);
+            crl.isRevoked(BigInteger.valueOf(i));
+        });
+    }
+
+    static long usedHeap() {
+        Runtime rt = Runtime.getRuntime();
+        for (int i = 0; i < 3; i++) {
+            System.gc();
+        }
+        return rt.totalMemory() - rt.freeMemory();
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length != 4) {
+            System.out.println("Usage: java org.mozilla.jss.tests." +
+                    "JSSBenchmark <dbdir> <passwordFile> <port>" +
+                    " <milliseconds>");
+            System.exit(1);
+        }
+
+        CryptoManager.initialize(args[0]);
+        CryptoManager cm = CryptoManager.getInstance();
+        CryptoToken tok = cm.getInternalKeyStorageToken();
+        tok.login(new FilePasswordCallback(args[1]));
+        int port = Integer.parseInt(args[2]);
+        millis = Long.parseLong(args[3]);
+
+        sslSocket(port);
+        mappedDigest();
+        oneShotDigest();
+        random();
+        batchSign(tok);
+        batchVerify(tok);
+        contextInit(tok);
+        aead(tok);
+        bulkCipher(tok);
+        nestedEncode();
+        setOfEncode();
+        sliceDecode(cm);
+        crl();
+    }
+}
@@ -0,0 +1,153 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+package org.mozilla.jss.tests;
+
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+
+import javax.net.ssl.SSLEngine;
+import javax.net.ssl.SSLEngineResult;
+import javax.net.ssl.SSLEngineResult.HandshakeStatus;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.ssl.JSSEngine;
+import org.mozilla.jss.ssl.SSLServerSocket;
+
+/**
+ * Runs a handshake and an application data exchange between a client and
+ * a server JSSEngine connected back to back in memory.
+ */
+public class JSSEngineTest {
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 3) {
+            System.out.println("Usage: java org.mozilla.jss.tests." +
+                    "JSSEngineTest <dbdir> <passwordFile> <server cert nickname>");
+            System.exit(1);
+        }
+
+        CryptoManager.initialize(args[0]);
+        CryptoManager cm = CryptoManager.getInstance();
+        CryptoToken tok = cm.getInternalKeyStorageToken();
+        tok.login(new FilePasswordCallback(args[1]));
+
+        SSLServerSocket.configServerSessionIDCache(10, 100, 100, null);
+
+        JSSEngine server = new JSSEngine();
+        server.setUseClientMode(false);
+        server.setServerCertNickname(args[2]);
+
+        JSSEngine client = new JSSEngine("localhost", 443,
+                (cert, status) -> true, null);
+        client.setUseClientMode(true);
+
+        int packetSize = client.getSession().getPacketBufferSize();
+        int appSize = client.getSession().getApplicationBufferSize();
+        ByteBuffer clientToServer = ByteBuffer.allocateDirect(packetSize);
+        ByteBuffer serverToClient = ByteBuffer.allocate(packetSize);
+        ByteBuffer clientIn = ByteBuffer.allocate(appSize);
+        ByteBuffer serverIn = ByteBuffer.allocateDirect(appSize);
+        ByteBuffer empty = ByteBuffer.allocate(0);
+
+        client.beginHandshake();
+        server.beginHandshake();
+
+        for (int i = 0; i < 100 && !(done(client) && done(server)); i++) {
+            step(client, empty, clientToServer, serverToClient, clientIn);
+            step(server, empty, serverToClient, clientToServer, serverIn);
+        }
+        if (!done(client) || !done(server)) {
+            throw new Exception("Handshake did not complete");
+        }
+        System.out.println("Negotiated " + client.getSession().getProtocol()
+                + " with " + client.getSession().getCipherSuite());
+        if (!client.getSession().getCipherSuite().equals(
+                server.getSession().getCipherSuite())) {
+            throw new Exception("Client and server disagree on cipher suite");
+        }
+
+        byte[] message = new byte[40000];
+        for (int i = 0; i < message.length; i++) {
+            message[i] = (byte) i;
+        }
+        byte[] received = transfer(client, server, message,
+                clientToServer, serverIn);
+        if (!Arrays.equals(message, received)) {
+            throw new Exception("Server received corrupted data");
+        }
+        received = transfer(server, client, message, serverToClient, clientIn);
+        if (!Arrays.equals(message, received)) {
+            throw new Exception("Client received corrupted data");
+        }
+
+        client.closeOutbound();
+        clientToServer.clear();
+        SSLEngineResult result = client.wrap(empty, clientToServer);
+        if (result.getStatus() != SSLEngineResult.Status.CLOSED) {
+            throw new Exception("Expected CLOSED after closeOutbound: " + result);
+        }
+        clientToServer.flip();
+        serverIn.clear();
+        result = server.unwrap(clientToServer, serverIn);
+        if (result.getStatus() != SSLEngineResult.Status.CLOSED
+                || !server.isInboundDone()) {
+            throw new Exception("Server did not see close_notify: " + result);
+        }
+
+        System.out.println("JSSEngineTest passed");
+    }
+
+    private static boolean done(SSLEngine engine) {
+        return engine.getHandshakeStatus() == HandshakeStatus.NOT_HANDSHAKING;
+    }
+
+    /**
+     * Lets the engine consume whatever the peer sent and then produce
+     * whatever it wants to send.
+     */
+    private static void step(SSLEngine engine, ByteBuffer empty,
+        ByteBuffer out, ByteBuffer in, ByteBuffer app) throws Exception
+    {
+        in.flip();
+        while (in.hasRemaining()) {
+            SSLEngineResult r = engine.unwrap(in, app);
+            if (r.getStatus() != SSLEngineResult.Status.OK
+                    || r.bytesConsumed() == 0) {
+                break;
+            }
+        }
+        in.compact();
+
+        while (engine.getHandshakeStatus() == HandshakeStatus.NEED_WRAP) {
+            SSLEngineResult r = engine.wrap(empty, out);
+            if (r.getStatus() != SSLEngineResult.Status.OK) {
+                throw new Exception("Unexpected wrap result: " + r);
+            }
+        }
+    }
+
+    private static byte[] transfer(SSLEngine from, SSLEngine to,
+        byte[] message, ByteBuffer net, ByteBuffer app) throws Exception
+    {
+        ByteBuffer src = ByteBuffer.wrap(message).asReadOnlyBuffer();
+        ByteBuffer received = ByteBuffer.allocate(message.length);
+
+        while (src.hasRemaining() || received.hasRemaining()) {
+            net.clear();
+            from.wrap(src, net);
+            net.flip();
+            while (net.hasRemaining()) {
+                app.clear();
+                SSLEngineResult r = to.unwrap(net, app);
+                app.flip();
+                received.put(app);
+                if (r.getStatus() != SSLEngineResult.Status.OK) {
+                    throw new Exception("Unexpected unwrap result: " + r);
+                }
+            }
+        }
+        return received.array();
+    }
+}
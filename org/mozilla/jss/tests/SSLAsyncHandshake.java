@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+package org.mozilla.jss.tests;
+
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.ssl.SSLHandshakeCompletedEvent;
+import org.mozilla.jss.ssl.SSLHandshakeCompletedListener;
+import org.mozilla.jss.ssl.SSLServerSocket;
+import org.mozilla.jss.ssl.SSLSocket;
+import org.mozilla.jss.util.PasswordCallback;
+
+/**
+ * Runs both ends of a client-authenticated handshake asynchronously:
+ * the server through SSLServerSocket.setHandshakeExecutor, the client
+ * through SSLSocket.startHandshakeAsync.
+ */
+public class SSLAsyncHandshake {
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 5) {
+            System.out.println("Usage: java org.mozilla.jss.tests." +
+                    "SSLAsyncHandshake <dbdir> <passwordFile> <port>" +
+                    " <server cert nickname> <client cert nickname>");
+            System.exit(1);
+        }
+
+        CryptoManager.initialize(args[0]);
+        CryptoManager cm = CryptoManager.getInstance();
+        CryptoToken tok = cm.getInternalKeyStorageToken();
+        PasswordCallback cb = new FilePasswordCallback(args[1]);
+        tok.login(cb);
+
+        int port = Integer.parseInt(args[2]);
+        String serverCertNick = args[3];
+        String clientCertNick = args[4];
+
+        SSLSocket.enableSSL2Default(false);
+        SSLSocket.enableSSL3Default(false);
+        SSLServerSocket.configServerSessionIDCache(10, 100, 100, null);
+
+        ExecutorService handshakes = Executors.newFixedThreadPool(2);
+        SSLServerSocket serverSock = new SSLServerSocket(port, 5, null, null,
+                true);
+        serverSock.requireClientAuth(SSLSocket.SSL_REQUIRE_NO_ERROR);
+        serverSock.setServerCertNickname(serverCertNick);
+        serverSock.setHandshakeExecutor(handshakes);
+
+        CompletableFuture<SSLHandshakeCompletedEvent> serverFuture =
+            CompletableFuture.supplyAsync(() -> {
+                try {
+                    // accept() starts the handshake on the executor, so
+                    // the future is the only reliable way to see it end
+                    SSLSocket sock = (SSLSocket) serverSock.accept();
+                    SSLHandshakeCompletedEvent event =
+                        sock.getHandshakeFuture().get(60, TimeUnit.SECONDS);
+                    InputStream is = sock.getInputStream();
+                    if (is.read() != 42) {
+                        throw new Exception("Server read the wrong byte");
+                    }
+                    sock.close();
+                    return event;
+                } catch (Exception e) {
+                    throw new RuntimeException(e);
+                }
+            });
+
+        SSLSocket sock = new SSLSocket("localhost", port);
+        sock.setClientCertNickname(clientCertNick);
+
+        // register the listener before the handshake can start
+        CountDownLatch listenerCalled = new CountDownLatch(1);
+        sock.addHandshakeCompletedListener(
+            new SSLHandshakeCompletedListener() {
+                public void handshakeCompleted(SSLHandshakeCompletedEvent e) {
+                    listenerCalled.countDown();
+                }
+            });
+
+        SSLHandshakeCompletedEvent clientEvent =
+            sock.startHandshakeAsync(handshakes).get(60, TimeUnit.SECONDS);
+        if (!clientEvent.getStatus().isSecurityOn()) {
+            throw new Exception("Client handshake completed without security");
+        }
+        if (!listenerCalled.await(60, TimeUnit.SECONDS)) {
+            throw new Exception("Client handshake listener was not called");
+        }
+        if (sock.getHandshakeFuture() == null ||
+                !sock.getHandshakeFuture().isDone()) {
+            throw new Exception("Client handshake future is not done");
+        }
+        System.out.println("client handshake completed. ciphersuite: " +
+                sock.getStatus().getCipher());
+
+        OutputStream os = sock.getOutputStream();
+        os.write(42);
+        os.flush();
+
+        SSLHandshakeCompletedEvent serverEvent =
+            serverFuture.get(60, TimeUnit.SECONDS);
+        if (!serverEvent.getStatus().isSecurityOn()) {
+            throw new Exception("Server handshake completed without security");
+        }
+        System.out.println("server handshake completed");
+
+        sock.close();
+        serverSock.close();
+        handshakes.shutdown();
+        System.out.println("SSLAsyncHandshake passed");
+    }
+}
@@ -0,0 +1,133 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+package org.mozilla.jss.tests;
+
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.SocketException;
+import java.nio.ByteBuffer;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.TimeUnit;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.ssl.SSLServerSocket;
+import org.mozilla.jss.ssl.SSLSocket;
+import org.mozilla.jss.util.PasswordCallback;
+
+/**
+ * Reads through SSLSocket's native read buffer with small reads, mixing
+ * byte arrays and direct buffers, and checks available() and zero-length
+ * reads along the way.
+ */
+public class SSLReadBuffer {
+
+    static final int TOTAL = 20000;
+    static final int BUFFER_SIZE = 4096;
+
+    static void check(boolean expr, String what) throws Exception {
+        if (!expr) {
+            throw new Exception("SSLReadBuffer: " + what);
+        }
+    }
+
+    static void serve(SSLSocket sock) throws Exception {
+        sock.setNativeReadBufferSize(BUFFER_SIZE);
+        check(sock.getNativeReadBufferSize() == BUFFER_SIZE,
+            "buffer size not set");
+
+        InputStream is = sock.getInputStream();
+        byte[] b = new byte[8];
+
+        // zero-length reads return at once, even with nothing buffered
+        check(is.read(b, 0, 0) == 0, "empty read of an empty buffer");
+        check(sock.read(ByteBuffer.allocateDirect(0)) == 0,
+            "empty direct read of an empty buffer");
+
+        int first = is.read();
+        check(first == 0, "first byte is " + first);
+        int received = 1;
+
+        // the rest of the first record is now buffered
+        int available = is.available();
+        check(available > 0 && available <= TOTAL - received,
+            "available() is " + available);
+        try {
+            sock.setNativeReadBufferSize(1);
+            throw new Exception("buffer shrank below its unread data");
+        } catch (SocketException e) {
+            // expected
+        }
+        check(is.read(b, 0, 0) == 0, "empty read of a full buffer");
+        check(is.available() == available, "empty read consumed data");
+
+        ByteBuffer direct = ByteBuffer.allocateDirect(8);
+        for (int n = 1; received < TOTAL; n = n % 7 + 1) {
+            int nread;
+            if (n % 2 == 0) {
+                direct.clear().limit(n);
+                nread = sock.read(direct);
+                direct.flip();
+                direct.get(b, 0, direct.remaining());
+            } else {
+                nread = is.read(b, 0, n);
+            }
+            check(nread > 0 && nread <= n, "read " + nread + " of " + n);
+            for (int i = 0; i < nread; i++, received++) {
+                check(b[i] == (byte) received, "wrong byte at " + received);
+            }
+        }
+
+        check(is.read() == -1, "no end of stream");
+        sock.close();
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 4) {
+            System.out.println("Usage: java org.mozilla.jss.tests." +
+                    "SSLReadBuffer <dbdir> <passwordFile> <port>" +
+                    " <server cert nickname>");
+            System.exit(1);
+        }
+
+        CryptoManager.initialize(args[0]);
+        CryptoManager cm = CryptoManager.getInstance();
+        CryptoToken tok = cm.getInternalKeyStorageToken();
+        PasswordCallback cb = new FilePasswordCallback(args[1]);
+        tok.login(cb);
+
+        int port = Integer.parseInt(args[2]);
+        String serverCertNick = args[3];
+
+        SSLSocket.enableSSL2Default(false);
+        SSLSocket.enableSSL3Default(false);
+        SSLServerSocket.configServerSessionIDCache(10, 100, 100, null);
+
+        SSLServerSocket serverSock = new SSLServerSocket(port, 5, null, null,
+                true);
+        serverSock.setServerCertNickname(serverCertNick);
+
+        CompletableFuture<Void> server = CompletableFuture.runAsync(() -> {
+            try {
+                serve((SSLSocket) serverSock.accept());
+            } catch (Exception e) {
+                throw new RuntimeException(e);
+            }
+        });
+
+        SSLSocket sock = new SSLSocket("localhost", port);
+        byte[] data = new byte[TOTAL];
+        for (int i = 0; i < TOTAL; i++) {
+            data[i] = (byte) i;
+        }
+        OutputStream os = sock.getOutputStream();
+        os.write(data);
+        os.flush();
+        sock.close();
+
+        server.get(60, TimeUnit.SECONDS);
+        serverSock.close();
+        System.out.println("SSLReadBuffer passed");
+    }
+}
@@ -10,12 +10,16 @@
  */
 package org.mozilla.jss.tests;
 
+import java.nio.ByteBuffer;
 import java.security.KeyPair;
 import java.security.PublicKey;
+import java.util.Arrays;
 import java.util.Enumeration;
+import java.util.List;
 
 import org.mozilla.jss.CryptoManager;
 import org.mozilla.jss.InitializationValues;
+import org.mozilla.jss.crypto.BatchVerifier;
 import org.mozilla.jss.crypto.CryptoToken;
 import org.mozilla.jss.crypto.KeyPairAlgorithm;
 import org.mozilla.jss.crypto.KeyPairGenerator;
@@ -107,6 +111,69 @@ public class SigTest {
                 throw new Exception("ERROR: Signature failed to verify.");
             }
 
+            // Batch signing: heap, direct and read-only buffers, twice
+            // over to check the context is reusable
+            signer = token.getSignatureContext(
+                    SignatureAlgorithm.RSASignatureWithSHA256Digest);
+            signer.initSign(
+                    (org.mozilla.jss.crypto.PrivateKey) keyPair.getPrivate());
+            for (int round = 0; round < 2; round++) {
+                ByteBuffer direct = ByteBuffer.allocateDirect(data.length);
+                direct.put(data).flip();
+                List<ByteBuffer> messages = Arrays.asList(
+                        ByteBuffer.wrap(data), direct,
+                        ByteBuffer.wrap(data, 2, 5).asReadOnlyBuffer());
+                byte[][] sigs = signer.signAll(messages);
+
+                Signature verifier = token.getSignatureContext(
+                        SignatureAlgorithm.RSASignatureWithSHA256Digest);
+                for (int i = 0; i < sigs.length; i++) {
+                    verifier.initVerify(keyPair.getPublic());
+                    if (i == 2) {
+                        verifier.update(data, 2, 5);
+                    } else {
+                        verifier.update(data);
+                    }
+                    if (!verifier.verify(sigs[i])) {
+                        throw new Exception("ERROR: batch signature " + i +
+                                " failed to verify.");
+                    }
+                    if (messages.get(i).hasRemaining()) {
+                        throw new Exception("ERROR: message " + i +
+                                " was not consumed.");
+                    }
+                }
+            }
+            System.out.println("Batch signatures verified successfully!");
+
+            // Parallel verification, by key and by SPKI
+            byte[] tampered = data.clone();
+            tampered[0] ^= 1;
+            byte[] spki = keyPair.getPublic().getEncoded();
+            SignatureAlgorithm md5RSA =
+                    SignatureAlgorithm.RSASignatureWithMD5Digest;
+            List<BatchVerifier.Item> items = Arrays.asList(
+                    new BatchVerifier.Item(keyPair.getPublic(), md5RSA,
+                            data, signature),
+                    new BatchVerifier.Item(spki, md5RSA, data, signature),
+                    new BatchVerifier.Item(spki, md5RSA, tampered, signature),
+                    new BatchVerifier.Item(spki, md5RSA, data, signature));
+            try (BatchVerifier verifier = new BatchVerifier(token, 3)) {
+                BatchVerifier.Result[] results = verifier.verify(items);
+                boolean[] expected = {true, true, false, true};
+                for (int i = 0; i < results.length; i++) {
+                    if (results[i].getException() != null) {
+                        throw results[i].getException();
+                    }
+                    if (results[i].isValid() != expected[i]) {
+                        throw new Exception("ERROR: batch verification of" +
+                                " item " + i + " returned " +
+                                results[i].isValid());
+                    }
+                }
+            }
+            System.out.println("Batch verification succeeded!");
+
             System.out.println("SigTest passed.");
             System.exit(0);
         } catch (Exception e) {
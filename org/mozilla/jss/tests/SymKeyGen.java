@@ -4,19 +4,24 @@
 
 package org.mozilla.jss.tests;
 
+import java.nio.ByteBuffer;
 import java.security.GeneralSecurityException;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.spec.AlgorithmParameterSpec;
 import java.util.LinkedList;
 import java.util.List;
+import java.util.concurrent.CompletableFuture;
 
+import javax.crypto.AEADBadTagException;
 import javax.crypto.spec.RC2ParameterSpec;
 
 import org.mozilla.jss.CertDatabaseException;
 import org.mozilla.jss.CryptoManager;
 import org.mozilla.jss.KeyDatabaseException;
 import org.mozilla.jss.NotInitializedException;
+import org.mozilla.jss.crypto.AeadCipher;
 import org.mozilla.jss.crypto.AlreadyInitializedException;
+import org.mozilla.jss.crypto.BulkCipher;
 import org.mozilla.jss.crypto.Cipher;
 import org.mozilla.jss.crypto.CryptoToken;
 import org.mozilla.jss.crypto.EncryptionAlgorithm;
@@ -205,6 +210,98 @@ public class SymKeyGen {
         return bStatus; // no exception was thrown.
     }
 
+    public void bulkCipherTest(SymmetricKey key, EncryptionAlgorithm eAlg)
+        throws Exception {
+        int records = 20;
+        byte[][] ivs = new byte[records][];
+        byte[][] plaintexts = new byte[records][];
+        List<CompletableFuture<byte[]>> results =
+            new LinkedList<CompletableFuture<byte[]>>();
+
+        try (BulkCipher bulk = new BulkCipher(key, eAlg, true, 2, 4, 8)) {
+            for (int i = 0; i < records; i++) {
+                ivs[i] = genIV(eAlg.getIVLength()).getIV();
+                plaintexts[i] = new byte[i * 7];
+                java.util.Arrays.fill(plaintexts[i], (byte) i);
+                results.add(bulk.submit(ivs[i], plaintexts[i]));
+            }
+            for (CompletableFuture<byte[]> result : results) {
+                result.get();
+            }
+            if (bulk.getRecordCount() != records) {
+                throw new Exception("ERROR: BulkCipher counted " +
+                    bulk.getRecordCount() + " records");
+            }
+        }
+
+        // check each record against an ordinary decryption
+        Cipher cipher = token.getCipherContext(eAlg);
+        for (int i = 0; i < records; i++) {
+            cipher.initDecrypt(key, new IVParameterSpec(ivs[i]));
+            byte[] recovered = cipher.doFinal(results.get(i).get());
+            if (!java.util.Arrays.equals(plaintexts[i], recovered)) {
+                throw new Exception("ERROR: BulkCipher record " + i +
+                    " did not decrypt");
+            }
+        }
+    }
+
+    public void aeadTest(SymmetricKey key) throws Exception {
+        AeadCipher aead = AeadCipher.AES_GCM;
+        byte[] nonce = new byte[12];
+        new PK11SecureRandom().nextBytes(nonce);
+        byte[] aad = "header".getBytes();
+        byte[] plaintext = plainText18Bytes;
+        int tagLen = aead.getTagLength();
+
+        // heap buffers
+        ByteBuffer sealed = ByteBuffer.allocate(plaintext.length + tagLen);
+        aead.seal(key, nonce, aad, ByteBuffer.wrap(plaintext), sealed);
+        sealed.flip();
+        ByteBuffer opened = ByteBuffer.allocate(plaintext.length);
+        aead.open(key, nonce, aad, sealed.duplicate(), opened);
+        if (!java.util.Arrays.equals(plaintext, opened.array())) {
+            throw new Exception("ERROR: AEAD round trip failed");
+        }
+
+        // in place in a direct buffer
+        ByteBuffer buf = ByteBuffer.allocateDirect(plaintext.length + tagLen);
+        buf.put(plaintext).flip();
+        ByteBuffer out = buf.duplicate();
+        out.limit(out.capacity());
+        aead.seal(key, nonce, aad, buf, out);
+        out.flip();
+        byte[] ciphertext = new byte[out.remaining()];
+        out.duplicate().get(ciphertext);
+        if (!java.util.Arrays.equals(ciphertext, sealed.array())) {
+            throw new Exception("ERROR: in-place AEAD output differs");
+        }
+        buf.clear();
+        aead.open(key, nonce, aad, out, buf);
+        buf.flip();
+        byte[] recovered = new byte[buf.remaining()];
+        buf.get(recovered);
+        if (!java.util.Arrays.equals(plaintext, recovered)) {
+            throw new Exception("ERROR: in-place AEAD round trip failed");
+        }
+
+        // tampering must be detected, without releasing any plaintext
+        byte[] tampered = sealed.array().clone();
+        tampered[0] ^= 1;
+        byte[] rejected = new byte[plaintext.length];
+        try {
+            aead.open(key, nonce, aad, ByteBuffer.wrap(tampered),
+                    ByteBuffer.wrap(rejected));
+            throw new Exception("ERROR: tampered AEAD message was accepted");
+        } catch (AEADBadTagException e) {
+            // expected
+        }
+        if (!java.util.Arrays.equals(new byte[plaintext.length], rejected)) {
+            throw new Exception("ERROR: rejected AEAD message was written " +
+                "to the output");
+        }
+    }
+
     private SymKeyGen( String certDbLoc) {
         try {
             CryptoManager.initialize(certDbLoc);
@@ -294,6 +391,8 @@ public class SymKeyGen {
         skg.cipherTest(key, EncryptionAlgorithm.AES_128_CBC);
         skg.cipherTest(key, EncryptionAlgorithm.AES_128_ECB);
         skg.cipherTest(key, EncryptionAlgorithm.AES_128_CBC_PAD);
+        skg.aeadTest(key);
+        skg.bulkCipherTest(key, EncryptionAlgorithm.AES_128_CBC_PAD);
         System.out.println("AES 128 key and cipher tests correct");
 
         // AES 192 key
@@ -308,6 +407,7 @@ public class SymKeyGen {
         skg.cipherTest(key, EncryptionAlgorithm.AES_256_CBC);
         skg.cipherTest(key, EncryptionAlgorithm.AES_256_ECB);
         skg.cipherTest(key, EncryptionAlgorithm.AES_256_CBC_PAD);
+        skg.aeadTest(key);
         System.out.println("AES 256 key and cipher tests correct");
 
         // RC2 Key
@@ -0,0 +1,307 @@
+package org.mozilla.jss.tests;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.math.BigInteger;
+import java.security.GeneralSecurityException;
+import java.security.KeyFactory;
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.PublicKey;
+import java.security.cert.CertificateFactory;
+import java.security.cert.X509CRL;
+import java.security.cert.X509CRLEntry;
+import java.security.spec.X509EncodedKeySpec;
+import java.util.ArrayList;
+import java.util.Date;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Random;
+import java.util.Set;
+
+import org.mozilla.jss.CryptoManager;
+import org.mozilla.jss.crypto.CryptoToken;
+import org.mozilla.jss.netscape.security.util.ObjectIdentifier;
+import org.mozilla.jss.netscape.security.x509.CRLExtensions;
+import org.mozilla.jss.netscape.security.x509.CRLReasonExtension;
+import org.mozilla.jss.netscape.security.x509.Extension;
+import org.mozilla.jss.netscape.security.x509.RevocationReason;
+import org.mozilla.jss.netscape.security.x509.RevokedCertImpl;
+import org.mozilla.jss.netscape.security.x509.RevokedCertificate;
+import org.mozilla.jss.netscape.security.x509.X500Name;
+import org.mozilla.jss.netscape.security.x509.X509CRLImpl;
+import org.mozilla.jss.netscape.security.x509.X509CRLWriter;
+
+public class X509CRLTest {
+    public static void assert_f(boolean expr, String location) {
+        if (!expr) {
+            System.err.println("Assertion: " + location);
+            throw new AssertionError(location);
+        }
+    }
+
+    static KeyPair keyPair;
+
+    public static List<RevokedCertificate> buildEntries(int count)
+        throws Exception
+    {
+        Random random = new Random(24);
+        List<RevokedCertificate> entries = new ArrayList<>();
+        Set<BigInteger> serials = new HashSet<>();
+        Date date = new Date();
+        for (int i = 0; i < count; i++) {
+            // a mix of small, large and negative serial numbers
+            BigInteger serial = new BigInteger(1 + random.nextInt(120), random);
+            if (i % 97 == 0) {
+                serial = serial.negate();
+            }
+            if (!serials.add(serial)) {
+                continue;
+            }
+            if (i % 5 == 0) {
+                CRLExtensions exts = new CRLExtensions();
+                exts.add(new CRLReasonExtension(RevocationReason.fromInt(1)));
+                entries.add(new RevokedCertImpl(serial, date, exts));
+            } else {
+                entries.add(new RevokedCertImpl(serial, date));
+            }
+        }
+        return entries;
+    }
+
+    public static byte[] buildCrl(List<RevokedCertificate> entries)
+        throws Exception
+    {
+        Date now = new Date();
+        X509CRLImpl crl = new X509CRLImpl(new X500Name("CN=Test CRL"),
+            now, new Date(now.getTime() + 86400000L),
+            entries.toArray(new RevokedCertificate[entries.size()]), null);
+        crl.sign(keyPair.getPrivate(), "SHA256withRSA");
+        return crl.getEncoded();
+    }
+
+    public static void testIndexedLookups() throws Exception {
+        List<RevokedCertificate> entries = buildEntries(5000);
+        byte[] der = buildCrl(entries);
+
+        X509CRLImpl decoded = new X509CRLImpl(der);
+        X509CRLImpl indexed = new X509CRLImpl(der, true, true);
+
+        assert_f(indexed.getNumberOfRevokedCertificates() ==
+                 decoded.getNumberOfRevokedCertificates(), "entry count");
+
+        for (RevokedCertificate entry : entries) {
+            BigInteger serial = entry.getSerialNumber();
+            assert_f(indexed.isRevoked(serial), "isRevoked " + serial);
+
+            X509CRLEntry found = indexed.getRevokedCertificate(serial);
+            assert_f(found != null, "getRevokedCertificate " + serial);
+            assert_f(found.getSerialNumber().equals(serial),
+                     "serial of " + serial);
+            assert_f(found.hasExtensions() == entry.hasExtensions(),
+                     "extensions of " + serial);
+        }
+
+        Random random = new Random(25);
+        for (int i = 0; i < 5000; i++) {
+            BigInteger serial = new BigInteger(1 + random.nextInt(120), random)
+                .add(BigInteger.ONE.shiftLeft(130));
+            assert_f(!indexed.isRevoked(serial), "not revoked " + serial);
+            assert_f(indexed.getRevokedCertificate(serial) == null,
+                     "no entry for " + serial);
+        }
+
+        Set<RevokedCertificate> all = indexed.getRevokedCertificates();
+        assert_f(all.size() == decoded.getRevokedCertificates().size(),
+                 "getRevokedCertificates");
+        assert_f(indexed.getListOfRevokedCertificates()
+                 .equals(decoded.getListOfRevokedCertificates()),
+                 "getListOfRevokedCertificates");
+    }
+
+    public static void testEmptyCrl() throws Exception {
+        byte[] der = buildCrl(new ArrayList<RevokedCertificate>());
+        X509CRLImpl indexed = new X509CRLImpl(der, true, true);
+        assert_f(indexed.getNumberOfRevokedCertificates() == 0, "empty count");
+        assert_f(!indexed.isRevoked(BigInteger.ONE), "empty isRevoked");
+        assert_f(indexed.getRevokedCertificates() == null, "empty set");
+    }
+
+    public static void checkIndexRejects(List<RevokedCertificate> entries,
+                                         String location)
+        throws Exception
+    {
+        byte[] der = writeCrl(entries, new Date(), keyPair, "SHA256withRSA");
+        try {
+            new X509CRLImpl(der, true, true);
+        } catch (GeneralSecurityException e) {
+            return;
+        }
+        throw new AssertionError(location + " was indexed");
+    }
+
+    public static void testIndexRejectsBadEntries() throws Exception {
+        Date date = new Date();
+
+        // the lookups would find only one of these
+        List<RevokedCertificate> duplicates = new ArrayList<>();
+        duplicates.add(new RevokedCertImpl(BigInteger.valueOf(7), date));
+        duplicates.add(new RevokedCertImpl(BigInteger.valueOf(8), date));
+        duplicates.add(new RevokedCertImpl(BigInteger.valueOf(7), date));
+        checkIndexRejects(duplicates, "duplicate serial numbers");
+
+        // an entry that only fails once its extensions are decoded is
+        // indexed, but lookups that decode it fail closed
+        CRLExtensions exts = new CRLExtensions();
+        exts.set("unknown", new Extension(new ObjectIdentifier("1.2.3.4"),
+            true, new byte[] {0x04, 0x02, 0x05, 0x00}));
+        List<RevokedCertificate> badExtension = new ArrayList<>();
+        badExtension.add(new RevokedCertImpl(BigInteger.valueOf(1), date));
+        badExtension.add(new RevokedCertImpl(BigInteger.valueOf(2), date,
+            exts));
+        X509CRLImpl indexed = new X509CRLImpl(writeCrl(badExtension, date,
+            keyPair, "SHA256withRSA"), true, true);
+        assert_f(indexed.getRevokedCertificate(BigInteger.ONE) != null,
+                 "good entry next to a bad one");
+        assert_f(indexed.isRevoked(BigInteger.valueOf(2)),
+                 "bad entry isRevoked");
+        try {
+            indexed.getRevokedCertificate(BigInteger.valueOf(2));
+            throw new AssertionError("unknown critical entry extension" +
+                                     " was decoded");
+        } catch (IllegalStateException e) {
+            // expected
+        }
+    }
+
+    public static byte[] writeCrl(List<RevokedCertificate> entries, Date now,
+                                  KeyPair signer, String algorithm)
+        throws Exception
+    {
+        return writeCrl(entries, now, signer, algorithm, null);
+    }
+
+    public static byte[] writeCrl(List<RevokedCertificate> entries, Date now,
+                                  KeyPair signer, String algorithm,
+                                  String provider)
+        throws Exception
+    {
+        X509CRLWriter writer = new X509CRLWriter(new X500Name("CN=Test CRL"),
+            now, new Date(now.getTime() + 86400000L), entries, null);
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        writer.sign(signer.getPrivate(), algorithm, provider, out);
+        return out.toByteArray();
+    }
+
+    public static void checkStreamedCrl(byte[] der, KeyPair signer,
+                                        List<RevokedCertificate> entries)
+        throws Exception
+    {
+        CertificateFactory cf = CertificateFactory.getInstance("X.509");
+        X509CRL crl = (X509CRL) cf.generateCRL(new ByteArrayInputStream(der));
+        crl.verify(signer.getPublic());
+
+        X509CRLImpl decoded = new X509CRLImpl(der);
+        assert_f(decoded.getNumberOfRevokedCertificates() == entries.size(),
+                 "streamed entry count");
+        for (RevokedCertificate entry : entries) {
+            assert_f(decoded.isRevoked(entry.getSerialNumber()),
+                     "streamed isRevoked " + entry.getSerialNumber());
+        }
+    }
+
+    public static void testStreamedCrl() throws Exception {
+        List<RevokedCertificate> entries = buildEntries(5000);
+        Date now = new Date();
+
+        // RSA signs while writing, using the predicted signature length.
+        // X509CRLImpl orders the entries differently, but the CRL it
+        // builds in memory must be the same size.
+        byte[] streamed = writeCrl(entries, now, keyPair, "SHA256withRSA");
+        X509CRLImpl crl = new X509CRLImpl(new X500Name("CN=Test CRL"),
+            now, new Date(now.getTime() + 86400000L),
+            entries.toArray(new RevokedCertificate[entries.size()]), null);
+        crl.sign(keyPair.getPrivate(), "SHA256withRSA");
+        assert_f(streamed.length == crl.getEncoded().length,
+                 "streamed RSA CRL length");
+        checkStreamedCrl(streamed, keyPair, entries);
+
+        // ECDSA signature lengths vary, so this signs before writing
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("EC");
+        generator.initialize(256);
+        KeyPair ecKeyPair = generator.generateKeyPair();
+        streamed = writeCrl(entries, now, ecKeyPair, "1.2.840.10045.4.3.2");
+        checkStreamedCrl(streamed, ecKeyPair, entries);
+
+        List<RevokedCertificate> none = new ArrayList<>();
+        streamed = writeCrl(none, now, ecKeyPair, "1.2.840.10045.4.3.2");
+        checkStreamedCrl(streamed, ecKeyPair, none);
+    }
+
+    /*
+     * Signs with a key on the internal token, so the writer feeds its
+     * output through a PK11Signature, and checks the signature with a
+     * software provider.
+     */
+    public static void checkTokenSignedCrl(List<RevokedCertificate> entries,
+                                           String keyType, int keySize,
+                                           String algorithm,
+                                           String softProvider)
+        throws Exception
+    {
+        KeyPairGenerator generator =
+            KeyPairGenerator.getInstance(keyType, "Mozilla-JSS");
+        generator.initialize(keySize);
+        KeyPair tokenKeyPair = generator.generateKeyPair();
+        assert_f(tokenKeyPair.getPrivate() instanceof
+                 org.mozilla.jss.crypto.PrivateKey,
+                 keyType + " key is on the token");
+
+        byte[] der = writeCrl(entries, new Date(), tokenKeyPair, algorithm,
+            "Mozilla-JSS");
+        checkStreamedCrl(der, tokenKeyPair, entries);
+
+        PublicKey softKey = KeyFactory.getInstance(keyType, softProvider)
+            .generatePublic(new X509EncodedKeySpec(
+                tokenKeyPair.getPublic().getEncoded()));
+        CertificateFactory cf = CertificateFactory.getInstance("X.509");
+        X509CRL crl = (X509CRL) cf.generateCRL(new ByteArrayInputStream(der));
+        crl.verify(softKey, softProvider);
+    }
+
+    public static void testTokenSignedCrl(String dbdir, String passwordFile)
+        throws Exception
+    {
+        CryptoManager.initialize(dbdir);
+        CryptoManager cm = CryptoManager.getInstance();
+        CryptoToken tok = cm.getInternalKeyStorageToken();
+        tok.login(new FilePasswordCallback(passwordFile));
+
+        List<RevokedCertificate> entries = buildEntries(5000);
+
+        // RSA signs while writing, ECDSA signs before writing
+        checkTokenSignedCrl(entries, "RSA", 2048, "SHA256withRSA",
+            "SunRsaSign");
+        checkTokenSignedCrl(entries, "EC", 256, "SHA256withEC", "SunEC");
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length != 2) {
+            System.out.println("Usage: java org.mozilla.jss.tests." +
+                    "X509CRLTest <dbdir> <passwordFile>");
+            System.exit(1);
+        }
+
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("RSA");
+        generator.initialize(2048);
+        keyPair = generator.generateKeyPair();
+
+        testIndexedLookups();
+        testEmptyCrl();
+        testIndexRejectsBadEntries();
+        testStreamedCrl();
+
+        // last, since it installs Mozilla-JSS as the default provider
+        testTokenSignedCrl(args[0], args[1]);
+    }
+}
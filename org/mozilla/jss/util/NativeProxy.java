@@ -5,8 +5,9 @@
 package org.mozilla.jss.util;
 
 import java.util.Enumeration;
-import java.util.Hashtable;
-import java.util.Random;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.AtomicLong;
 
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
@@ -17,24 +18,29 @@ import org.slf4j.LoggerFactory;
  * It contains some code to help make sure that native memory is getting
  * freed properly.
  *
+ * <p>A proxy can be released as soon as its owner is done with it by
+ * calling <code>close()</code>; finalization remains as a fallback for
+ * proxies that are never closed. Only close a proxy that nothing else
+ * still uses: the native structure is gone once it returns.
+ *
  * @author nicolson
  * @version $Revision$ $Date$
  */
-public abstract class NativeProxy
+public abstract class NativeProxy implements AutoCloseable
 {
     public static Logger logger = LoggerFactory.getLogger(NativeProxy.class);
 
     /**
-     * Create a NativeProxy from a byte array representing a C pointer.
+     * Create a NativeProxy from a long representing a C pointer.
      * This is the only way to create a NativeProxy, it should be called
      * from the constructor of your subclass.
      *
-     * @param pointer A byte array, created with JSS_ptrToByteArray, that
-     * contains a pointer pointing to a native data structure.  The
+     * @param pointer A long, created with JSS_ptrToLong, that holds a
+     * pointer pointing to a native data structure.  The
      * NativeProxy instance acts as a proxy for that native data structure.
      */
-    public NativeProxy(byte[] pointer) {
-		Assert._assert(pointer!=null);
+    public NativeProxy(long pointer) {
+		Assert._assert(pointer!=0);
         registryIndex = register();
         mPointer = pointer;
     }
@@ -52,15 +58,11 @@ public abstract class NativeProxy
         if( ! (obj instanceof NativeProxy) ) {
             return false;
         }
-        if( ((NativeProxy)obj).mPointer.length != mPointer.length) {
-            return false;
-        }
-        for(int i=0; i < mPointer.length; i++) {
-            if(mPointer[i] != ((NativeProxy)obj).mPointer[i]) {
-                return false;
-            }
-        }
-        return true;
+        return ((NativeProxy)obj).mPointer == mPointer;
+    }
+
+    public int hashCode() {
+        return Long.hashCode(mPointer);
     }
 
     /**
@@ -68,11 +70,38 @@ public abstract class NativeProxy
      * Subclasses of NativeProxy must define this method to clean up
      * data structures in C code that are referenced by this proxy.
      * releaseNativeResources() will usually be implemented as a native method.
-     * <p>You don't call this method; NativeProxy.finalize() calls it for you.
+     * <p>You don't call this method; NativeProxy.close() and
+     * NativeProxy.finalize() call it for you, exactly once.
      * <p>You must declare a finalize() method which calls super.finalize().
      */
     protected abstract void releaseNativeResources();
 
+    /**
+     * Releases the native resources used by this proxy now rather than
+     * when it is garbage collected. Calling it more than once, or letting
+     * the proxy be finalized afterwards, has no further effect. Native
+     * methods called on the proxy after it is closed throw
+     * IllegalStateException instead of using the freed pointer.
+     */
+    public final void close() {
+        if( mPointer == 0 || !released.compareAndSet(false, true) ) {
+            return;
+        }
+        unregister(registryIndex);
+        try {
+            releaseNativeResources();
+        } finally {
+            mPointer = 0;
+        }
+    }
+
+    /**
+     * @return true if <code>close()</code> has released this proxy.
+     */
+    public final boolean isClosed() {
+        return released.get();
+    }
+
     /**
      * Finalize this NativeProxy by releasing its native resources.
      * The finalizer calls releaseNativeResources() so you don't have to.
@@ -92,14 +121,19 @@ public abstract class NativeProxy
      */
     @Deprecated
     protected void finalize() throws Throwable {
-        unregister(registryIndex);
-        releaseNativeResources();
+        close();
     }
 
     /**
-     * Byte array containing native pointer bytes.
+     * The native pointer, or 0 once it has been released. Native code
+     * reads it through a field ID cached at library load time.
      */
-    private byte mPointer[];
+    private volatile long mPointer;
+
+    /**
+     * Set once the native resources have been released.
+     */
+    private final AtomicBoolean released = new AtomicBoolean();
 
     /**
      * <p><b>Native Proxy Registry</b>
@@ -114,26 +148,18 @@ public abstract class NativeProxy
      * releaseNativeResources() gets called.
      */
     private long registryIndex;
-    static Hashtable<Long, Long> registry;
-    static Random indexGenerator;
-
-    static {
-        registry = new Hashtable<>();
-        indexGenerator = new Random();
-    }
+    static ConcurrentHashMap<Long, Long> registry = new ConcurrentHashMap<>();
+    static AtomicLong indexGenerator = new AtomicLong();
 
     /**
-     * Register a NativeProxy instance.
+     * Register a NativeProxy instance. Indices come from a counter, so
+     * they are unique without a lookup, and the map doesn't take a
+     * global lock.
      *
      * @return The unique index of this object in the registry.
      */
-    private synchronized static long register() {
-        Long index;
-
-        // Get a unique index
-        do {
-            index = new Long(indexGenerator.nextLong());
-        } while( registry.containsKey(index) );
+    private static long register() {
+        Long index = indexGenerator.incrementAndGet();
         registry.put(index, index);
 
         return index.longValue();
@@ -145,11 +171,10 @@ public abstract class NativeProxy
      * @param index The index of this object in the registry, as returned
      * from the previous call to register().
      */
-    private synchronized static void unregister(long index) {
-        Long Lindex = new Long(index);
+    private static void unregister(long index) {
         Long element;
 
-        element = registry.remove(Lindex);
+        element = registry.remove(index);
         Assert._assert(element != null);
     }
 
@@ -157,7 +182,7 @@ public abstract class NativeProxy
      * @return A list of the indices in the registry. Each element is a Long.
      * @see NativeProxy#getRegistryIndex
      */
-    public synchronized static Enumeration<Long> getRegistryIndices() {
+    public static Enumeration<Long> getRegistryIndices() {
         return registry.keys();
     }
 
@@ -175,7 +200,7 @@ public abstract class NativeProxy
      * is called, an assertion (org.mozilla.jss.util.AssertionException)
      * is thrown.
      */
-    public synchronized static void assertRegistryEmpty() {
+    public static void assertRegistryEmpty() {
 			if(! registry.isEmpty()) {
 			    logger.warn(registry.size() + " NativeProxys are still registered.");
 			} else {
@@ -35,7 +35,7 @@ PR_BEGIN_EXTERN_C
  * CipherContextProxy
  */
 #define CIPHER_CONTEXT_PROXY_CLASS_NAME "org/mozilla/jss/pkcs11/CipherContextProxy"
-#define CIPHER_CONTEXT_PROXY_CONSTRUCTOR_SIG "([B)V"
+#define CIPHER_CONTEXT_PROXY_CONSTRUCTOR_SIG "(J)V"
 
 /*
  * Collection
@@ -44,6 +44,11 @@ PR_BEGIN_EXTERN_C
 #define COLLECTION_ADD_NAME "add"
 #define COLLECTION_ADD_SIG "(Ljava/lang/Object;)Z"
 
+/*
+ * HashSet
+ */
+#define HASH_SET_CLASS_NAME "java/util/HashSet"
+
 /*
  * InetAddress
  */
@@ -53,8 +58,10 @@ PR_BEGIN_EXTERN_C
 /*
  * InputStream
  */
+#define ISTREAM_CLASS_NAME "java/io/InputStream"
 #define ISTREAM_READ_NAME "read"
 #define ISTREAM_READ_SIG "([B)I"
+#define ISTREAM_READ_RANGE_SIG "([BII)I"
 
 /*
  * KeyPair
@@ -94,7 +101,7 @@ PR_BEGIN_EXTERN_C
  */
 #define NATIVE_PROXY_CLASS_NAME  "org/mozilla/jss/util/NativeProxy"
 #define NATIVE_PROXY_POINTER_FIELD "mPointer"
-#define NATIVE_PROXY_POINTER_SIG "[B"
+#define NATIVE_PROXY_POINTER_SIG "J"
 
 /*
  * NSSInit
@@ -106,6 +113,7 @@ PR_BEGIN_EXTERN_C
 /*
  * OutputStream
  */
+#define OSTREAM_CLASS_NAME "java/io/OutputStream"
 #define OSTREAM_WRITE_NAME "write"
 #define OSTREAM_WRITE_SIG "([BII)V"
 
@@ -132,7 +140,7 @@ PR_BEGIN_EXTERN_C
  */
 #define CERT_CLASS_NAME "org/mozilla/jss/pkcs11/PK11Cert"
 #define CERT_CONSTRUCTOR_NAME "<init>"
-#define CERT_CONSTRUCTOR_SIG "([B[BLjava/lang/String;)V"
+#define CERT_CONSTRUCTOR_SIG "(JJLjava/lang/String;)V"
 #define CERT_PROXY_FIELD "certProxy"
 #define CERT_PROXY_SIG "Lorg/mozilla/jss/pkcs11/CertProxy;"
 
@@ -165,7 +173,7 @@ PR_BEGIN_EXTERN_C
  * PK11Module
  */
 #define PK11MODULE_CLASS_NAME "org/mozilla/jss/pkcs11/PK11Module"
-#define PK11MODULE_CONSTRUCTOR_SIG "([B)V"
+#define PK11MODULE_CONSTRUCTOR_SIG "(J)V"
 #define PK11MODULE_PROXY_FIELD "moduleProxy"
 #define PK11MODULE_PROXY_SIG "Lorg/mozilla/jss/pkcs11/ModuleProxy;"
 
@@ -174,14 +182,14 @@ PR_BEGIN_EXTERN_C
  */
 #define PK11PRIVKEY_CLASS_NAME "org/mozilla/jss/pkcs11/PK11PrivKey"
 #define PK11PRIVKEY_CONSTRUCTOR_NAME "<init>"
-#define PK11PRIVKEY_CONSTRUCTOR_SIG "([B)V"
+#define PK11PRIVKEY_CONSTRUCTOR_SIG "(J)V"
 
 /*
  * PK11PubKey
  */
 #define PK11PUBKEY_CLASS_NAME "org/mozilla/jss/pkcs11/PK11PubKey"
 #define PK11PUBKEY_CONSTRUCTOR_NAME "<init>"
-#define PK11PUBKEY_CONSTRUCTOR_SIG "([B)V"
+#define PK11PUBKEY_CONSTRUCTOR_SIG "(J)V"
 
 /*
  * PK11RSAPublicKey
@@ -211,8 +219,8 @@ PR_BEGIN_EXTERN_C
  * PK11SymKey
  */
 #define PK11SYMKEY_CLASS_NAME "org/mozilla/jss/pkcs11/PK11SymKey"
-#define PK11SYMKEY_CONSTRUCTOR_SIG "([B)V"
-#define PK11SYMKEY_CONSTRUCTOR_1_SIG "([BLjava/lang/String;)V"
+#define PK11SYMKEY_CONSTRUCTOR_SIG "(J)V"
+#define PK11SYMKEY_CONSTRUCTOR_1_SIG "(JLjava/lang/String;)V"
 
 /*
  * PK11Token
@@ -221,7 +229,7 @@ PR_BEGIN_EXTERN_C
 #define PK11TOKEN_PROXY_SIG "Lorg/mozilla/jss/pkcs11/TokenProxy;"
 #define PK11TOKEN_CLASS_NAME "org/mozilla/jss/pkcs11/PK11Token"
 #define PK11TOKEN_CONSTRUCTOR_NAME "<init>"
-#define PK11TOKEN_CONSTRUCTOR_SIG "([BZZ)V"
+#define PK11TOKEN_CONSTRUCTOR_SIG "(JZZ)V"
 
 /*
  * PrivateKey.KeyType
@@ -243,11 +251,13 @@ PR_BEGIN_EXTERN_C
  */
 #define SIG_CONTEXT_PROXY_CLASS_NAME "org/mozilla/jss/pkcs11/SigContextProxy"
 #define SIG_CONTEXT_PROXY_CONSTRUCTOR_NAME "<init>"
-#define SIG_CONTEXT_PROXY_CONSTRUCTOR_SIG "([B)V"
+#define SIG_CONTEXT_PROXY_CONSTRUCTOR_SIG "(J)V"
 
 /*
  * Socket
  */
+#define SOCKET_CLASS_NAME "java/net/Socket"
+
 #define SOCKET_GET_OUTPUT_STREAM_NAME "getOutputStream"
 #define SOCKET_GET_OUTPUT_STREAM_SIG "()Ljava/io/OutputStream;"
 
@@ -289,6 +299,10 @@ PR_BEGIN_EXTERN_C
  * SSLAlertEvent
  */
 #define SSL_ALERT_EVENT_CLASS "org/mozilla/jss/ssl/SSLAlertEvent"
+#define SSL_ALERT_EVENT_CONSTRUCTOR_SIG "(Lorg/mozilla/jss/ssl/SSLSocket;)V"
+#define SSL_ALERT_EVENT_SET_LEVEL_NAME "setLevel"
+#define SSL_ALERT_EVENT_SET_DESCRIPTION_NAME "setDescription"
+#define SSL_ALERT_EVENT_SETTER_SIG "(I)V"
 
 /*
  * SSLCertificateApprovalCallback
@@ -303,6 +317,16 @@ PR_BEGIN_EXTERN_C
 #define SSL_SECURITY_STATUS_CONSTRUCTOR_NAME "<init>"
 #define SSL_SECURITY_STATUS_CONSTRUCTOR_SIG "(ILjava/lang/String;IILjava/lang/String;Ljava/lang/String;Ljava/lang/String;Lorg/mozilla/jss/crypto/X509Certificate;)V"
 
+/*
+ * JSSEngine
+ */
+#define JSSENGINE_CLASS "org/mozilla/jss/ssl/JSSEngine"
+
+/*
+ * SSLServerSocket
+ */
+#define SSLSERVERSOCKET_CLASS "org/mozilla/jss/ssl/SSLServerSocket"
+
 /*
  * SSLSocket
  */
@@ -311,6 +335,10 @@ PR_BEGIN_EXTERN_C
 #define SSLSOCKET_HANDSHAKE_NOTIFIER_NAME "notifyAllHandshakeListeners"
 #define SSLSOCKET_HANDSHAKE_NOTIFIER_SIG "()V"
 
+#define SSLSOCKET_FIRE_ALERT_RECEIVED_NAME "fireAlertReceivedEvent"
+#define SSLSOCKET_FIRE_ALERT_SENT_NAME "fireAlertSentEvent"
+#define SSLSOCKET_FIRE_ALERT_SIG "(Lorg/mozilla/jss/ssl/SSLAlertEvent;)V"
+
 #define SSLSOCKET_PROXY_FIELD "sockProxy"
 #define SSLSOCKET_PROXY_SIG "Lorg/mozilla/jss/ssl/SocketProxy;"
 
@@ -355,6 +383,7 @@ PR_BEGIN_EXTERN_C
 /*
  * Vector
  */
+#define VECTOR_CLASS_NAME "java/util/Vector"
 #define VECTOR_ADD_ELEMENT_NAME "addElement"
 #define VECTOR_ADD_ELEMENT_SIG "(Ljava/lang/Object;)V"
 
@@ -13,6 +13,8 @@
 PR_BEGIN_EXTERN_C
 
 
+#define AEAD_BAD_TAG_EXCEPTION "javax/crypto/AEADBadTagException"
+
 #define ALREADY_INITIALIZED_EXCEPTION "org/mozilla/jss/crypto/AlreadyInitializedException"
 
 #define ARRAY_INDEX_OUT_OF_BOUNDS_EXCEPTION "java/lang/ArrayIndexOutOfBoundsException"
@@ -43,6 +45,8 @@ PR_BEGIN_EXTERN_C
 
 #define ILLEGAL_BLOCK_SIZE_EXCEPTION "org/mozilla/jss/crypto/IllegalBlockSizeException"
 
+#define ILLEGAL_STATE_EXCEPTION "java/lang/IllegalStateException"
+
 #define INCORRECT_PASSWORD_EXCEPTION "org/mozilla/jss/util/IncorrectPasswordException"
 
 #define INTERRUPTED_IO_EXCEPTION "java/io/InterruptedIOException"
@@ -51,6 +55,8 @@ PR_BEGIN_EXTERN_C
 
 #define INVALID_NICKNAME_EXCEPTION "org/mozilla/jss/util/InvalidNicknameException"
 
+#define INVALID_KEY_EXCEPTION "java/security/InvalidKeyException"
+
 #define INVALID_KEY_FORMAT_EXCEPTION "org/mozilla/jss/crypto/InvalidKeyFormatException"
 
 #define INVALID_PARAMETER_EXCEPTION "java/security/InvalidParameterException"
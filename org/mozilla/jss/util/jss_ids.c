@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <jni.h>
+#include <nspr.h>
+#include "jss_ids.h"
+
+JSS_IDTable JSS_ids;
+
+static PRStatus
+initClass(JNIEnv *env, jclass *slot, const char *name)
+{
+    jclass clazz;
+
+    clazz = (*env)->FindClass(env, name);
+    if( clazz == NULL ) {
+        return PR_FAILURE;
+    }
+    *slot = (*env)->NewGlobalRef(env, clazz);
+    (*env)->DeleteLocalRef(env, clazz);
+    return (*slot == NULL) ? PR_FAILURE : PR_SUCCESS;
+}
+
+#define JSS_ID_INIT_CLASS(cls, name) \
+    if( initClass(env, &JSS_ids.cls##_class, name) != PR_SUCCESS ) { \
+        return PR_FAILURE; \
+    }
+
+#define JSS_ID_INIT_METHOD(cls, id, name, sig) \
+    JSS_ids.cls##_##id = (*env)->GetMethodID(env, JSS_ids.cls##_class, \
+        name, sig); \
+    if( JSS_ids.cls##_##id == NULL ) { \
+        return PR_FAILURE; \
+    }
+
+#define JSS_ID_INIT_STATIC_METHOD(cls, id, name, sig) \
+    JSS_ids.cls##_##id = (*env)->GetStaticMethodID(env, \
+        JSS_ids.cls##_class, name, sig); \
+    if( JSS_ids.cls##_##id == NULL ) { \
+        return PR_FAILURE; \
+    }
+
+#define JSS_ID_INIT_FIELD(cls, id, name, sig) \
+    JSS_ids.cls##_##id = (*env)->GetFieldID(env, JSS_ids.cls##_class, \
+        name, sig); \
+    if( JSS_ids.cls##_##id == NULL ) { \
+        return PR_FAILURE; \
+    }
+
+PRStatus
+JSS_initIDs(JNIEnv *env)
+{
+    JSS_ID_CLASSES(JSS_ID_INIT_CLASS)
+    JSS_ID_METHODS(JSS_ID_INIT_METHOD)
+    JSS_ID_STATIC_METHODS(JSS_ID_INIT_STATIC_METHOD)
+    JSS_ID_FIELDS(JSS_ID_INIT_FIELD)
+
+    return PR_SUCCESS;
+}
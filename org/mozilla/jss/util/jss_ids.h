@@ -0,0 +1,128 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef JSS_IDS_H
+#define JSS_IDS_H
+
+#include <jni.h>
+#include <nspr.h>
+#include "java_ids.h"
+
+PR_BEGIN_EXTERN_C
+
+/*
+** The JNI class, method and field IDs used on hot paths, looked up once
+** by JSS_initIDs when the library is loaded instead of on every call.
+**
+** Each table below lists one entry per ID, using the string constants
+** from java_ids.h. The entries expand into the members of JSS_ids and into
+** the code in jss_ids.c that fills them in, so adding an ID means adding
+** one line here. Use them through the JSS_CLASS, JSS_METHOD and JSS_FIELD
+** macros:
+**
+**  obj = (*env)->NewObject(env, JSS_CLASS(SigContextProxy),
+**      JSS_METHOD(SigContextProxy, init), ptr);
+*/
+
+/* X(name, class name) -- held as global references */
+#define JSS_ID_CLASSES(X) \
+    X(Algorithm, ALGORITHM_CLASS_NAME) \
+    X(CipherContextProxy, CIPHER_CONTEXT_PROXY_CLASS_NAME) \
+    X(Collection, COLLECTION_CLASS_NAME) \
+    X(HashSet, HASH_SET_CLASS_NAME) \
+    X(InputStream, ISTREAM_CLASS_NAME) \
+    X(JSSEngine, JSSENGINE_CLASS) \
+    X(NativeProxy, NATIVE_PROXY_CLASS_NAME) \
+    X(OutputStream, OSTREAM_CLASS_NAME) \
+    X(PK11Cert, CERT_CLASS_NAME) \
+    X(PK11PrivKey, PK11PRIVKEY_CLASS_NAME) \
+    X(PK11Signature, PK11SIGNATURE_CLASS_NAME) \
+    X(PK11SymKey, PK11SYMKEY_CLASS_NAME) \
+    X(SigContextProxy, SIG_CONTEXT_PROXY_CLASS_NAME) \
+    X(Socket, SOCKET_CLASS_NAME) \
+    X(SocketBase, SOCKET_BASE_NAME) \
+    X(SSLAlertEvent, SSL_ALERT_EVENT_CLASS) \
+    X(SSLServerSocket, SSLSERVERSOCKET_CLASS) \
+    X(SSLSocket, SSLSOCKET_CLASS) \
+    X(Vector, VECTOR_CLASS_NAME) \
+    X(X509Certificate, X509_CERT_CLASS)
+
+/* X(class, id, method name, signature) */
+#define JSS_ID_METHODS(X) \
+    X(CipherContextProxy, init, PLAIN_CONSTRUCTOR, \
+        CIPHER_CONTEXT_PROXY_CONSTRUCTOR_SIG) \
+    X(Collection, add, COLLECTION_ADD_NAME, COLLECTION_ADD_SIG) \
+    X(HashSet, init, PLAIN_CONSTRUCTOR, PLAIN_CONSTRUCTOR_SIG) \
+    X(HashSet, add, COLLECTION_ADD_NAME, COLLECTION_ADD_SIG) \
+    X(InputStream, read, ISTREAM_READ_NAME, ISTREAM_READ_RANGE_SIG) \
+    X(JSSEngine, notifyHandshake, SSLSOCKET_HANDSHAKE_NOTIFIER_NAME, \
+        SSLSOCKET_HANDSHAKE_NOTIFIER_SIG) \
+    X(OutputStream, write, OSTREAM_WRITE_NAME, OSTREAM_WRITE_SIG) \
+    X(SigContextProxy, init, SIG_CONTEXT_PROXY_CONSTRUCTOR_NAME, \
+        SIG_CONTEXT_PROXY_CONSTRUCTOR_SIG) \
+    X(Socket, getInputStream, SOCKET_GET_INPUT_STREAM_NAME, \
+        SOCKET_GET_INPUT_STREAM_SIG) \
+    X(Socket, getOutputStream, SOCKET_GET_OUTPUT_STREAM_NAME, \
+        SOCKET_GET_OUTPUT_STREAM_SIG) \
+    X(Socket, setSoTimeout, SET_SO_TIMEOUT_NAME, SET_SO_TIMEOUT_SIG) \
+    X(SSLAlertEvent, init, PLAIN_CONSTRUCTOR, \
+        SSL_ALERT_EVENT_CONSTRUCTOR_SIG) \
+    X(SSLAlertEvent, setLevel, SSL_ALERT_EVENT_SET_LEVEL_NAME, \
+        SSL_ALERT_EVENT_SETTER_SIG) \
+    X(SSLAlertEvent, setDescription, SSL_ALERT_EVENT_SET_DESCRIPTION_NAME, \
+        SSL_ALERT_EVENT_SETTER_SIG) \
+    X(SSLSocket, fireAlertReceived, SSLSOCKET_FIRE_ALERT_RECEIVED_NAME, \
+        SSLSOCKET_FIRE_ALERT_SIG) \
+    X(SSLSocket, fireAlertSent, SSLSOCKET_FIRE_ALERT_SENT_NAME, \
+        SSLSOCKET_FIRE_ALERT_SIG) \
+    X(SSLSocket, notifyHandshake, SSLSOCKET_HANDSHAKE_NOTIFIER_NAME, \
+        SSLSOCKET_HANDSHAKE_NOTIFIER_SIG) \
+    X(Vector, addElement, VECTOR_ADD_ELEMENT_NAME, VECTOR_ADD_ELEMENT_SIG)
+
+/* X(class, id, method name, signature) */
+#define JSS_ID_STATIC_METHODS(X) \
+    X(SocketBase, processExceptions, PROCESS_EXCEPTIONS_NAME, \
+        PROCESS_EXCEPTIONS_SIG) \
+    X(SocketBase, supportsIPV6, SUPPORTS_IPV6_NAME, SUPPORTS_IPV6_SIG)
+
+/* X(class, id, field name, signature) */
+#define JSS_ID_FIELDS(X) \
+    X(Algorithm, oidIndex, OID_INDEX_FIELD_NAME, OID_INDEX_FIELD_SIG) \
+    X(JSSEngine, sockProxy, SSLSOCKET_PROXY_FIELD, SSLSOCKET_PROXY_SIG) \
+    X(NativeProxy, mPointer, NATIVE_PROXY_POINTER_FIELD, \
+        NATIVE_PROXY_POINTER_SIG) \
+    X(PK11Signature, algorithm, SIG_ALGORITHM_FIELD, SIG_ALGORITHM_SIG) \
+    X(PK11Signature, key, SIG_KEY_FIELD, SIG_KEY_SIG) \
+    X(PK11Signature, sigContext, SIG_CONTEXT_PROXY_FIELD, \
+        SIG_CONTEXT_PROXY_SIG) \
+    X(SocketBase, sockProxy, SSLSOCKET_PROXY_FIELD, SSLSOCKET_PROXY_SIG) \
+    X(SSLServerSocket, sockProxy, SSLSOCKET_PROXY_FIELD, SSLSOCKET_PROXY_SIG) \
+    X(SSLSocket, sockProxy, SSLSOCKET_PROXY_FIELD, SSLSOCKET_PROXY_SIG)
+
+#define JSS_ID_DECLARE_CLASS(cls, name) jclass cls##_class;
+#define JSS_ID_DECLARE_MEMBER(cls, id, name, sig) jmethodID cls##_##id;
+#define JSS_ID_DECLARE_FIELD(cls, id, name, sig) jfieldID cls##_##id;
+
+typedef struct JSS_IDTableStr {
+    JSS_ID_CLASSES(JSS_ID_DECLARE_CLASS)
+    JSS_ID_METHODS(JSS_ID_DECLARE_MEMBER)
+    JSS_ID_STATIC_METHODS(JSS_ID_DECLARE_MEMBER)
+    JSS_ID_FIELDS(JSS_ID_DECLARE_FIELD)
+} JSS_IDTable;
+
+extern JSS_IDTable JSS_ids;
+
+#define JSS_CLASS(cls)          (JSS_ids.cls##_class)
+#define JSS_METHOD(cls, id)     (JSS_ids.cls##_##id)
+#define JSS_FIELD(cls, id)      (JSS_ids.cls##_##id)
+
+/*
+ * Fills in JSS_ids. Called once from JNI_OnLoad.
+ * Returns PR_FAILURE, with an exception pending, if any lookup fails.
+ */
+PRStatus
+JSS_initIDs(JNIEnv *env);
+
+PR_END_EXTERN_C
+
+#endif
@@ -11,6 +11,7 @@
 #include "jss_bigint.h"
 #include "jss_exceptions.h"
 #include "java_ids.h"
+#include "jss_ids.h"
 
 
 /***********************************************************************
@@ -189,59 +190,22 @@ JSS_throw(JNIEnv *env, char *throwableClassName)
 PRStatus
 JSS_getPtrFromProxy(JNIEnv *env, jobject nativeProxy, void **ptr)
 {
-#ifdef DEBUG
-    jclass nativeProxyClass;
-#endif
-	jclass proxyClass;
-    jfieldID byteArrayField;
-    jbyteArray byteArray;
-    int size;
-
     PR_ASSERT(env!=NULL && nativeProxy != NULL && ptr != NULL);
     if( nativeProxy == NULL ) {
         JSS_throw(env, NULL_POINTER_EXCEPTION);
         return PR_FAILURE;
     }
 
-	proxyClass = (*env)->GetObjectClass(env, nativeProxy);
-	PR_ASSERT(proxyClass != NULL);
-
-#ifdef DEBUG
-    nativeProxyClass = (*env)->FindClass(
-								env,
-								NATIVE_PROXY_CLASS_NAME);
-    if(nativeProxyClass == NULL) {
-        ASSERT_OUTOFMEM(env);
-        return PR_FAILURE;
-    }
-
-    /* make sure what we got was really a NativeProxy object */
-    PR_ASSERT( (*env)->IsInstanceOf(env, nativeProxy, nativeProxyClass) );
-#endif
-
-    byteArrayField = (*env)->GetFieldID(
-								env,
-								proxyClass,
-								NATIVE_PROXY_POINTER_FIELD,
-						        NATIVE_PROXY_POINTER_SIG);
-    if(byteArrayField==NULL) {
-        ASSERT_OUTOFMEM(env);
-        return PR_FAILURE;
-    }
-
-    byteArray = (jbyteArray) (*env)->GetObjectField(env, nativeProxy,
-                        byteArrayField);
-    PR_ASSERT(byteArray != NULL);
-
-    size = sizeof(*ptr);
-    PR_ASSERT((*env)->GetArrayLength(env, byteArray) == size);
-    (*env)->GetByteArrayRegion(env, byteArray, 0, size, (void*)ptr);
-    if( (*env)->ExceptionOccurred(env) ) {
-        PR_ASSERT(PR_FALSE);
+    *ptr = (void*) (PRUword)
+        (*env)->GetLongField(env, nativeProxy,
+            JSS_FIELD(NativeProxy, mPointer));
+    if( *ptr == NULL ) {
+        /* close() has already released the native structure */
+        JSS_throwMsg(env, ILLEGAL_STATE_EXCEPTION,
+            "Native proxy has been closed");
         return PR_FAILURE;
-    } else {
-        return PR_SUCCESS;
     }
+    return PR_SUCCESS;
 }
 
 /***********************************************************************
@@ -306,31 +270,15 @@ JSS_getPtrFromProxyOwner(JNIEnv *env, jobject proxyOwner, char* proxyFieldName,
 
 /***********************************************************************
 **
-** J S S _ p t r T o B y t e A r r a y
-**
-** Turn a C pointer into a Java byte array. The byte array can be passed
-** into a NativeProxy constructor.
+** J S S _ p t r T o L o n g
 **
-** Returns a byte array containing the pointer, or NULL if an exception
-** was thrown.
+** Turn a C pointer into a Java long. The long can be passed into a
+** NativeProxy constructor.
 */
-jbyteArray
-JSS_ptrToByteArray(JNIEnv *env, void *ptr)
+jlong
+JSS_ptrToLong(void *ptr)
 {
-    jbyteArray byteArray;
-
-    /* Construct byte array from the pointer */
-    byteArray = (*env)->NewByteArray(env, sizeof(ptr));
-    if(byteArray==NULL) {
-        PR_ASSERT( (*env)->ExceptionOccurred(env) != NULL);
-        return NULL;
-    }
-    (*env)->SetByteArrayRegion(env, byteArray, 0, sizeof(ptr), (jbyte*)&ptr);
-    if((*env)->ExceptionOccurred(env) != NULL) {
-        PR_ASSERT(PR_FALSE);
-        return NULL;
-    }
-    return byteArray;
+    return (jlong) (PRUword) ptr;
 }
 
 
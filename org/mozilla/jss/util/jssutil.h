@@ -157,14 +157,12 @@ JSS_getPtrFromProxyOwner(JNIEnv *env, jobject proxyOwner, char* proxyFieldName,
 	char *proxyFieldSig, void **ptr);
 
 /*
- * Turn a C pointer into a Java byte array. The byte array can be passed
- * into a NativeProxy constructor.
- *
- * Returns a byte array containing the pointer, or NULL if an exception
- * was thrown.
+ * Turn a C pointer into a Java long. The long can be passed into a
+ * NativeProxy constructor.
  */
-jbyteArray
-JSS_ptrToByteArray(JNIEnv *env, void *ptr);
+jlong
+JSS_ptrToLong(void *ptr);
+
 
 /************************************************************************
  *